@@ -0,0 +1,102 @@
+/*
+ * Binary log of model outputs and labels, so metrics can be calculated
+ * later without running the model again.
+ *
+ * Layout (host byte order, checked by the magic number):
+ *   u64 magic, u64 format version, u64 number of columns
+ *   then every row: f32 output per column, u32 label
+ *
+ * PredictionLogWriter appends rows, PredictionLog memory maps a whole
+ * log read only so rows can be scanned in parallel straight from the
+ * page cache.
+ */
+
+#pragma once
+
+#include "neural/math/tensor.h"
+#include "neural/metrics/accumulator.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace neural
+{
+
+class PredictionLogWriter
+{
+public:
+    // Truncates `a_path`, every row will have `a_numCols` outputs
+    PredictionLogWriter(const std::string& a_path, size_t a_numCols);
+
+    // Appends every row of a batch, the label is the argmax of its target row
+    void Append(const TTensorPtr& a_outputs, const TTensorPtr& a_targets);
+
+    // Appends one row of NumCols() outputs
+    void Append(const float* a_outputs, uint32_t a_label);
+
+    size_t NumCols() const;
+    size_t NumRows() const;
+
+    // Flushes what has been appended so far
+    void Flush();
+
+private:
+    std::ofstream m_stream;
+    size_t m_numCols;
+    size_t m_numRows;
+
+    void p_CheckStream(const char* a_action);
+};
+
+class PredictionLog;
+
+typedef std::shared_ptr<PredictionLog> TPredictionLogPtr;
+
+class PredictionLog
+{
+public:
+    // Maps the whole log, throws if it is missing or malformed
+    PredictionLog(const std::string& a_path);
+    ~PredictionLog();
+
+    static TPredictionLogPtr New(const std::string& a_path);
+
+    // Identifies a log and its layout
+    static const uint64_t MAGIC = 0x474c504e; // "NPLG"
+    static const uint64_t FORMAT_VERSION = 1;
+
+    size_t NumCols() const;
+    size_t NumRows() const;
+
+    // Bytes mapped, header included
+    size_t NumBytes() const;
+
+    // NumCols() outputs of row `a_row`
+    const float* Outputs(size_t a_row) const;
+    uint32_t Label(size_t a_row) const;
+
+    // Reduce rows [a_begin, a_end) to records the same way
+    // metrics::Metric::ReduceRows does
+    void ReduceRows(size_t a_begin, size_t a_end,
+        std::vector<metrics::PredictionRecord>& a_outRecords) const;
+
+private:
+    const char* m_data;
+    size_t m_numBytes;
+    size_t m_numCols;
+    size_t m_numRows;
+    // bytes from one row to the next
+    size_t m_rowStride;
+
+    static const size_t HEADER_SIZE = 3 * sizeof(uint64_t);
+
+    // mapped memory is not copyable
+    PredictionLog(const PredictionLog&);
+    PredictionLog& operator=(const PredictionLog&);
+
+    const char* p_Row(size_t a_row) const;
+};
+
+} // namespace neural
@@ -0,0 +1,82 @@
+/*
+ * Elementwise kernels over runs of floats. Each one has an AVX-512,
+ * an AVX2 and a plain loop version, the best one the CPU supports is
+ * picked the first time any of them is called. Results always go into
+ * an output the caller provides, which may be one of the inputs.
+ *
+ * Add, sub, mul, div, max and min give the same bits on every path.
+ * The vector axpy uses fused multiply-add so it can be an ulp off the
+ * plain loop, and the vector exp and log are polynomial approximations
+ * within a couple of ulp of the C library's, which the plain path uses.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace neural
+{
+
+enum class ElementwiseOp
+{
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MAX,
+    MIN
+};
+
+class Elementwise
+{
+public:
+    enum class Isa
+    {
+        SCALAR,
+        AVX2,
+        AVX512
+    };
+
+    // Widest instruction set this CPU and build support
+    static Isa BestIsa();
+
+    // Instruction set the kernels are currently using
+    static Isa ActiveIsa();
+
+    // Force a code path, ie. to compare them. Throws if this CPU
+    // or build does not support it.
+    static void SetIsa(Isa a_isa);
+
+    static const char* IsaName(Isa a_isa);
+
+    // out[i] = lhs[i] op rhs[i]
+    static void Apply(ElementwiseOp a_op, const float* a_lhs, const float* a_rhs, float* a_out, size_t a_size);
+
+    // out[i] = lhs[i] op rhs
+    static void Apply(ElementwiseOp a_op, const float* a_lhs, float a_rhs, float* a_out, size_t a_size);
+
+    // Broadcast over a row major a_rows x a_cols matrix,
+    // out[i][j] = mat[i][j] op row[j]
+    static void ApplyRow(
+        ElementwiseOp a_op, const float* a_mat, const float* a_row, float* a_out,
+        size_t a_rows, size_t a_cols);
+
+    // out[i][j] = mat[i][j] op col[i]
+    static void ApplyCol(
+        ElementwiseOp a_op, const float* a_mat, const float* a_col, float* a_out,
+        size_t a_rows, size_t a_cols);
+
+    // out[i] = in[i] * val
+    static void Scale(const float* a_in, float a_val, float* a_out, size_t a_size);
+
+    // y[i] = y[i] + (alpha * x[i])
+    static void Axpy(float a_alpha, const float* a_x, float* a_y, size_t a_size);
+
+    // out[i] = exp(in[i])
+    static void Exp(const float* a_in, float* a_out, size_t a_size);
+
+    // out[i] = log(in[i])
+    static void Log(const float* a_in, float* a_out, size_t a_size);
+};
+
+} // namespace neural
@@ -0,0 +1,339 @@
+/*
+ * Lazy elementwise expressions. Arithmetic on expr::Ref leaves does
+ * not compute anything, it builds a small tree. Assign then walks the
+ * output in blocks of BLOCK_SIZE floats, evaluating the whole tree for
+ * one block with the Elementwise kernels before moving on. Intermediate
+ * results only ever live in a block sized buffer on the stack, so each
+ * input is read once and each output written once.
+ *
+ *   expr::Assign(l_grad, (expr::Ref(a_targets) - expr::Ref(a_inputs)) * -2.0f);
+ *
+ * Leaves point at data they do not own, the tensors have to outlive
+ * the expression, which is normally a single statement. The output
+ * may be one of the leaves.
+ */
+
+#pragma once
+
+#include "neural/math/tensor.h"
+#include "neural/math/elementwise.h"
+#include "neural/math/reduction.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace neural
+{
+
+namespace expr
+{
+
+// Floats per block, small enough that every buffer stays in L1
+const size_t BLOCK_SIZE = 256;
+
+// Base of every node, E is the node itself
+template <typename E>
+class Expr
+{
+public:
+    const E& Self() const { return static_cast<const E&>(*this); }
+};
+
+// Size of an expression made only of constants, it fits any output.
+// Not 0, which is the size of a leaf over an empty tensor.
+const size_t ANY_SIZE = std::numeric_limits<size_t>::max();
+
+// Sizes of two children
+inline size_t JoinSizes(size_t a_lhs, size_t a_rhs)
+{
+    if (ANY_SIZE == a_lhs)
+    {
+        return a_rhs;
+    }
+    if (ANY_SIZE != a_rhs && a_lhs != a_rhs)
+    {
+        std::stringstream l_ss;
+        l_ss << "expr sizes must match " << a_lhs << " != " << a_rhs;
+        throw(std::runtime_error(l_ss.str()));
+    }
+    return a_lhs;
+}
+
+/*
+ * Every node has Size() and Eval(a_begin, a_length, a_scratch), which
+ * returns a pointer to its values for [a_begin, a_begin + a_length).
+ * That is either a_scratch, filled in, or the leaf's own data.
+ */
+
+// Leaf over existing floats
+class Ref : public Expr<Ref>
+{
+public:
+    Ref(const float* a_data, size_t a_size)
+        : m_data(a_data)
+        , m_size(a_size)
+    {
+    }
+
+    explicit Ref(const TTensorPtr& a_tensor)
+        : m_data(a_tensor->Data().data())
+        , m_size(a_tensor->Size())
+    {
+    }
+
+    size_t Size() const { return m_size; }
+
+    const float* Eval(size_t a_begin, size_t /*a_length*/, float* /*a_scratch*/) const
+    {
+        return m_data + a_begin;
+    }
+
+private:
+    const float* m_data;
+    size_t m_size;
+};
+
+// A float on either side of an operator
+class Constant : public Expr<Constant>
+{
+public:
+    explicit Constant(float a_val)
+        : m_val(a_val)
+    {
+    }
+
+    size_t Size() const { return ANY_SIZE; }
+    float Value() const { return m_val; }
+
+    const float* Eval(size_t /*a_begin*/, size_t a_length, float* a_scratch) const
+    {
+        std::fill(a_scratch, a_scratch + a_length, m_val);
+        return a_scratch;
+    }
+
+private:
+    float m_val;
+};
+
+// lhs op rhs, a constant on the right goes straight to the scalar kernel
+template <ElementwiseOp Op, typename R>
+inline void ApplyRhs(const float* a_lhs, const R& a_rhs, size_t a_begin, size_t a_length, float* a_out)
+{
+    float l_scratch[BLOCK_SIZE];
+    Elementwise::Apply(Op, a_lhs, a_rhs.Eval(a_begin, a_length, l_scratch), a_out, a_length);
+}
+
+template <ElementwiseOp Op>
+inline void ApplyRhs(const float* a_lhs, const Constant& a_rhs, size_t /*a_begin*/, size_t a_length, float* a_out)
+{
+    Elementwise::Apply(Op, a_lhs, a_rhs.Value(), a_out, a_length);
+}
+
+template <ElementwiseOp Op, typename L, typename R>
+class Binary : public Expr<Binary<Op, L, R> >
+{
+public:
+    Binary(const L& a_lhs, const R& a_rhs)
+        : m_lhs(a_lhs)
+        , m_rhs(a_rhs)
+        , m_size(JoinSizes(a_lhs.Size(), a_rhs.Size()))
+    {
+    }
+
+    size_t Size() const { return m_size; }
+
+    const float* Eval(size_t a_begin, size_t a_length, float* a_scratch) const
+    {
+        float l_lhsScratch[BLOCK_SIZE];
+        const float* l_lhs = m_lhs.Eval(a_begin, a_length, l_lhsScratch);
+        ApplyRhs<Op>(l_lhs, m_rhs, a_begin, a_length, a_scratch);
+        return a_scratch;
+    }
+
+private:
+    L m_lhs;
+    R m_rhs;
+    size_t m_size;
+};
+
+// Functions applied to every element of one child
+struct ExpFn
+{
+    static void Apply(const float* a_in, float* a_out, size_t a_size) { Elementwise::Exp(a_in, a_out, a_size); }
+};
+
+struct LogFn
+{
+    static void Apply(const float* a_in, float* a_out, size_t a_size) { Elementwise::Log(a_in, a_out, a_size); }
+};
+
+struct SquareFn
+{
+    static void Apply(const float* a_in, float* a_out, size_t a_size)
+    {
+        Elementwise::Apply(ElementwiseOp::MUL, a_in, a_in, a_out, a_size);
+    }
+};
+
+template <typename Fn, typename A>
+class Unary : public Expr<Unary<Fn, A> >
+{
+public:
+    explicit Unary(const A& a_arg)
+        : m_arg(a_arg)
+    {
+    }
+
+    size_t Size() const { return m_arg.Size(); }
+
+    const float* Eval(size_t a_begin, size_t a_length, float* a_scratch) const
+    {
+        float l_argScratch[BLOCK_SIZE];
+        Fn::Apply(m_arg.Eval(a_begin, a_length, l_argScratch), a_scratch, a_length);
+        return a_scratch;
+    }
+
+private:
+    A m_arg;
+};
+
+#define NEURAL_EXPR_OPERATOR(a_symbol, a_op)                                      \
+    template <typename L, typename R>                                             \
+    inline Binary<a_op, L, R> operator a_symbol(const Expr<L>& a_lhs, const Expr<R>& a_rhs) \
+    {                                                                             \
+        return Binary<a_op, L, R>(a_lhs.Self(), a_rhs.Self());                    \
+    }                                                                             \
+    template <typename L>                                                         \
+    inline Binary<a_op, L, Constant> operator a_symbol(const Expr<L>& a_lhs, float a_rhs) \
+    {                                                                             \
+        return Binary<a_op, L, Constant>(a_lhs.Self(), Constant(a_rhs));          \
+    }                                                                             \
+    template <typename R>                                                         \
+    inline Binary<a_op, Constant, R> operator a_symbol(float a_lhs, const Expr<R>& a_rhs) \
+    {                                                                             \
+        return Binary<a_op, Constant, R>(Constant(a_lhs), a_rhs.Self());          \
+    }
+
+NEURAL_EXPR_OPERATOR(+, ElementwiseOp::ADD)
+NEURAL_EXPR_OPERATOR(-, ElementwiseOp::SUB)
+NEURAL_EXPR_OPERATOR(*, ElementwiseOp::MUL)
+NEURAL_EXPR_OPERATOR(/, ElementwiseOp::DIV)
+
+#undef NEURAL_EXPR_OPERATOR
+
+template <typename L, typename R>
+inline Binary<ElementwiseOp::MAX, L, R> Max(const Expr<L>& a_lhs, const Expr<R>& a_rhs)
+{
+    return Binary<ElementwiseOp::MAX, L, R>(a_lhs.Self(), a_rhs.Self());
+}
+
+template <typename L>
+inline Binary<ElementwiseOp::MAX, L, Constant> Max(const Expr<L>& a_lhs, float a_rhs)
+{
+    return Binary<ElementwiseOp::MAX, L, Constant>(a_lhs.Self(), Constant(a_rhs));
+}
+
+template <typename L, typename R>
+inline Binary<ElementwiseOp::MIN, L, R> Min(const Expr<L>& a_lhs, const Expr<R>& a_rhs)
+{
+    return Binary<ElementwiseOp::MIN, L, R>(a_lhs.Self(), a_rhs.Self());
+}
+
+template <typename L>
+inline Binary<ElementwiseOp::MIN, L, Constant> Min(const Expr<L>& a_lhs, float a_rhs)
+{
+    return Binary<ElementwiseOp::MIN, L, Constant>(a_lhs.Self(), Constant(a_rhs));
+}
+
+template <typename A>
+inline Unary<ExpFn, A> Exp(const Expr<A>& a_arg)
+{
+    return Unary<ExpFn, A>(a_arg.Self());
+}
+
+template <typename A>
+inline Unary<LogFn, A> Log(const Expr<A>& a_arg)
+{
+    return Unary<LogFn, A>(a_arg.Self());
+}
+
+// x * x, the child is only evaluated once
+template <typename A>
+inline Unary<SquareFn, A> Square(const Expr<A>& a_arg)
+{
+    return Unary<SquareFn, A>(a_arg.Self());
+}
+
+// Runs the expression into a_size floats at a_out. An expression of
+// only constants fills all of them.
+template <typename E>
+void Assign(float* a_out, size_t a_size, const Expr<E>& a_expr)
+{
+    const E& l_expr = a_expr.Self();
+    if (l_expr.Size() != ANY_SIZE && l_expr.Size() != a_size)
+    {
+        std::stringstream l_ss;
+        l_ss << "expr::Assign expression of size " << l_expr.Size()
+             << " into output of size " << a_size;
+        throw(std::runtime_error(l_ss.str()));
+    }
+
+    size_t l_numBlocks = (a_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    // blocks are independent, only worth spreading out when there are many
+    #pragma omp parallel for if (l_numBlocks >= 64)
+    for (size_t l_block = 0; l_block < l_numBlocks; ++l_block)
+    {
+        size_t l_begin = l_block * BLOCK_SIZE;
+        size_t l_length = std::min(BLOCK_SIZE, a_size - l_begin);
+        float* l_out = a_out + l_begin;
+
+        // a bare leaf hands back its own data rather than writing ours
+        const float* l_ret = l_expr.Eval(l_begin, l_length, l_out);
+        if (l_ret != l_out)
+        {
+            std::copy(l_ret, l_ret + l_length, l_out);
+        }
+    }
+}
+
+template <typename E>
+void Assign(const TMutableTensorPtr& a_out, const Expr<E>& a_expr)
+{
+    Assign(a_out->MutableData().data(), a_out->Size(), a_expr);
+}
+
+// New tensor of a_shape holding the expression
+template <typename E>
+TMutableTensorPtr Evaluate(const TensorShape& a_shape, const Expr<E>& a_expr)
+{
+    TMutableTensorPtr l_ret = Tensor::New(a_shape);
+    Assign(l_ret, a_expr);
+    return l_ret;
+}
+
+// Sum of the expression, a block at a time, nothing is stored
+template <typename E>
+float Sum(const Expr<E>& a_expr)
+{
+    const E& l_expr = a_expr.Self();
+    if (ANY_SIZE == l_expr.Size())
+    {
+        throw(std::runtime_error("expr::Sum of only constants has no size"));
+    }
+
+    float l_scratch[BLOCK_SIZE];
+    float l_sum = 0.0;
+    for (size_t l_begin = 0; l_begin < l_expr.Size(); l_begin += BLOCK_SIZE)
+    {
+        size_t l_length = std::min(BLOCK_SIZE, l_expr.Size() - l_begin);
+        l_sum += Reduction::Sum(l_expr.Eval(l_begin, l_length, l_scratch), l_length);
+    }
+    return l_sum;
+}
+
+} // namespace expr
+
+} // namespace neural
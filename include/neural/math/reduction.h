@@ -0,0 +1,54 @@
+/*
+ * Reductions over runs of floats and over the rows or columns of a
+ * row major matrix, a whole batch in one call. They run on the same
+ * instruction set Elementwise picked, see Elementwise::SetIsa.
+ *
+ * NaNs are skipped by max and argmax and carried through by the rest.
+ * Sums are accumulated in several lanes at once, so the last bits can
+ * differ from a plain left to right loop.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace neural
+{
+
+enum class ReduceOp
+{
+    MAX,
+    SUM,
+    MEAN,
+    LOG_SUM_EXP
+};
+
+class Reduction
+{
+public:
+    // Largest value, -inf if there is none
+    static float Max(const float* a_in, size_t a_size);
+
+    // Index of the first largest value, 0 if there is none
+    static size_t ArgMax(const float* a_in, size_t a_size);
+
+    static float Sum(const float* a_in, size_t a_size);
+
+    static float Mean(const float* a_in, size_t a_size);
+
+    // log(sum(exp(in))) without overflowing, shifts by the max first
+    static float LogSumExp(const float* a_in, size_t a_size);
+
+    static float Reduce(ReduceOp a_op, const float* a_in, size_t a_size);
+
+    // One value per row of a row major a_rows x a_cols matrix,
+    // a_out holds a_rows values
+    static void Rows(ReduceOp a_op, const float* a_mat, size_t a_rows, size_t a_cols, float* a_out);
+    static void RowArgMax(const float* a_mat, size_t a_rows, size_t a_cols, size_t* a_out);
+
+    // One value per column, a_out holds a_cols values
+    static void Cols(ReduceOp a_op, const float* a_mat, size_t a_rows, size_t a_cols, float* a_out);
+    static void ColArgMax(const float* a_mat, size_t a_rows, size_t a_cols, size_t* a_out);
+};
+
+} // namespace neural
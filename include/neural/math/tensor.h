@@ -5,6 +5,9 @@
 
 #pragma once
 
+#include "neural/math/tensor_shape.h"
+#include "neural/util/memory_pool.h"
+
 #include <vector>
 #include <memory>
 #include <sstream>
@@ -15,6 +18,7 @@ namespace neural
 // We are forward declaring a Tensor so that we can use it
 // in the typedefs before the class is defined
 class Tensor;
+class TensorView;
 
 // Assume most tensors are going to be const
 typedef std::shared_ptr<const Tensor> TTensorPtr;
@@ -22,111 +26,178 @@ typedef std::shared_ptr<const Tensor> TTensorPtr;
 // explicitly call out if tensor is mutable
 typedef std::shared_ptr<Tensor> TMutableTensorPtr;
 
+// Tensor storage, 64 byte aligned and recycled through the MemoryPool
+typedef std::vector<float, StorageAllocator<float>> TTensorData;
+
 class Tensor
 {
 public:
     // Pass in a Vector to represent the size of the the tensor,
     // ie. vector({0,1,2})
-    Tensor(const std::vector<size_t>& a_shape);
+    Tensor(const TensorShape& a_shape);
 
     // Can pass in size and the data you want in the tensor
     Tensor(
-        const std::vector<size_t>& a_shape,
+        const TensorShape& a_shape,
         const std::vector<float>& a_data);
 
     // Creates new Tensor with shape
     static TMutableTensorPtr New(
-      const std::vector<size_t>& a_shape);
+      const TensorShape& a_shape);
 
     // Tensor with data
     static TMutableTensorPtr New(
-      const std::vector<size_t>& a_shape,
+      const TensorShape& a_shape,
       const std::vector<float>& a_data);
 
+    // Tensor that takes over a_data's buffer instead of copying it,
+    // a_data must hold exactly the number of elements in a_shape
+    static TMutableTensorPtr Adopt(
+      const TensorShape& a_shape,
+      TTensorData&& a_data);
+
     // Tensor filled with random floats
-    static TMutableTensorPtr Random(const std::vector<size_t>& a_shape, float a_min=0.0, float a_max=1.0);
+    static TMutableTensorPtr Random(const TensorShape& a_shape, float a_min=0.0, float a_max=1.0);
 
     // Tensor filled with all the same value
-    static TMutableTensorPtr Constant(const std::vector<size_t>& a_shape, float a_val);
+    static TMutableTensorPtr Constant(const TensorShape& a_shape, float a_val);
 
     // Tensor filled with ones
-    static TMutableTensorPtr Zeros(const std::vector<size_t>& a_shape);
+    static TMutableTensorPtr Zeros(const TensorShape& a_shape);
 
     // Tensor filled with zeros
-    static TMutableTensorPtr Ones(const std::vector<size_t>& a_shape);
+    static TMutableTensorPtr Ones(const TensorShape& a_shape);
 
     // Copies data into mutable tensor
     TMutableTensorPtr ToMutable() const;
 
+    // Mutable tensor for a temporary we are done sharing: takes it over
+    // when a_tensor holds the last reference, copies it otherwise
+    static TMutableTensorPtr ToMutable(TTensorPtr&& a_tensor);
+
     // Sets all the values in the tensor to this value
     void SetAll(float a_val);
   
     // Get the shape of tensor ie: 4x32x32x3
-    const std::vector<size_t>& Shape() const;
+    const TensorShape& Shape() const;
     
     // Shape in a nice readable string
-    static std::string ShapeStr(const std::vector<size_t>& a_shape);
+    static std::string ShapeStr(const TensorShape& a_shape);
     std::string ShapeStr() const;
 
     // Get size of raw data
     size_t Size() const;
+
+    // Number of floats to step over to move one along each dimension
+    const TensorShape& Strides() const;
   
     // Get raw data
-    const std::vector<float>& Data() const;
-    std::vector<float>& MutableData();
+    const TTensorData& Data() const;
+    TTensorData& MutableData();
 
     // Returns value at offset at a_idx ie. {1, 2, 0}
-    float At(const std::vector<size_t>& a_idx) const;
+    float At(const TensorShape& a_idx) const;
 
     // Set value at idx
-    void SetAt(const std::vector<size_t>& a_idx, float a_val);
+    void SetAt(const TensorShape& a_idx, float a_val);
+
+    // Assumes matrix, element (i, j) without the checks At does.
+    // Define NEURAL_CHECK_BOUNDS, as debug builds do, to check them.
+    float At2(size_t a_row, size_t a_col) const
+    {
+#ifdef NEURAL_CHECK_BOUNDS
+        p_CheckIdx2(a_row, a_col);
+#endif
+        return m_data[(a_row * m_strideSizes[0]) + a_col];
+    }
 
-    // Sets a row in a matrix to values in a row tensor
-    void SetRow(size_t a_row, const TTensorPtr& a_tensor);
+    void SetAt2(size_t a_row, size_t a_col, float a_val)
+    {
+#ifdef NEURAL_CHECK_BOUNDS
+        p_CheckIdx2(a_row, a_col);
+#endif
+        m_data[(a_row * m_strideSizes[0]) + a_col] = a_val;
+    }
 
-    // Get a row from a matrix
+    // Pointer to the first element of a row, the rest of the row
+    // follows contiguously. Unchecked like At2.
+    const float* RowData(size_t a_row) const
+    {
+#ifdef NEURAL_CHECK_BOUNDS
+        p_CheckIdx2(a_row, 0);
+#endif
+        return m_data.data() + (a_row * m_strideSizes[0]);
+    }
+
+    float* MutableRowData(size_t a_row)
+    {
+#ifdef NEURAL_CHECK_BOUNDS
+        p_CheckIdx2(a_row, 0);
+#endif
+        return m_data.data() + (a_row * m_strideSizes[0]);
+    }
+
+    // Sets a row in a matrix to values in a row tensor or 1xN view
+    void SetRow(size_t a_row, const TensorView& a_tensor);
+
+    // Get a copy of a row from a matrix, prefer TensorView::Row
+    // which shares this tensor's data instead of copying it
     TTensorPtr GetRow(size_t a_row) const;
 
     // Get maximum value from tensor
     float MaxVal() const;
 
-    // Get index of maximum value from tensor
+    // Get index of maximum value from tensor, the first one if it
+    // appears more than once, NaNs are skipped
     size_t MaxIdx() const;
 
     // Test if tensors have same shape
     bool HasSameShape(const TTensorPtr& a_other) const;
 
+    // In place operations, each returns *this so they chain,
+    // ie. l_grad->Scale(-2.0).Add(l_bias)
+
+    // x = x * a_val
+    Tensor& Scale(float a_val);
+
+    // x = x + a_val
+    Tensor& Add(float a_val);
+
+    // x = x + (a_alpha * other), other must have the same shape
+    Tensor& Add(const TensorView& a_other, float a_alpha = 1.0);
+
+    // x = min(max(x, a_min), a_max), NaN comes out as a_min
+    Tensor& Clamp(float a_min, float a_max);
+
+    // x = exp(x)
+    Tensor& Exp();
+
     Tensor& operator-=(const float& a_val)
     {
-        for (size_t i = 0; i < m_data.size(); ++i)
-        {
-            m_data.at(i) -= a_val;
-        }
-        return *this;
+        return Add(-a_val);
     }
 
-    Tensor& operator/=(const float& a_val)
-    {
-        for (size_t i = 0; i < m_data.size(); ++i)
-        {
-            m_data.at(i) /= a_val;
-        }
-        return *this;
-    }
+    Tensor& operator/=(const float& a_val);
   
 private:
-    std::vector<size_t> m_shape;
-    std::vector<float> m_data;
+    // Empty, for Adopt to fill in
+    Tensor();
+
+    TensorShape m_shape;
+    TTensorData m_data;
     // Precomputed stride sizes
-    std::vector<size_t> m_strideSizes;
+    TensorShape m_strideSizes;
   
-    size_t p_CalcSize(const std::vector<size_t>& a_shape) const;
+    size_t p_CalcSize(const TensorShape& a_shape) const;
     // Add to precompute stride sizes
-    std::vector<size_t> p_ComputeStrideSizes(const std::vector<size_t>& a_tensorShape) const;
+    TensorShape p_ComputeStrideSizes(const TensorShape& a_tensorShape) const;
 
     // Add to calculate offset into data given strides
     size_t p_DataOffsetFromIdx(
-        const std::vector<size_t>& a_tensorIdx) const;
+        const TensorShape& a_tensorIdx) const;
+
+    // Throws if (a_row, a_col) is not inside a matrix
+    void p_CheckIdx2(size_t a_row, size_t a_col) const;
 };
   
 } // namespace neural
\ No newline at end of file
@@ -6,6 +6,11 @@
 #pragma once
 
 #include "neural/math/tensor.h"
+#include "neural/math/tensor_view.h"
+#include "neural/math/elementwise.h"
+#include "neural/math/reduction.h"
+
+#include <vector>
 
 namespace neural
 {
@@ -13,8 +18,15 @@ namespace neural
 class TensorMath
 {
 public:
-    static TTensorPtr Multiply(const TTensorPtr& a_lhs, const TTensorPtr& a_rhs);
+    // Takes tensors or views, transposed or narrowed views are handed
+    // to BLAS as is without being copied first
+    static TTensorPtr Multiply(const TensorView& a_lhs, const TensorView& a_rhs);
     static TTensorPtr Transpose(const TTensorPtr& a_tensor);
+    // Assumes square matrix, transposes it where it is
+    static void TransposeInPlace(const TMutableTensorPtr& a_mat);
+    // New tensor with the dimensions reordered, dimension i of the
+    // result is dimension a_axes[i] of a_tensor
+    static TTensorPtr Permute(const TTensorPtr& a_tensor, const std::vector<size_t>& a_axes);
     // Assumes matrix, adds column at the end
     static TTensorPtr AddCol(const TTensorPtr& a_tensor, float a_val);
     // Assumes matrix, removes column at the end
@@ -23,6 +35,52 @@ public:
     static TTensorPtr AddRow(const TTensorPtr& a_tensor, float a_val);
     // Assumes matrix, removes row at the end
     static TTensorPtr RemoveRow(const TTensorPtr& a_tensor);
+
+    // Elementwise ops, each writes into a_out which must already have
+    // the input's shape and may be the input itself
+
+    // a_out = a_lhs op a_rhs, a_rhs has the same shape as a_lhs, or is
+    // a 1xN row applied to every row, an Mx1 column applied to every
+    // column, or a single value
+    static void Apply(
+        ElementwiseOp a_op, const TTensorPtr& a_lhs, const TTensorPtr& a_rhs,
+        const TMutableTensorPtr& a_out);
+
+    // a_out = a_lhs op a_rhs
+    static void Apply(
+        ElementwiseOp a_op, const TTensorPtr& a_lhs, float a_rhs,
+        const TMutableTensorPtr& a_out);
+
+    // a_out = a_in * a_val
+    static void Scale(const TTensorPtr& a_in, float a_val, const TMutableTensorPtr& a_out);
+
+    // a_y = a_y + (a_alpha * a_x)
+    static void Axpy(float a_alpha, const TTensorPtr& a_x, const TMutableTensorPtr& a_y);
+
+    // a_out = exp(a_in)
+    static void Exp(const TTensorPtr& a_in, const TMutableTensorPtr& a_out);
+
+    // a_out = log(a_in)
+    static void Log(const TTensorPtr& a_in, const TMutableTensorPtr& a_out);
+
+    // Assumes matrix, reduces along a_axis into a_out. Axis 1 gives one
+    // value per row in an Mx1 a_out, axis 0 one per column in a 1xN a_out.
+    static void Reduce(ReduceOp a_op, size_t a_axis, const TTensorPtr& a_mat, const TMutableTensorPtr& a_out);
+
+    // Assumes matrix, index of the largest value in each row (a_axis 1)
+    // or column (a_axis 0), a_out is resized to fit
+    static void ArgMax(size_t a_axis, const TTensorPtr& a_mat, std::vector<size_t>& a_out);
+
+private:
+    // How BLAS should read a matrix view, false if the view
+    // has no unit stride and has to be copied first
+    static bool p_BlasLayout(const TensorView& a_view, bool& a_outTranspose, int& a_outLeadingDim);
+
+    // Throws unless a_out has the same shape as a_in
+    static void p_CheckOutput(const char* a_name, const TTensorPtr& a_in, const TTensorPtr& a_out);
+
+    // Throws unless a_mat is a matrix and a_axis is 0 or 1
+    static void p_CheckAxis(const char* a_name, size_t a_axis, const TTensorPtr& a_mat);
 };
 
 } // namespace neural
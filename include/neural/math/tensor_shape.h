@@ -0,0 +1,62 @@
+/*
+ * TensorShape holds the sizes, strides or an index of a tensor inline,
+ * up to MAX_RANK dimensions, so building one for every At({i, j})
+ * does not touch the heap. It reads like the std::vector<size_t>
+ * it replaces and converts to one where needed.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+namespace neural
+{
+
+class TensorShape
+{
+public:
+    static const size_t MAX_RANK = 8;
+
+    // Rank 0
+    TensorShape();
+
+    TensorShape(std::initializer_list<size_t> a_dims);
+    TensorShape(const std::vector<size_t>& a_dims);
+    TensorShape(const size_t* a_begin, const size_t* a_end);
+
+    size_t size() const { return m_rank; }
+    bool empty() const { return 0 == m_rank; }
+
+    // Unchecked
+    size_t operator[](size_t a_dim) const { return m_dims[a_dim]; }
+    size_t& operator[](size_t a_dim) { return m_dims[a_dim]; }
+
+    // Checked, throws std::out_of_range like std::vector
+    size_t at(size_t a_dim) const;
+    size_t& at(size_t a_dim);
+
+    const size_t* begin() const { return m_dims; }
+    const size_t* end() const { return m_dims + m_rank; }
+    size_t* begin() { return m_dims; }
+    size_t* end() { return m_dims + m_rank; }
+
+    void push_back(size_t a_dim);
+
+    // Product of the dimensions, 1 for rank 0
+    size_t NumElements() const;
+
+    operator std::vector<size_t>() const;
+
+    bool operator==(const TensorShape& a_other) const;
+    bool operator!=(const TensorShape& a_other) const;
+
+private:
+    size_t m_dims[MAX_RANK];
+    size_t m_rank;
+
+    void p_Assign(const size_t* a_begin, const size_t* a_end);
+};
+
+} // namespace neural
@@ -0,0 +1,121 @@
+/*
+ * TensorT is a typed handle on a Tensor whose rank is known at compile
+ * time. The rank is checked once when it is made from a TTensorPtr,
+ * after that the shape and strides live in std::arrays and indexing is
+ * inlined and unchecked, so loops over it compile like loops over
+ * plain arrays. It shares the tensor it came from and hands it back
+ * with Ptr(), so going between the two never copies data.
+ *
+ * TMatrix reads a matrix, TMutableMatrix writes one.
+ */
+
+#pragma once
+
+#include "neural/math/tensor.h"
+
+#include <array>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace neural
+{
+
+template <size_t Rank, typename Scalar = const float>
+class TensorT
+{
+public:
+    static_assert(Rank > 0, "TensorT needs at least one dimension");
+
+    static constexpr size_t RANK = Rank;
+    static constexpr bool IS_MUTABLE = !std::is_const<Scalar>::value;
+
+    typedef std::array<size_t, Rank> TIndex;
+
+    // TTensorPtr for read only handles, TMutableTensorPtr otherwise
+    typedef typename std::conditional<IS_MUTABLE, TMutableTensorPtr, TTensorPtr>::type TPtr;
+
+    // Throws if the tensor's rank is not Rank
+    explicit TensorT(const TPtr& a_tensor)
+        : m_tensor(a_tensor)
+        , m_data(a_tensor->Size() ? &p_Storage(*a_tensor)[0] : nullptr)
+    {
+        const TensorShape& l_shape = a_tensor->Shape();
+        if (l_shape.size() != Rank)
+        {
+            std::stringstream l_ss;
+            l_ss << "TensorT rank " << Rank << " cannot hold tensor " << a_tensor->ShapeStr();
+            throw(std::runtime_error(l_ss.str()));
+        }
+
+        for (size_t i = 0; i < Rank; ++i)
+        {
+            m_shape[i] = l_shape[i];
+            m_strides[i] = a_tensor->Strides()[i];
+        }
+    }
+
+    // New zero filled tensor of this shape
+    static TensorT New(const TIndex& a_shape)
+    {
+        static_assert(IS_MUTABLE, "TensorT::New makes mutable tensors, use TMutableMatrix");
+        return TensorT(Tensor::New(TensorShape(a_shape.data(), a_shape.data() + Rank)));
+    }
+
+    // The tensor this handle is on
+    const TPtr& Ptr() const { return m_tensor; }
+
+    const TIndex& Shape() const { return m_shape; }
+    const TIndex& Strides() const { return m_strides; }
+    size_t Dim(size_t a_dim) const { return m_shape[a_dim]; }
+    size_t Size() const { return m_tensor->Size(); }
+
+    Scalar* Data() const { return m_data; }
+
+    // Element at (i, j, ...), exactly Rank indices, unchecked
+    template <typename... TIdx>
+    Scalar& operator()(TIdx... a_idx) const
+    {
+        static_assert(sizeof...(TIdx) == Rank, "TensorT needs one index per dimension");
+        return m_data[p_Offset<0>(a_idx...)];
+    }
+
+    // Pointer to the start of a_idx along the first dimension,
+    // ie. a row of a matrix, the rest of it follows contiguously
+    Scalar* Row(size_t a_idx) const
+    {
+        return m_data + (a_idx * m_strides[0]);
+    }
+
+private:
+    TPtr m_tensor;
+    Scalar* m_data;
+    TIndex m_shape;
+    TIndex m_strides;
+
+    template <size_t Dim>
+    size_t p_Offset(size_t a_idx) const
+    {
+        return a_idx * m_strides[Dim];
+    }
+
+    template <size_t Dim, typename... TRest>
+    size_t p_Offset(size_t a_idx, size_t a_next, TRest... a_rest) const
+    {
+        return (a_idx * m_strides[Dim]) + p_Offset<Dim + 1>(a_next, a_rest...);
+    }
+
+    static const TTensorData& p_Storage(const Tensor& a_tensor) { return a_tensor.Data(); }
+    static TTensorData& p_Storage(Tensor& a_tensor) { return a_tensor.MutableData(); }
+};
+
+template <size_t Rank, typename Scalar>
+constexpr size_t TensorT<Rank, Scalar>::RANK;
+
+template <size_t Rank, typename Scalar>
+constexpr bool TensorT<Rank, Scalar>::IS_MUTABLE;
+
+typedef TensorT<2> TMatrix;
+typedef TensorT<2, float> TMutableMatrix;
+
+} // namespace neural
@@ -0,0 +1,96 @@
+/*
+ * TensorView is a non-owning window onto a tensor's data, described
+ * by a shape, per dimension strides and an offset. Rows, slices,
+ * narrowed ranges and transposes are all just different strides over
+ * the parent's buffer, so making one never copies data.
+ */
+
+#pragma once
+
+#include "neural/math/tensor.h"
+
+#include <vector>
+
+namespace neural
+{
+
+class TensorView
+{
+public:
+    // View over a whole tensor, shares ownership so the buffer stays
+    // alive as long as the view does
+    TensorView(const TTensorPtr& a_tensor);
+    TensorView(const TMutableTensorPtr& a_tensor);
+
+    // Borrows a tensor the caller keeps alive, ie. one on the stack
+    explicit TensorView(const Tensor& a_tensor);
+
+    // Get the shape of the view ie: 1x10
+    const TensorShape& Shape() const;
+    std::string ShapeStr() const;
+
+    // Number of floats to step over to move one along each dimension
+    const TensorShape& Strides() const;
+
+    // Offset of element {0,...,0} into the parent's buffer
+    size_t Offset() const;
+
+    // Number of elements in the view
+    size_t Size() const;
+
+    // Pointer to element {0,...,0}, walk it with Strides()
+    const float* Data() const;
+
+    // True if the view is laid out row major with no gaps,
+    // ie. Data() can be read as Size() consecutive floats
+    bool IsContiguous() const;
+
+    // Returns value at idx ie. {1, 2, 0}
+    float At(const TensorShape& a_idx) const;
+
+    // Assumes matrix, 1xN view of a single row
+    TensorView Row(size_t a_row) const;
+
+    // Drops the first dimension by fixing it at a_idx,
+    // ie. image 3 of a 4x28x28 batch is a 28x28 view
+    TensorView Slice(size_t a_idx) const;
+
+    // Keeps [a_start, a_start + a_length) along dimension a_dim
+    TensorView Narrow(size_t a_dim, size_t a_start, size_t a_length) const;
+
+    // Assumes matrix, swaps rows and columns
+    TensorView Transpose() const;
+
+    // Reorders the dimensions, dimension i of the result is dimension
+    // a_axes[i] of this view, ie. {0, 2, 3, 1} turns NCHW into NHWC
+    TensorView Permute(const std::vector<size_t>& a_axes) const;
+
+    // Copies the view out into a new contiguous tensor
+    TMutableTensorPtr ToTensor() const;
+
+    // Get maximum value in the view
+    float MaxVal() const;
+
+    // Get row major index of the maximum value in the view
+    size_t MaxIdx() const;
+
+private:
+    TensorView(
+        const TTensorPtr& a_owner,
+        const float* a_base,
+        const TensorShape& a_shape,
+        const TensorShape& a_strides,
+        size_t a_offset);
+
+    // Keeps the parent alive, empty for borrowed views
+    TTensorPtr m_owner;
+    const float* m_base;
+    TensorShape m_shape;
+    TensorShape m_strides;
+    size_t m_offset;
+
+    // Offset from Data() of the i-th element in row major order
+    size_t p_OffsetOfElement(size_t a_element) const;
+};
+
+} // namespace neural
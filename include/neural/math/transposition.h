@@ -0,0 +1,43 @@
+/*
+ * Transposes and axis permutations. Matrices are walked in square
+ * tiles so both the rows read and the columns written stay in cache,
+ * and each tile is transposed 8x8 at a time in registers on the
+ * instruction set Elementwise picked, see Elementwise::SetIsa.
+ * Large matrices are split across threads by tile.
+ */
+
+#pragma once
+
+#include "neural/math/tensor_shape.h"
+
+#include <cstddef>
+
+namespace neural
+{
+
+class Transposition
+{
+public:
+    // a_out = a_in transposed, a_in is a_rows x a_cols row major and
+    // a_out a_cols x a_rows. The strides are the floats between the
+    // start of one row and the next, so either may be part of a
+    // larger matrix. a_in and a_out must not overlap.
+    static void Matrix(
+        const float* a_in, size_t a_rows, size_t a_cols, size_t a_inStride,
+        float* a_out, size_t a_outStride);
+
+    static void Matrix(const float* a_in, size_t a_rows, size_t a_cols, float* a_out);
+
+    // Transposes a square a_size x a_size matrix where it is
+    static void InPlace(float* a_mat, size_t a_size, size_t a_stride);
+
+    // Copies a strided layout, as held by a TensorView, out into row
+    // major a_out. Element {i, j, ...} is read from
+    // a_in[(i * a_strides[0]) + (j * a_strides[1]) + ...], so permuting
+    // the axes of a tensor is gathering it with permuted strides.
+    static void Gather(
+        const float* a_in, const TensorShape& a_shape, const TensorShape& a_strides,
+        float* a_out);
+};
+
+} // namespace neural
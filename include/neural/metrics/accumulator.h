@@ -0,0 +1,144 @@
+/*
+ * metrics::Accumulator is the base class for the different ways a Metric
+ * can keep track of the results added to it, and count true positives,
+ * false positives, true negatives and false negatives from them
+ * 
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <atomic>
+#include <istream>
+#include <ostream>
+
+namespace neural
+{
+
+namespace metrics
+{
+
+// Number of examples that fall in each bucket at a confidence cutoff.
+// Examples whose confidence is exactly the cutoff are in none of them.
+struct ConfusionCounts
+{
+    size_t truePositives;
+    size_t falsePositives;
+    size_t trueNegatives;
+    size_t falseNegatives;
+};
+
+// Everything the metrics need to know about a single example, reduced
+// from a row of outputs and a row of targets as soon as it is added
+struct PredictionRecord
+{
+    // argmax of the target row
+    uint16_t target;
+    // argmax of the output row
+    uint16_t prediction;
+    // output value at the prediction
+    float confidence;
+};
+
+// Precision and recall at one confidence cutoff
+struct CurvePoint
+{
+    float threshold;
+    float precision;
+    float recall;
+
+    // precision = tp / (tp + fp), recall = tp / (tp + fn), 0 if undefined
+    static CurvePoint FromCounts(
+        float a_confidence, const ConfusionCounts& a_counts);
+};
+
+class Accumulator;
+
+typedef std::shared_ptr<Accumulator> TAccumulatorPtr;
+
+class Accumulator
+{
+
+public:
+    Accumulator();
+    virtual ~Accumulator() {};
+
+    // Accumulate one record per example
+    void Add(const PredictionRecord* a_records, size_t a_numRecords);
+
+    // Fold everything another accumulator of the same type has
+    // accumulated into this one
+    void Merge(const Accumulator& a_other);
+
+    // Write the accumulated state in a compact binary format
+    void Serialize(std::ostream& a_stream) const;
+
+    // Replace the accumulated state with one written by Serialize,
+    // which must have come from an accumulator of the same type
+    void Deserialize(std::istream& a_stream);
+
+    // Create an accumulator of whichever type wrote the state
+    static TAccumulatorPtr Load(std::istream& a_stream);
+
+    // Counts at a confidence cutoff over everything accumulated
+    virtual ConfusionCounts CalcConfusionCounts(float a_confidence) const = 0;
+
+    // Hint that this cutoff will be calculated often. Accumulators that
+    // can keep counts at a cutoff up to date as they go override this.
+    virtual void TrackCutoff(float a_confidence) {};
+
+    // Number of examples currently being calculated over
+    virtual size_t NumExamples() const = 0;
+
+    // Bumped on every Add so callers know when anything they
+    // cached from the accumulator is stale
+    virtual size_t Version() const;
+
+protected:
+    virtual void p_Add(const PredictionRecord* a_records, size_t a_numRecords) = 0;
+    virtual void p_Merge(const Accumulator& a_other) = 0;
+
+    // Tag written in the header so Load knows what to create
+    virtual uint32_t p_SerialTag() const = 0;
+    virtual void p_Serialize(std::ostream& a_stream) const = 0;
+    virtual void p_Deserialize(std::istream& a_stream) = 0;
+
+    // Fixed width little endian helpers for the serialized format
+    static void p_WriteU64(std::ostream& a_stream, uint64_t a_val);
+    static void p_WriteF32(std::ostream& a_stream, float a_val);
+    static void p_WriteRecord(std::ostream& a_stream, const PredictionRecord& a_record);
+    static void p_WriteCounts(std::ostream& a_stream, const ConfusionCounts& a_counts);
+    static uint64_t p_ReadU64(std::istream& a_stream);
+    static float p_ReadF32(std::istream& a_stream);
+    static PredictionRecord p_ReadRecord(std::istream& a_stream);
+    static ConfusionCounts p_ReadCounts(std::istream& a_stream);
+
+    // Counter a record falls into at a cutoff, null if it is exactly
+    // at the cutoff and so counted as none of them
+    static size_t* p_CounterFor(
+        const PredictionRecord& a_record, float a_confidence,
+        ConfusionCounts& a_counts);
+
+private:
+    // ConcurrentAccumulator forwards serialization to its shards
+    friend class ConcurrentAccumulator;
+
+    // Atomic so accumulators fed from many threads can still bump it
+    std::atomic<size_t> m_version;
+    // Set by ConcurrentAccumulator, whose shards keep their own versions
+    // so adds from different threads never write the same cache line
+    bool m_shardedVersion;
+
+    static const uint64_t SERIAL_MAGIC;
+    static const uint64_t SERIAL_FORMAT_VERSION;
+
+    // Reads the header and returns the type tag
+    static uint32_t p_ReadHeader(std::istream& a_stream);
+
+};
+
+} // namespace metrics
+
+} // namespace neural
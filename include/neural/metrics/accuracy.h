@@ -17,7 +17,8 @@ class Accuracy : public Metric
 {
 
 public:
-    Accuracy(size_t a_runningAvgLen = 1000);
+    Accuracy(size_t a_windowSize = 0);
+    Accuracy(const TAccumulatorPtr& a_accumulator);
     virtual ~Accuracy() {};
 
     // name for logging / debugging
@@ -26,6 +27,13 @@ public:
     // calculate the metric
     virtual float Calculate(float a_confidence = 0.0) const override;
 
+protected:
+    virtual float p_CalculateFromCounts(const ConfusionCounts& a_counts) const override;
+
+    // accuracy is over every example, whatever the cutoff, unless it is
+    // multi label
+    virtual float p_CountsCutoff(float a_confidenceLevel) const override;
+
 private:
     static const std::string NAME;
 
@@ -0,0 +1,85 @@
+/*
+ * Threshold free summaries of how well the confidence separates correct
+ * predictions from incorrect ones, given predictions and targets stored
+ * in parent class:
+ *
+ *   ROC AUC, the chance a random correct prediction is more confident
+ *   than a random incorrect one (ties count half)
+ *
+ *   Average precision, the precision at each distinct confidence
+ *   weighted by how much recall it adds
+ *
+ * Both are computed from one parallel sort of the records and a
+ * parallel sweep over it, and cached until the next AddResults.
+ * 
+ */
+
+#pragma once
+
+#include "neural/metrics/metric.h"
+#include "neural/metrics/record_accumulator.h"
+
+#include <vector>
+
+namespace neural
+{
+
+namespace metrics
+{
+
+class AreaUnderCurve : public Metric
+{
+
+public:
+    AreaUnderCurve(size_t a_windowSize = 0);
+    AreaUnderCurve(const TRecordAccumulatorPtr& a_accumulator);
+    virtual ~AreaUnderCurve() {};
+
+    // name for logging / debugging
+    virtual const std::string& GetName() const override;
+
+    // average precision, the confidence level does not matter
+    virtual float Calculate(float a_confidenceLevel = 0.5) const override;
+
+    // Over every example, 0 when undefined (no correct or incorrect ones)
+    float RocAuc() const;
+    float AveragePrecision() const;
+
+    // Only over the examples that were predicted as `a_class`
+    float RocAuc(size_t a_class) const;
+    float AveragePrecision(size_t a_class) const;
+
+    // Mean over the classes where the per class value is defined
+    float MacroRocAuc() const;
+    float MacroAveragePrecision() const;
+
+private:
+    static const std::string NAME;
+
+    // Summaries need the exact records
+    TRecordAccumulatorPtr m_records;
+
+    struct Summary
+    {
+        size_t numCorrect;
+        size_t numIncorrect;
+        float rocAuc;
+        float averagePrecision;
+    };
+
+    // Cached summaries, rebuilt lazily after AddResults
+    mutable bool m_hasSummaries;
+    mutable size_t m_summariesVersion;
+    mutable Summary m_overall;
+    mutable std::vector<Summary> m_perClass;
+
+    void p_BuildSummaries() const;
+
+    // Summarize records sorted by descending confidence
+    static Summary p_Summarize(const PredictionRecord* a_sorted, size_t a_numRecords);
+
+};
+
+} // namespace metric
+
+} // namespace neural
@@ -0,0 +1,101 @@
+/*
+ * metrics::BinnedPrecisionRecall keeps fixed width histograms of the
+ * confidences of correct and incorrect predictions for each predicted
+ * class instead of the predictions themselves. Memory only depends on
+ * the number of bins and classes, never on how many examples were added.
+ *
+ * Counts are exact for cutoffs on a bin edge, anywhere else they are off
+ * by at most the examples within one bin width below the cutoff.
+ * 
+ */
+
+#pragma once
+
+#include "neural/metrics/accumulator.h"
+
+#include <vector>
+
+namespace neural
+{
+
+namespace metrics
+{
+
+class BinnedPrecisionRecall;
+
+typedef std::shared_ptr<BinnedPrecisionRecall> TBinnedPrecisionRecallPtr;
+
+class BinnedPrecisionRecall : public Accumulator
+{
+
+public:
+    // Confidences in [0, 1] are split into `a_numBins` equal width bins
+    BinnedPrecisionRecall(size_t a_numBins = 1024);
+    virtual ~BinnedPrecisionRecall() {};
+
+    static TBinnedPrecisionRecallPtr New(size_t a_numBins = 1024);
+
+    // Identifies histogram state in a serialized stream
+    static const uint32_t SERIAL_TAG = 2;
+
+    // Counts as if the cutoff were the lower edge of the bin it falls in
+    virtual ConfusionCounts CalcConfusionCounts(float a_confidence) const override;
+
+    // Same, only over the examples that were predicted as `a_class`
+    ConfusionCounts CalcConfusionCounts(float a_confidence, size_t a_class) const;
+
+    virtual size_t NumExamples() const override;
+
+    // Point at the lower edge of every bin, lowest first
+    std::vector<CurvePoint> Points() const;
+
+    // Same, only over the examples that were predicted as `a_class`
+    std::vector<CurvePoint> Points(size_t a_class) const;
+
+    size_t NumBins() const;
+    float BinWidth() const;
+
+    // One more than the largest class predicted so far
+    size_t NumClasses() const;
+
+protected:
+    virtual void p_Add(const PredictionRecord* a_records, size_t a_numRecords) override;
+
+    // Adds up the histograms, both must have the same number of bins
+    virtual void p_Merge(const Accumulator& a_other) override;
+
+    virtual uint32_t p_SerialTag() const override;
+    virtual void p_Serialize(std::ostream& a_stream) const override;
+    virtual void p_Deserialize(std::istream& a_stream) override;
+
+private:
+    size_t m_numBins;
+    size_t m_numExamples;
+
+    // Histograms laid out as [(class * m_numBins) + bin]
+    std::vector<size_t> m_correct;
+    std::vector<size_t> m_incorrect;
+
+    // Cumulative counts of each bin and every bin above it, laid out as
+    // [(class * (m_numBins + 1)) + bin] with one extra row at the end
+    // summed over all classes. Rebuilt lazily after Add.
+    mutable bool m_hasSums;
+    mutable size_t m_sumsVersion;
+    mutable std::vector<size_t> m_correctFromBin;
+    mutable std::vector<size_t> m_incorrectFromBin;
+
+    void p_GrowToClasses(size_t a_numClasses);
+
+    size_t p_BinFor(float a_confidence) const;
+    // First bin counted as above a cutoff, m_numBins if none are
+    size_t p_CutoffBin(float a_confidence) const;
+
+    void p_BuildSums() const;
+    ConfusionCounts p_CountsFromBin(size_t a_sumsRow, size_t a_bin) const;
+    std::vector<CurvePoint> p_PointsForRow(size_t a_sumsRow) const;
+
+};
+
+} // namespace metrics
+
+} // namespace neural
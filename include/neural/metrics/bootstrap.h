@@ -0,0 +1,62 @@
+/*
+ * metrics::Bootstrap puts percentile intervals around a metric by
+ * recalculating it over resamples (with replacement) of the records.
+ *
+ * Each record is first reduced to whether it is correct and where its
+ * confidence falls among the cutoffs, so a replicate is one pass of
+ * random draws into a small histogram no matter how many cutoffs there
+ * are. Draws come from a counter based generator, so replicates run on
+ * every core and still give the same answer for the same seed.
+ * 
+ */
+
+#pragma once
+
+#include "neural/metrics/accumulator.h"
+
+#include <functional>
+#include <vector>
+
+namespace neural
+{
+
+namespace metrics
+{
+
+// Metric at one cutoff over every record, and the interval around it
+struct BootstrapInterval
+{
+    float threshold;
+    float value;
+    float lower;
+    float upper;
+};
+
+class Bootstrap
+{
+public:
+    // Turns the counts of one replicate at one cutoff into the metric
+    typedef std::function<float(const ConfusionCounts&)> TCalculateFn;
+
+    // One interval per cutoff, in the order given, covering `a_level`
+    // of the replicates (0.95 takes the 2.5th and 97.5th percentiles)
+    static std::vector<BootstrapInterval> Intervals(
+        const std::vector<PredictionRecord>& a_records,
+        const std::vector<float>& a_cutoffs,
+        const TCalculateFn& a_calculate,
+        size_t a_numReplicates = 1000,
+        float a_level = 0.95f,
+        uint64_t a_seed = 0);
+
+private:
+    // splitmix64 of a counter
+    static uint64_t p_Random(uint64_t a_seed, uint64_t a_counter);
+
+    // Counts at cutoff `a_cutoff` from a histogram of record categories
+    static ConfusionCounts p_CountsFromHistogram(
+        const std::vector<size_t>& a_histogram, size_t a_cutoff);
+};
+
+} // namespace metrics
+
+} // namespace neural
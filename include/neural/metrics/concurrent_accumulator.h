@@ -0,0 +1,112 @@
+/*
+ * metrics::ConcurrentAccumulator lets many threads feed one metric at once.
+ * Every thread gets its own shard accumulator the first time it adds
+ * results, so writers never share state or wait on each other. Reads
+ * combine the shards, briefly locking each one in turn.
+ * 
+ */
+
+#pragma once
+
+#include "neural/metrics/accumulator.h"
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace neural
+{
+
+namespace metrics
+{
+
+class ConcurrentAccumulator;
+
+typedef std::shared_ptr<ConcurrentAccumulator> TConcurrentAccumulatorPtr;
+
+class ConcurrentAccumulator : public Accumulator
+{
+
+public:
+    // Creates an empty accumulator for each new shard
+    typedef std::function<TAccumulatorPtr()> TShardFactory;
+
+    // Shards are unbounded RecordAccumulators by default
+    ConcurrentAccumulator();
+    ConcurrentAccumulator(const TShardFactory& a_newShard);
+    virtual ~ConcurrentAccumulator();
+
+    static TConcurrentAccumulatorPtr New();
+    static TConcurrentAccumulatorPtr New(const TShardFactory& a_newShard);
+
+    // Sum of the counts in every shard. Windowed shards each keep their
+    // own window of whatever their thread added.
+    virtual ConfusionCounts CalcConfusionCounts(float a_confidence) const override;
+
+    virtual void TrackCutoff(float a_confidence) override;
+
+    virtual size_t NumExamples() const override;
+
+    // Sum of the shards' versions, so adding never bumps a counter
+    // shared between threads
+    virtual size_t Version() const override;
+
+    // Every shard merged into one new accumulator of the shard type,
+    // for anything that needs more than counts (curves, histograms...)
+    TAccumulatorPtr Snapshot() const;
+
+    // Number of threads that have added results so far
+    size_t NumShards() const;
+
+protected:
+    virtual void p_Add(const PredictionRecord* a_records, size_t a_numRecords) override;
+
+    // The other accumulator's shards are merged into this thread's shard
+    virtual void p_Merge(const Accumulator& a_other) override;
+
+    // Written in the shard type's own format, so it can be loaded back
+    // as a plain accumulator of that type
+    virtual uint32_t p_SerialTag() const override;
+    virtual void p_Serialize(std::ostream& a_stream) const override;
+    virtual void p_Deserialize(std::istream& a_stream) override;
+
+private:
+    // Every thread's map from accumulator id to its shard. Shared with
+    // the shards so an accumulator can take its entries back out when
+    // it is destroyed, even after the thread has exited.
+    struct ThreadRegistry;
+    typedef std::shared_ptr<ThreadRegistry> TThreadRegistryPtr;
+
+    struct Shard
+    {
+        std::mutex lock;
+        TAccumulatorPtr accumulator;
+        // the registry of the thread this shard belongs to
+        TThreadRegistryPtr registry;
+        // keep neighbouring shards off of each others cache lines
+        char padding[64];
+    };
+
+    TShardFactory m_newShard;
+    // Unique for the life of the process, unlike `this`, so a thread's
+    // cached shard can never be mistaken for one of a newer accumulator
+    uint64_t m_id;
+
+    // Guards the list of shards and tracked cutoffs, only taken when a
+    // thread adds results for the first time and on reads
+    mutable std::mutex m_shardsLock;
+    std::vector<Shard*> m_shards;
+    std::vector<float> m_trackedCutoffs;
+    // Versions of shard accumulators replaced by Deserialize, so
+    // Version() never goes backwards
+    size_t m_retiredVersions;
+
+    // The calling thread's shard, created on first use
+    Shard& p_ThreadShard();
+    Shard* p_NewShard();
+
+};
+
+} // namespace metrics
+
+} // namespace neural
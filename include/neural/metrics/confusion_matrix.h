@@ -0,0 +1,81 @@
+/*
+ * metrics::ConfusionMatrix counts how often each target class was
+ * predicted as each class, so we can see which classes are failing.
+ * Rows are targets, columns are predictions.
+ * 
+ */
+
+#pragma once
+
+#include "neural/math/tensor.h"
+#include "neural/metrics/accumulator.h"
+
+#include <vector>
+
+namespace neural
+{
+
+namespace metrics
+{
+
+class ConfusionMatrix
+{
+
+public:
+    ConfusionMatrix(size_t a_numClasses);
+
+    // Count every row of a batch of outputs against its targets
+    void AddResults(
+        const TTensorPtr& a_outputs, const TTensorPtr& a_targets);
+
+    // Count records that were already reduced
+    void Add(const PredictionRecord* a_records, size_t a_numRecords);
+
+    // Fold in the counts of another matrix with the same classes
+    void Merge(const ConfusionMatrix& a_other);
+
+    size_t NumClasses() const;
+    size_t NumExamples() const;
+
+    // Number of examples of class `a_target` that were predicted as `a_prediction`
+    size_t Count(size_t a_target, size_t a_prediction) const;
+
+    // Average confidence of those examples, 0 if there are none
+    float MeanConfidence(size_t a_target, size_t a_prediction) const;
+
+    // One vs. rest for a single class, 0 if undefined
+    float Precision(size_t a_class) const;
+    float Recall(size_t a_class) const;
+    float F1(size_t a_class) const;
+
+    // Unweighted mean over classes
+    float MacroPrecision() const;
+    float MacroRecall() const;
+    float MacroF1() const;
+
+    // Pooled over every example, for single label data these all
+    // equal the accuracy
+    float MicroPrecision() const;
+    float MicroRecall() const;
+    float MicroF1() const;
+
+private:
+    size_t m_numClasses;
+    size_t m_numExamples;
+    // [(target * m_numClasses) + prediction]
+    std::vector<size_t> m_counts;
+    std::vector<double> m_confidenceSums;
+    // Row and column totals, kept up to date as we count
+    std::vector<size_t> m_targetTotals;
+    std::vector<size_t> m_predictionTotals;
+
+    void p_CheckClass(size_t a_class) const;
+
+    static float p_Ratio(size_t a_numerator, size_t a_denominator);
+    static float p_HarmonicMean(float a_lhs, float a_rhs);
+
+};
+
+} // namespace metrics
+
+} // namespace neural
@@ -0,0 +1,136 @@
+/*
+ * metrics::ExternalPrecisionRecallCurve gives the same exact precision
+ * recall curve as PrecisionRecallCurve for more results than fit in
+ * memory. Results are buffered in half of a memory budget, then sorted
+ * and spilled to a temporary file as a run. Queries k-way merge the runs
+ * and whatever is still buffered from the most confident down while
+ * counting, in the other half, so resident memory stays within the
+ * budget however many results were added.
+ * 
+ */
+
+#pragma once
+
+#include "neural/math/tensor.h"
+#include "neural/metrics/accumulator.h"
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace neural
+{
+
+namespace metrics
+{
+
+class ExternalPrecisionRecallCurve
+{
+
+public:
+    // Half of `a_memoryBudget` bytes buffers results, which are spilled
+    // to files in `a_tempDir` when it is full, the other half is for
+    // merging them
+    ExternalPrecisionRecallCurve(
+        size_t a_memoryBudget = 256 * 1024 * 1024,
+        const std::string& a_tempDir = "/tmp");
+    ~ExternalPrecisionRecallCurve();
+
+    // Store results, see Metric::AddResults
+    void AddResults(
+        const TTensorPtr& a_outputs, const TTensorPtr& a_targets);
+
+    void Add(const PredictionRecord* a_records, size_t a_numRecords);
+
+    size_t NumExamples() const;
+
+    // Number of runs spilled to disk so far
+    size_t NumRuns() const;
+
+    // Calls `a_fn` with the point at every distinct confidence, most
+    // confident first, without keeping them all in memory
+    void ForEachPoint(const std::function<void(const CurvePoint&)>& a_fn) const;
+
+    // Points at each of the requested cutoffs, in the order given
+    std::vector<CurvePoint> Points(const std::vector<float>& a_cutoffs) const;
+
+    // Same as AreaUnderCurve over the same results, 0 if undefined
+    float AveragePrecision() const;
+    float RocAuc() const;
+
+private:
+    // What a record is reduced to on disk
+    struct Entry
+    {
+        float confidence;
+        uint32_t isCorrect;
+    };
+
+    struct Run
+    {
+        FILE* file;
+        size_t numEntries;
+    };
+
+    // Called for each run of equal confidences, most confident first,
+    // with the number of correct and incorrect ones in it
+    typedef std::function<void(float, size_t, size_t)> TGroupFn;
+
+    size_t m_memoryBudget;
+    std::string m_tempDir;
+
+    // reserved once at half the budget and reused after every spill
+    mutable std::vector<Entry> m_buffer;
+    // queries sort the buffer and merge runs, so these are mutable
+    mutable std::vector<Run> m_runs;
+
+    size_t m_numExamples;
+    size_t m_numCorrect;
+    size_t m_numIncorrect;
+
+    // False once Add appends to the buffer, until it is next sorted
+    mutable bool m_bufferSorted;
+
+    // Cached summary, cleared on Add
+    mutable bool m_hasSummary;
+    mutable float m_averagePrecision;
+    mutable float m_rocAuc;
+
+    // files are not copyable
+    ExternalPrecisionRecallCurve(const ExternalPrecisionRecallCurve&);
+    ExternalPrecisionRecallCurve& operator=(const ExternalPrecisionRecallCurve&);
+
+    // Entries that fit in the buffer's half of the budget, and in the
+    // half merges read blocks into
+    size_t p_BufferEntries() const;
+    size_t p_MergeEntries() const;
+
+    // Most confident first
+    void p_SortBuffer() const;
+
+    // Sorts the buffer and writes it out as a new run
+    void p_Spill() const;
+
+    // Merges runs until there are few enough to merge in one pass
+    void p_ReduceRuns() const;
+
+    // Merges `a_runs` and `a_numSorted` entries already sorted in memory
+    // into one stream, most confident first
+    void p_MergeRuns(
+        const std::vector<Run>& a_runs, const Entry* a_sorted, size_t a_numSorted,
+        const std::function<void(const Entry&)>& a_fn) const;
+
+    // Streams every group of equal confidences
+    void p_ForEachGroup(const TGroupFn& a_fn) const;
+
+    void p_BuildSummary() const;
+
+    Run p_NewRun() const;
+    static void p_CloseRun(Run& a_run);
+
+};
+
+} // namespace metrics
+
+} // namespace neural
@@ -0,0 +1,82 @@
+/*
+ * metrics::KllSketch is a KLL quantile sketch of a stream of floats.
+ * Levels of values are kept where every value on level h stands in for
+ * 2^h values of the stream, and a level is halved into the one above it
+ * once it is over capacity. It keeps O(k) values no matter how long the
+ * stream is, and two sketches of the same k merge into one.
+ *
+ * Estimated ranks are within about 1.7 / k * Count() of the true rank
+ * with high probability, so k = 200 is within about 1%.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace neural
+{
+
+namespace metrics
+{
+
+class KllSketch
+{
+
+public:
+    // A level past 63 would weigh more than a size_t can count
+    static const size_t MAX_LEVELS = 64;
+
+    KllSketch(size_t a_k = 200);
+
+    void Update(float a_value);
+
+    // Adds everything `a_other` has seen, both must have the same k
+    void Merge(const KllSketch& a_other);
+
+    size_t K() const;
+
+    // Number of values in the stream
+    size_t Count() const;
+
+    // Number of values actually kept
+    size_t NumRetained() const;
+
+    // Estimated number of values in the stream < / <= `a_value`
+    size_t CountBelow(float a_value) const;
+    size_t CountAtOrBelow(float a_value) const;
+
+    // Largest kept value with an estimated CountBelow of at most
+    // `a_fraction` of the stream, 0 if the sketch is empty
+    float Quantile(double a_fraction) const;
+
+    // Kept values by level, used to serialize
+    const std::vector<std::vector<float> >& Levels() const;
+
+    // Replaces the state with serialized levels, throws if they do not
+    // add up to `a_count`
+    void Restore(size_t a_count, const std::vector<std::vector<float> >& a_levels);
+
+private:
+    size_t m_k;
+    size_t m_count;
+    std::vector<std::vector<float> > m_levels;
+
+    // Picks which half of a level is kept when compacting
+    uint64_t m_randomState;
+
+    size_t p_Capacity(size_t a_level) const;
+    size_t p_TotalCapacity() const;
+
+    // Halves the lowest level that is over capacity, until the sketch fits
+    void p_Compress();
+
+    bool p_RandomBit();
+
+};
+
+} // namespace metrics
+
+} // namespace neural
@@ -1,16 +1,18 @@
 /*
  * metrics::Metric is the base class for Precision/Recall that
- * knows how to calculate true positives, false positives, true negatives,
- * and false negatives
+ * reduces outputs and targets to records and hands them to an
+ * accumulator that knows how to count true positives, false positives,
+ * true negatives, and false negatives
  * 
  */
 
 #pragma once
 
 #include "neural/math/tensor.h"
+#include "neural/metrics/accumulator.h"
+#include "neural/metrics/bootstrap.h"
 
-#include <deque>
-#include <functional>
+#include <vector>
 
 namespace neural
 {
@@ -22,7 +24,14 @@ class Metric
 {
 
 public:
-    Metric(size_t a_runningAvgLen = 1000);
+    // Keep exact records of the last `a_windowSize` examples,
+    // or every example if it is 0
+    Metric(size_t a_windowSize = 0);
+
+    // Keep track of results with any accumulator
+    Metric(const TAccumulatorPtr& a_accumulator);
+
+    virtual ~Metric() {};
 
     // name for logging / debugging
     virtual const std::string& GetName() const = 0;
@@ -34,39 +43,80 @@ public:
     void AddResults(
         const TTensorPtr& a_outputs, const TTensorPtr& a_targets);
 
+    // Fold the results another metric has accumulated into this one,
+    // their accumulators must be of the same type
+    void Merge(const Metric& a_other);
+
+    // Write / read the accumulated results, see Accumulator::Serialize
+    void Serialize(std::ostream& a_stream) const;
+    void Deserialize(std::istream& a_stream);
+
+    // Calculating at this cutoff should be cheap, see Accumulator::TrackCutoff
+    void TrackCutoff(float a_confidence);
+
+    // Number of examples currently being calculated over
+    size_t NumExamples() const;
+
+    const TAccumulatorPtr& GetAccumulator() const;
+
+    // Count a row as correct when its target is within the `a_k` largest
+    // outputs, ties going its way. 1 is the plain argmax. Has to be set
+    // before any results are added.
+    void SetTopK(size_t a_k);
+    size_t TopK() const;
+
+    // Every output column is its own yes / no prediction (sigmoid heads),
+    // positive when its target is over 0.5. Each cell is then an example
+    // predicting its column, correct when the target is positive, so
+    // precision and recall are over every label at the cutoff. Has to be
+    // set before any results are added.
+    void SetMultiLabel(bool a_isMultiLabel);
+    bool IsMultiLabel() const;
+
+    // Percentile intervals of the metric at each cutoff over
+    // `a_numReplicates` resamples of the results, see Bootstrap. Needs
+    // exact records, so a RecordAccumulator or a ConcurrentAccumulator
+    // of them, and a metric that can be calculated from counts.
+    std::vector<BootstrapInterval> Bootstrap(
+        const std::vector<float>& a_cutoffs,
+        size_t a_numReplicates = 1000,
+        float a_level = 0.95f,
+        uint64_t a_seed = 0) const;
+
+    // Reduce each row of a batch to a record, see SetTopK
+    static void ReduceRows(
+        const TTensorPtr& a_outputs, const TTensorPtr& a_targets,
+        std::vector<PredictionRecord>& a_outRecords, size_t a_topK = 1);
+
+    // Reduce each cell of a batch to a record, see SetMultiLabel
+    static void ReduceCells(
+        const TTensorPtr& a_outputs, const TTensorPtr& a_targets,
+        std::vector<PredictionRecord>& a_outRecords);
+
 protected:
-    // Keep track of `m_runningAvgLen` examples so we can calculate given
-    // last n examples
-    size_t m_runningAvgLen;
-    // We will keep a state of last `m_runningAvgLen` outputs and targets
-    std::deque<const TTensorPtr> m_outputs;
-    std::deque<const TTensorPtr> m_targets;
-
-    size_t p_IterAndCountWithFn(
-        std::function<bool(size_t, size_t, float, float)> a_comparatorFn,
-        float a_confidence) const;
-
-    size_t p_CalcNumTruePositives(
-        float a_confidence) const;
-    size_t p_CalcNumTrueNegatives(
-        float a_confidence) const;
-    size_t p_CalcNumFalsePositives(
-        float a_confidence) const;
-    size_t p_CalcNumFalseNegatives(
-        float a_confidence) const;
-
-    bool p_ExampleIsTruePositive(
-        size_t a_targetIdx, size_t a_predIdx,
-        float a_guessConfidence, float a_confidenceCutoff) const;
-    bool p_ExampleIsFalsePositive(
-        size_t a_targetIdx, size_t a_predIdx,
-        float a_guessConfidence, float a_confidenceCutoff) const;
-    bool p_ExampleIsTrueNegative(
-        size_t a_targetIdx, size_t a_predIdx,
-        float a_guessConfidence, float a_confidenceCutoff) const;
-    bool p_ExampleIsFalseNegative(
-        size_t a_targetIdx, size_t a_predIdx,
-        float a_guessConfidence, float a_confidenceCutoff) const;
+    TAccumulatorPtr m_accumulator;
+
+    // Counts tp, fp, tn and fn at a cutoff
+    ConfusionCounts p_CalcConfusionCounts(float a_confidence) const;
+
+    // The metric from counts at a cutoff, throws for metrics that need
+    // more than counts
+    virtual float p_CalculateFromCounts(const ConfusionCounts& a_counts) const;
+
+    // Cutoff the counts are taken at when asked for `a_confidenceLevel`
+    virtual float p_CountsCutoff(float a_confidenceLevel) const;
+
+private:
+    size_t m_topK;
+    bool m_isMultiLabel;
+
+    // Throws unless outputs and targets are same shape matrices with
+    // columns that fit in a record
+    static void p_CheckBatch(
+        const char* a_caller, const TTensorPtr& a_outputs, const TTensorPtr& a_targets);
+
+    // Throws if results have been added, `a_setting` is for the message
+    void p_CheckNoResults(const char* a_setting) const;
 
 };
 
@@ -17,7 +17,8 @@ class Precision : public Metric
 {
 
 public:
-    Precision(size_t a_runningAvgLen = 1000);
+    Precision(size_t a_windowSize = 0);
+    Precision(const TAccumulatorPtr& a_accumulator);
     virtual ~Precision() {};
 
     // name for logging / debugging
@@ -26,6 +27,9 @@ public:
     // calculate the metric
     virtual float Calculate(float a_confidenceLevel = 0.5) const override;
 
+protected:
+    virtual float p_CalculateFromCounts(const ConfusionCounts& a_counts) const override;
+
 private:
     static const std::string NAME;
 
@@ -0,0 +1,99 @@
+/*
+ * Calculate a whole precision recall curve at once given predictions
+ * and targets stored in parent class. Results are sorted by confidence
+ * once, after that every cutoff is a binary search away, and so is the
+ * cutoff that reaches a target precision or recall.
+ * 
+ */
+
+#pragma once
+
+#include "neural/metrics/metric.h"
+#include "neural/metrics/record_accumulator.h"
+
+#include <map>
+#include <vector>
+
+namespace neural
+{
+
+namespace metrics
+{
+
+class PrecisionRecallCurve : public Metric
+{
+
+public:
+    PrecisionRecallCurve(size_t a_windowSize = 0);
+    PrecisionRecallCurve(const TRecordAccumulatorPtr& a_accumulator);
+    virtual ~PrecisionRecallCurve() {};
+
+    // name for logging / debugging
+    virtual const std::string& GetName() const override;
+
+    // calculate the f1 score (harmonic mean of precision and recall)
+    virtual float Calculate(float a_confidenceLevel = 0.5) const override;
+
+    // Points at every distinct confidence in the results, lowest first
+    std::vector<CurvePoint> Points() const;
+
+    // Points at each of the requested cutoffs, in the order given
+    std::vector<CurvePoint> Points(const std::vector<float>& a_cutoffs) const;
+
+    // The threshold searches only consider cutoffs just under a distinct
+    // confidence, so every example at or over it counts as above. They
+    // return false and leave `a_outPoint` alone when no cutoff qualifies.
+
+    // Lowest cutoff (so most recall) with precision >= `a_precision`
+    bool ThresholdAtPrecision(float a_precision, CurvePoint& a_outPoint) const;
+
+    // Highest cutoff (so most precision) with recall >= `a_recall`
+    bool ThresholdAtRecall(float a_recall, CurvePoint& a_outPoint) const;
+
+    // Cutoff with the highest F-beta score, beta > 1 favours recall.
+    // Linear the first time for each beta, remembered after that.
+    bool MaxFBetaThreshold(float a_beta, CurvePoint& a_outPoint) const;
+
+protected:
+    virtual float p_CalculateFromCounts(const ConfusionCounts& a_counts) const override;
+
+private:
+    static const std::string NAME;
+
+    // The curve needs the exact records
+    TRecordAccumulatorPtr m_records;
+
+    // Sorted index over the records, rebuilt lazily after AddResults
+    mutable bool m_hasIndex;
+    mutable size_t m_indexVersion;
+    // all confidences, ascending
+    mutable std::vector<float> m_sortedConfidences;
+    // m_correctBelow[i] = number of correct predictions in the first i
+    // sorted confidences, so it has one more entry than there are records
+    mutable std::vector<size_t> m_correctBelow;
+    // index of the first confidence of every run of equal ones
+    mutable std::vector<size_t> m_runStarts;
+    // best precision with everything from any of the first i run starts
+    // on above the cutoff, never decreases so it can be binary searched
+    mutable std::vector<float> m_bestPrecisionThrough;
+    // MaxFBetaThreshold answers by beta, cleared with the index
+    mutable std::map<float, size_t> m_bestRunByBeta;
+
+    void p_BuildIndex() const;
+
+    // counts at a cutoff by binary searching the index
+    ConfusionCounts p_CountsAt(float a_confidence) const;
+    // counts when the confidences equal to the cutoff are [a_lower, a_upper)
+    ConfusionCounts p_CountsBetween(size_t a_lower, size_t a_upper) const;
+
+    // precision and recall with everything from `a_start` on above the cutoff
+    float p_PrecisionFrom(size_t a_start) const;
+    float p_RecallFrom(size_t a_start) const;
+    // point at the cutoff just under the run starting at `a_start`
+    CurvePoint p_PointUnder(size_t a_start) const;
+
+};
+
+} // namespace metric
+
+} // namespace neural
@@ -0,0 +1,71 @@
+/*
+ * metrics::QuantileSketchAccumulator keeps a KLL sketch of the
+ * confidences of correct predictions and another of incorrect ones.
+ * Memory grows with the log of the number of examples, and counts at any
+ * cutoff are estimates within the sketch's rank error of each.
+ * 
+ */
+
+#pragma once
+
+#include "neural/metrics/accumulator.h"
+#include "neural/metrics/kll_sketch.h"
+
+namespace neural
+{
+
+namespace metrics
+{
+
+class QuantileSketchAccumulator;
+
+typedef std::shared_ptr<QuantileSketchAccumulator> TQuantileSketchAccumulatorPtr;
+
+class QuantileSketchAccumulator : public Accumulator
+{
+
+public:
+    // Larger `a_k` keeps more values and gives smaller errors
+    QuantileSketchAccumulator(size_t a_k = 200);
+    virtual ~QuantileSketchAccumulator() {};
+
+    static TQuantileSketchAccumulatorPtr New(size_t a_k = 200);
+
+    // Identifies sketch state in a serialized stream
+    static const uint32_t SERIAL_TAG = 3;
+
+    virtual ConfusionCounts CalcConfusionCounts(float a_confidence) const override;
+
+    virtual size_t NumExamples() const override;
+
+    // Highest cutoff whose estimated recall is at least `a_recall`,
+    // 0 if nothing has been added
+    float ThresholdForRecall(float a_recall) const;
+
+    size_t K() const;
+
+    // Number of confidences actually kept, over both sketches
+    size_t NumRetained() const;
+
+protected:
+    virtual void p_Add(const PredictionRecord* a_records, size_t a_numRecords) override;
+
+    // Merges the sketches, both must have the same k
+    virtual void p_Merge(const Accumulator& a_other) override;
+
+    virtual uint32_t p_SerialTag() const override;
+    virtual void p_Serialize(std::ostream& a_stream) const override;
+    virtual void p_Deserialize(std::istream& a_stream) override;
+
+private:
+    KllSketch m_correct;
+    KllSketch m_incorrect;
+
+    static void p_WriteSketch(std::ostream& a_stream, const KllSketch& a_sketch);
+    static void p_ReadSketch(std::istream& a_stream, KllSketch& a_sketch);
+
+};
+
+} // namespace metrics
+
+} // namespace neural
@@ -17,7 +17,8 @@ class Recall : public Metric
 {
 
 public:
-    Recall(size_t a_runningAvgLen = 1000);
+    Recall(size_t a_windowSize = 0);
+    Recall(const TAccumulatorPtr& a_accumulator);
     virtual ~Recall() {};
 
     // name for logging / debugging
@@ -26,6 +27,9 @@ public:
     // calculate the metric
     virtual float Calculate(float a_confidence = 0.5) const override;
 
+protected:
+    virtual float p_CalculateFromCounts(const ConfusionCounts& a_counts) const override;
+
 private:
     static const std::string NAME;
 
@@ -0,0 +1,80 @@
+/*
+ * metrics::RecordAccumulator keeps one exact record per example, either
+ * for every example or for a sliding window of the most recent ones
+ * 
+ */
+
+#pragma once
+
+#include "neural/metrics/accumulator.h"
+
+#include <vector>
+
+namespace neural
+{
+
+namespace metrics
+{
+
+class RecordAccumulator;
+
+typedef std::shared_ptr<RecordAccumulator> TRecordAccumulatorPtr;
+
+class RecordAccumulator : public Accumulator
+{
+
+public:
+    // Keep the last `a_windowSize` examples, or every example if it is 0
+    RecordAccumulator(size_t a_windowSize = 0);
+    virtual ~RecordAccumulator() {};
+
+    static TRecordAccumulatorPtr New(size_t a_windowSize = 0);
+
+    // Identifies record state in a serialized stream
+    static const uint32_t SERIAL_TAG = 1;
+
+    // Counts either from a tracked cutoff or in a single pass over the records
+    virtual ConfusionCounts CalcConfusionCounts(float a_confidence) const override;
+
+    // Keep counts at this cutoff up to date as records come and go,
+    // so calculating at it is O(1) instead of a scan over the window
+    virtual void TrackCutoff(float a_confidence) override;
+
+    virtual size_t NumExamples() const override;
+
+    // Copy of the records in the window, oldest first
+    std::vector<PredictionRecord> Records() const;
+
+    // The records in the window in no particular order
+    const std::vector<PredictionRecord>& UnorderedRecords() const;
+
+protected:
+    virtual void p_Add(const PredictionRecord* a_records, size_t a_numRecords) override;
+
+    // Appends the other records after ours, oldest first, so a window
+    // keeps the most recent of the combined records
+    virtual void p_Merge(const Accumulator& a_other) override;
+
+    virtual uint32_t p_SerialTag() const override;
+    virtual void p_Serialize(std::ostream& a_stream) const override;
+    virtual void p_Deserialize(std::istream& a_stream) override;
+
+private:
+    // Maximum number of examples to keep, 0 for unbounded
+    size_t m_windowSize;
+    // Ring buffer of records. It grows until it holds `m_windowSize`
+    // records, after that the oldest one at `m_oldestRecord` is overwritten.
+    std::vector<PredictionRecord> m_records;
+    size_t m_oldestRecord;
+
+    // Cutoffs registered with TrackCutoff and the live counts at each
+    std::vector<float> m_trackedCutoffs;
+    std::vector<ConfusionCounts> m_trackedCounts;
+
+    void p_AddRecord(const PredictionRecord& a_record);
+
+};
+
+} // namespace metrics
+
+} // namespace neural
@@ -0,0 +1,105 @@
+/*
+ * Arena is a bump allocator for tensors that live a single training
+ * iteration. Allocating moves a cursor, freeing does nothing, and
+ * rewinding the cursor frees everything allocated since in O(1).
+ *
+ * ArenaScope makes the calling thread's arena the default resource for
+ * its lifetime, so every Tensor created inside the scope comes from the
+ * arena, and rewinds it on the way out. Tensors allocated in a scope
+ * must not be used after it ends.
+ *
+ */
+
+#pragma once
+
+#include "neural/util/memory_pool.h"
+
+#include <vector>
+
+namespace neural
+{
+
+class Arena : public MemoryResource
+{
+public:
+    // Where the cursor is, to rewind to later
+    struct Mark
+    {
+        size_t m_chunk;
+        size_t m_offset;
+    };
+
+    // a_chunkBytes is the size of each region taken from the MemoryPool,
+    // allocations larger than that get a region of their own
+    Arena(size_t a_chunkBytes = DEFAULT_CHUNK_BYTES);
+    ~Arena();
+
+    // The calling thread's arena, used by ArenaScope
+    static Arena* ThreadArena();
+
+    Mark GetMark() const;
+
+    // Frees everything allocated after a_mark
+    void Rewind(const Mark& a_mark);
+
+    // Frees everything. If the last round needed more than one region
+    // they get merged into one so the next round fits in it.
+    void Reset();
+
+    // Bytes handed out since the last Reset, including alignment padding
+    size_t NumBytesUsed() const;
+
+    // Bytes held in regions
+    size_t NumBytesReserved() const;
+
+    size_t NumChunks() const;
+
+    static const size_t DEFAULT_CHUNK_BYTES = 1 << 20;
+
+protected:
+    virtual void* p_Allocate(size_t a_bytes) override;
+    virtual void p_Deallocate(void* a_ptr, size_t a_bytes) override;
+
+private:
+    struct Chunk
+    {
+        char* m_data;
+        size_t m_size;
+    };
+
+    size_t m_chunkBytes;
+    std::vector<Chunk> m_chunks;
+    size_t m_chunkIdx;
+    size_t m_offset;
+
+    // non copyable, chunks are owned
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+    Chunk p_NewChunk(size_t a_bytes) const;
+    void p_FreeChunk(const Chunk& a_chunk) const;
+};
+
+class ArenaScope
+{
+public:
+    // Routes this thread's allocations to its arena until destroyed
+    ArenaScope();
+
+    // Same with a caller owned arena
+    explicit ArenaScope(Arena* a_arena);
+
+    // Rewinds the arena to where it was when the scope was entered and
+    // restores the previous default. The outermost scope resets it.
+    ~ArenaScope();
+
+private:
+    Arena* m_arena;
+    Arena::Mark m_mark;
+    MemoryResource* m_previous;
+
+    ArenaScope(const ArenaScope&);
+    ArenaScope& operator=(const ArenaScope&);
+};
+
+} // namespace neural
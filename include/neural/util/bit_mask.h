@@ -0,0 +1,33 @@
+/*
+ * Compare a run of floats against one value into packed bits, and count
+ * them. Uses SSE / AVX compares and movemask when the compiler targets
+ * them, plain loops otherwise, and both give the same bits.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace neural
+{
+
+class BitMask
+{
+public:
+    // Number of 64 bit words to hold `a_size` bits
+    static size_t NumWords(size_t a_size);
+
+    // Bit i of `a_outBits` is a_values[i] > a_value, unused high bits of
+    // the last word are cleared. NaN is never greater.
+    static void Greater(
+        const float* a_values, size_t a_size, float a_value, uint64_t* a_outBits);
+
+    // Number of a_values[i] > a_value, without writing the bits out
+    static size_t CountGreater(const float* a_values, size_t a_size, float a_value);
+
+    static size_t PopCount(const uint64_t* a_bits, size_t a_numWords);
+};
+
+} // namespace neural
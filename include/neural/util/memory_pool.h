@@ -0,0 +1,157 @@
+/*
+ * Where tensor storage comes from. A MemoryResource hands out raw
+ * buffers, StorageAllocator adapts one to std::vector, and MemoryPool
+ * is the default resource: 64 byte aligned blocks in power of two size
+ * classes that get recycled instead of going back to malloc.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace neural
+{
+
+class MemoryResource
+{
+public:
+    virtual ~MemoryResource() {}
+
+    // Buffer of at least a_bytes, aligned to ALIGNMENT
+    void* Allocate(size_t a_bytes);
+
+    // Gives back a buffer from Allocate, a_bytes must match
+    void Deallocate(void* a_ptr, size_t a_bytes);
+
+    // Resource new storage comes from on this thread: the thread's own
+    // default if one is set, otherwise the process wide one, which is
+    // the MemoryPool unless replaced
+    static MemoryResource* Default();
+
+    // Swap in another resource, returns the previous one. Storage
+    // already handed out remembers the resource it came from.
+    static MemoryResource* SetDefault(MemoryResource* a_resource);
+
+    // Same for the calling thread only, nullptr falls back to the
+    // process wide default. Returns the previous thread default.
+    static MemoryResource* SetThreadDefault(MemoryResource* a_resource);
+
+    // Cache line, and wide enough for any SIMD load we issue
+    static const size_t ALIGNMENT = 64;
+
+protected:
+    virtual void* p_Allocate(size_t a_bytes) = 0;
+    virtual void p_Deallocate(void* a_ptr, size_t a_bytes) = 0;
+};
+
+class MemoryPool : public MemoryResource
+{
+public:
+    // The process wide pool, never destroyed so storage can be
+    // released from static destructors and exiting threads
+    static MemoryPool* Instance();
+
+    // Number of times the pool had to go to the system for a block
+    size_t NumSystemAllocations() const;
+
+    // Bytes sitting in the shared free lists
+    size_t NumCachedBytes() const;
+
+    // Returns every block in the shared free lists, and the calling
+    // thread's cache, to the system
+    void Trim();
+
+    // Smallest size class, one cache line
+    static const size_t MIN_CLASS_BITS = 6;
+    static const size_t NUM_CLASSES = 48;
+
+    // A thread keeps up to this many bytes per size class to itself
+    // before freed blocks go to the shared lists
+    static const size_t THREAD_CACHE_BYTES = 4 << 20;
+
+protected:
+    virtual void* p_Allocate(size_t a_bytes) override;
+    virtual void p_Deallocate(void* a_ptr, size_t a_bytes) override;
+
+private:
+    MemoryPool();
+
+    std::atomic<size_t> m_numSystemAllocations;
+    std::atomic<size_t> m_numCachedBytes;
+    mutable std::mutex m_mutex;
+    std::vector<void*> m_freeLists[NUM_CLASSES];
+
+    friend class MemoryPoolThreadCache;
+    void p_Release(size_t a_class, std::vector<void*>& a_blocks);
+
+    static size_t p_SizeClass(size_t a_bytes);
+};
+
+// std::vector allocator drawing from a MemoryResource. Copies of a
+// container pick up the current default rather than the source's.
+template <typename T>
+class StorageAllocator
+{
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    StorageAllocator()
+        : m_resource(MemoryResource::Default())
+    {
+    }
+
+    StorageAllocator(MemoryResource* a_resource)
+        : m_resource(a_resource)
+    {
+    }
+
+    template <typename U>
+    StorageAllocator(const StorageAllocator<U>& a_other)
+        : m_resource(a_other.Resource())
+    {
+    }
+
+    T* allocate(size_t a_count)
+    {
+        return static_cast<T*>(m_resource->Allocate(a_count * sizeof(T)));
+    }
+
+    void deallocate(T* a_ptr, size_t a_count)
+    {
+        m_resource->Deallocate(a_ptr, a_count * sizeof(T));
+    }
+
+    StorageAllocator select_on_container_copy_construction() const
+    {
+        return StorageAllocator();
+    }
+
+    MemoryResource* Resource() const
+    {
+        return m_resource;
+    }
+
+private:
+    MemoryResource* m_resource;
+};
+
+template <typename T, typename U>
+bool operator==(const StorageAllocator<T>& a_lhs, const StorageAllocator<U>& a_rhs)
+{
+    return a_lhs.Resource() == a_rhs.Resource();
+}
+
+template <typename T, typename U>
+bool operator!=(const StorageAllocator<T>& a_lhs, const StorageAllocator<U>& a_rhs)
+{
+    return !(a_lhs == a_rhs);
+}
+
+} // namespace neural
@@ -0,0 +1,66 @@
+/*
+ * Parallel helpers on top of OpenMP. Everything still works, on
+ * one thread, when we are built without it.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+namespace neural
+{
+
+class Parallel
+{
+public:
+    // Number of threads a parallel region will use
+    static size_t NumThreads();
+
+    // Boundaries splitting [0, a_size) into `a_numChunks` contiguous ranges
+    // of nearly equal size, chunk i is [bounds[i], bounds[i+1])
+    static std::vector<size_t> ChunkBounds(size_t a_size, size_t a_numChunks);
+
+    // Sorts one chunk per thread, then merges neighbouring runs in
+    // parallel rounds until there is one run left. Not stable.
+    template <typename T, typename Compare>
+    static void Sort(std::vector<T>& a_data, Compare a_compare);
+};
+
+template <typename T, typename Compare>
+void Parallel::Sort(std::vector<T>& a_data, Compare a_compare)
+{
+    // not worth waking threads up for small inputs
+    size_t l_numChunks = std::min(NumThreads(), a_data.size() / 4096 + 1);
+    std::vector<size_t> l_bounds = ChunkBounds(a_data.size(), l_numChunks);
+
+    #pragma omp parallel for schedule(static, 1)
+    for (int i = 0; i < (int)l_numChunks; ++i)
+    {
+        std::sort(a_data.begin() + l_bounds[i], a_data.begin() + l_bounds[i + 1], a_compare);
+    }
+
+    // each round merges runs [i, i + width) and [i + width, i + 2*width)
+    std::vector<T> l_buffer(a_data.size());
+    for (size_t l_width = 1; l_width < l_numChunks; l_width *= 2)
+    {
+        int l_numPairs = (int)((l_numChunks + (2 * l_width) - 1) / (2 * l_width));
+
+        #pragma omp parallel for schedule(static, 1)
+        for (int i = 0; i < l_numPairs; ++i)
+        {
+            size_t l_first = i * 2 * l_width;
+            size_t l_begin = l_bounds[l_first];
+            size_t l_mid = l_bounds[std::min(l_first + l_width, l_numChunks)];
+            size_t l_end = l_bounds[std::min(l_first + (2 * l_width), l_numChunks)];
+            std::merge(
+                a_data.begin() + l_begin, a_data.begin() + l_mid,
+                a_data.begin() + l_mid, a_data.begin() + l_end,
+                l_buffer.begin() + l_begin, a_compare);
+        }
+        a_data.swap(l_buffer);
+    }
+}
+
+} // namespace neural
@@ -0,0 +1,256 @@
+/*
+ * Accumulator Implementation
+ *
+ */
+
+#include "neural/metrics/accumulator.h"
+#include "neural/metrics/record_accumulator.h"
+#include "neural/metrics/binned_precision_recall.h"
+#include "neural/metrics/quantile_sketch_accumulator.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <typeinfo>
+
+using namespace std;
+
+namespace neural
+{
+
+namespace metrics
+{
+
+CurvePoint CurvePoint::FromCounts(
+    float a_confidence, const ConfusionCounts& a_counts)
+{
+    float l_tp = static_cast<float>(a_counts.truePositives);
+    float l_fp = static_cast<float>(a_counts.falsePositives);
+    float l_fn = static_cast<float>(a_counts.falseNegatives);
+
+    CurvePoint l_point;
+    l_point.threshold = a_confidence;
+    l_point.precision = (0.0f == l_tp + l_fp) ? 0.0f : l_tp / (l_tp + l_fp);
+    l_point.recall = (0.0f == l_tp + l_fn) ? 0.0f : l_tp / (l_tp + l_fn);
+    return l_point;
+}
+
+// "NMAC" as the first bytes of the stream
+const uint64_t Accumulator::SERIAL_MAGIC = 0x43414d4e;
+const uint64_t Accumulator::SERIAL_FORMAT_VERSION = 1;
+
+// Write the low `a_numBytes` of a value, least significant byte first
+static void WriteLittleEndian(std::ostream& a_stream, uint64_t a_val, size_t a_numBytes)
+{
+    char l_bytes[8];
+    for (size_t i = 0; i < a_numBytes; ++i)
+    {
+        l_bytes[i] = static_cast<char>((a_val >> (8 * i)) & 0xff);
+    }
+    a_stream.write(l_bytes, a_numBytes);
+}
+
+static uint64_t ReadLittleEndian(std::istream& a_stream, size_t a_numBytes)
+{
+    unsigned char l_bytes[8];
+    a_stream.read(reinterpret_cast<char*>(l_bytes), a_numBytes);
+    if (!a_stream)
+    {
+        throw(runtime_error("Accumulator::Deserialize unexpected end of stream"));
+    }
+
+    uint64_t l_val = 0;
+    for (size_t i = 0; i < a_numBytes; ++i)
+    {
+        l_val |= static_cast<uint64_t>(l_bytes[i]) << (8 * i);
+    }
+    return l_val;
+}
+
+Accumulator::Accumulator()
+    : m_version(0)
+    , m_shardedVersion(false)
+{
+
+}
+
+void Accumulator::Add(const PredictionRecord* a_records, size_t a_numRecords)
+{
+    p_Add(a_records, a_numRecords);
+    if (!m_shardedVersion)
+    {
+        m_version.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Accumulator::Merge(const Accumulator& a_other)
+{
+    if (typeid(*this) != typeid(a_other))
+    {
+        stringstream l_ss;
+        l_ss << "Accumulator::Merge cannot merge a " << typeid(a_other).name()
+             << " into a " << typeid(*this).name();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    p_Merge(a_other);
+    m_version.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Accumulator::Serialize(std::ostream& a_stream) const
+{
+    p_WriteU64(a_stream, SERIAL_MAGIC);
+    p_WriteU64(a_stream, SERIAL_FORMAT_VERSION);
+    p_WriteU64(a_stream, p_SerialTag());
+    p_Serialize(a_stream);
+}
+
+void Accumulator::Deserialize(std::istream& a_stream)
+{
+    uint32_t l_tag = p_ReadHeader(a_stream);
+    if (l_tag != p_SerialTag())
+    {
+        stringstream l_ss;
+        l_ss << "Accumulator::Deserialize state was written by type " << l_tag
+             << " not " << p_SerialTag();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    p_Deserialize(a_stream);
+    m_version.fetch_add(1, std::memory_order_relaxed);
+}
+
+TAccumulatorPtr Accumulator::Load(std::istream& a_stream)
+{
+    uint32_t l_tag = p_ReadHeader(a_stream);
+
+    TAccumulatorPtr l_accumulator;
+    if (l_tag == RecordAccumulator::SERIAL_TAG)
+    {
+        l_accumulator = RecordAccumulator::New();
+    }
+    else if (l_tag == BinnedPrecisionRecall::SERIAL_TAG)
+    {
+        l_accumulator = BinnedPrecisionRecall::New();
+    }
+    else if (l_tag == QuantileSketchAccumulator::SERIAL_TAG)
+    {
+        l_accumulator = QuantileSketchAccumulator::New();
+    }
+    else
+    {
+        stringstream l_ss;
+        l_ss << "Accumulator::Load unknown accumulator type " << l_tag;
+        throw(runtime_error(l_ss.str()));
+    }
+
+    l_accumulator->p_Deserialize(a_stream);
+    return l_accumulator;
+}
+
+size_t Accumulator::Version() const
+{
+    return m_version.load(std::memory_order_relaxed);
+}
+
+size_t* Accumulator::p_CounterFor(
+    const PredictionRecord& a_record, float a_confidence,
+    ConfusionCounts& a_counts)
+{
+    bool l_isCorrect = (a_record.target == a_record.prediction);
+    if (a_record.confidence > a_confidence)
+    {
+        // above confidence threshold
+        return l_isCorrect ? &a_counts.truePositives : &a_counts.falsePositives;
+    }
+    else if (a_record.confidence < a_confidence)
+    {
+        // below confidence threshold
+        return l_isCorrect ? &a_counts.falseNegatives : &a_counts.trueNegatives;
+    }
+    return nullptr;
+}
+
+void Accumulator::p_WriteU64(std::ostream& a_stream, uint64_t a_val)
+{
+    WriteLittleEndian(a_stream, a_val, 8);
+}
+
+void Accumulator::p_WriteF32(std::ostream& a_stream, float a_val)
+{
+    uint32_t l_bits;
+    memcpy(&l_bits, &a_val, sizeof(l_bits));
+    WriteLittleEndian(a_stream, l_bits, 4);
+}
+
+void Accumulator::p_WriteRecord(
+    std::ostream& a_stream, const PredictionRecord& a_record)
+{
+    // 8 bytes, same as in memory
+    WriteLittleEndian(a_stream, a_record.target, 2);
+    WriteLittleEndian(a_stream, a_record.prediction, 2);
+    p_WriteF32(a_stream, a_record.confidence);
+}
+
+void Accumulator::p_WriteCounts(
+    std::ostream& a_stream, const ConfusionCounts& a_counts)
+{
+    p_WriteU64(a_stream, a_counts.truePositives);
+    p_WriteU64(a_stream, a_counts.falsePositives);
+    p_WriteU64(a_stream, a_counts.trueNegatives);
+    p_WriteU64(a_stream, a_counts.falseNegatives);
+}
+
+uint64_t Accumulator::p_ReadU64(std::istream& a_stream)
+{
+    return ReadLittleEndian(a_stream, 8);
+}
+
+float Accumulator::p_ReadF32(std::istream& a_stream)
+{
+    uint32_t l_bits = static_cast<uint32_t>(ReadLittleEndian(a_stream, 4));
+    float l_val;
+    memcpy(&l_val, &l_bits, sizeof(l_val));
+    return l_val;
+}
+
+PredictionRecord Accumulator::p_ReadRecord(std::istream& a_stream)
+{
+    PredictionRecord l_record;
+    l_record.target = static_cast<uint16_t>(ReadLittleEndian(a_stream, 2));
+    l_record.prediction = static_cast<uint16_t>(ReadLittleEndian(a_stream, 2));
+    l_record.confidence = p_ReadF32(a_stream);
+    return l_record;
+}
+
+ConfusionCounts Accumulator::p_ReadCounts(std::istream& a_stream)
+{
+    ConfusionCounts l_counts;
+    l_counts.truePositives = p_ReadU64(a_stream);
+    l_counts.falsePositives = p_ReadU64(a_stream);
+    l_counts.trueNegatives = p_ReadU64(a_stream);
+    l_counts.falseNegatives = p_ReadU64(a_stream);
+    return l_counts;
+}
+
+uint32_t Accumulator::p_ReadHeader(std::istream& a_stream)
+{
+    if (p_ReadU64(a_stream) != SERIAL_MAGIC)
+    {
+        throw(runtime_error("Accumulator::Deserialize stream does not hold accumulator state"));
+    }
+
+    uint64_t l_formatVersion = p_ReadU64(a_stream);
+    if (l_formatVersion != SERIAL_FORMAT_VERSION)
+    {
+        stringstream l_ss;
+        l_ss << "Accumulator::Deserialize unsupported format version " << l_formatVersion;
+        throw(runtime_error(l_ss.str()));
+    }
+
+    return static_cast<uint32_t>(p_ReadU64(a_stream));
+}
+
+} // namespace metrics
+
+} // namespace neural
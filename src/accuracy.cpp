@@ -17,10 +17,18 @@ namespace metrics
 
 const std::string Accuracy::NAME = "accuracy";
 
-Accuracy::Accuracy(size_t a_runningAvgLen)
-    : Metric(a_runningAvgLen)
+Accuracy::Accuracy(size_t a_windowSize)
+    : Metric(a_windowSize)
 {
+    // keep the default cutoff O(1) to calculate
+    TrackCutoff(0.0);
+}
 
+Accuracy::Accuracy(const TAccumulatorPtr& a_accumulator)
+    : Metric(a_accumulator)
+{
+    // keep the default cutoff O(1) to calculate
+    TrackCutoff(0.0);
 }
 
 // name for logging / debugging
@@ -32,10 +40,15 @@ const std::string& Accuracy::GetName() const
 // calculate the metric
 float Accuracy::Calculate(float a_confidenceLevel) const
 {
-    float l_tp = static_cast<float>(p_CalcNumTruePositives(0.0));
-    float l_fp = static_cast<float>(p_CalcNumFalsePositives(0.0));
-    float l_tn = static_cast<float>(p_CalcNumTrueNegatives(0.0));
-    float l_fn = static_cast<float>(p_CalcNumFalseNegatives(0.0));
+    return p_CalculateFromCounts(p_CalcConfusionCounts(p_CountsCutoff(a_confidenceLevel)));
+}
+
+float Accuracy::p_CalculateFromCounts(const ConfusionCounts& a_counts) const
+{
+    float l_tp = static_cast<float>(a_counts.truePositives);
+    float l_fp = static_cast<float>(a_counts.falsePositives);
+    float l_tn = static_cast<float>(a_counts.trueNegatives);
+    float l_fn = static_cast<float>(a_counts.falseNegatives);
 
     // avoid NaN
     if (0.0f == l_tp and 0.0 == l_tn and 0.0f == l_fp and 0.0f == l_fn)
@@ -46,6 +59,12 @@ float Accuracy::Calculate(float a_confidenceLevel) const
     return (l_tp + l_tn) / (l_tp + l_tn + l_fp + l_fn);
 }
 
+float Accuracy::p_CountsCutoff(float a_confidenceLevel) const
+{
+    // every label needs a cutoff to be a yes or a no
+    return IsMultiLabel() ? a_confidenceLevel : 0.0f;
+}
+
 } // namespace metric
 
 } // namespace neural
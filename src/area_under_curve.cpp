@@ -0,0 +1,254 @@
+/*
+ * Area Under Curve Implementation
+ *
+ */
+
+#include "neural/metrics/area_under_curve.h"
+#include "neural/util/parallel.h"
+
+
+using namespace std;
+
+namespace neural
+{
+
+namespace metrics
+{
+
+const std::string AreaUnderCurve::NAME = "average_precision";
+
+AreaUnderCurve::AreaUnderCurve(size_t a_windowSize)
+    : AreaUnderCurve(RecordAccumulator::New(a_windowSize))
+{
+
+}
+
+AreaUnderCurve::AreaUnderCurve(const TRecordAccumulatorPtr& a_accumulator)
+    : Metric(a_accumulator)
+    , m_records(a_accumulator)
+    , m_hasSummaries(false)
+    , m_summariesVersion(0)
+{
+
+}
+
+// name for logging / debugging
+const std::string& AreaUnderCurve::GetName() const
+{
+    return NAME;
+}
+
+// calculate the metric
+float AreaUnderCurve::Calculate(float a_confidenceLevel) const
+{
+    return AveragePrecision();
+}
+
+float AreaUnderCurve::RocAuc() const
+{
+    p_BuildSummaries();
+    return m_overall.rocAuc;
+}
+
+float AreaUnderCurve::AveragePrecision() const
+{
+    p_BuildSummaries();
+    return m_overall.averagePrecision;
+}
+
+float AreaUnderCurve::RocAuc(size_t a_class) const
+{
+    p_BuildSummaries();
+    return (a_class < m_perClass.size()) ? m_perClass[a_class].rocAuc : 0.0f;
+}
+
+float AreaUnderCurve::AveragePrecision(size_t a_class) const
+{
+    p_BuildSummaries();
+    return (a_class < m_perClass.size()) ? m_perClass[a_class].averagePrecision : 0.0f;
+}
+
+float AreaUnderCurve::MacroRocAuc() const
+{
+    p_BuildSummaries();
+
+    float l_sum = 0.0f;
+    size_t l_numDefined = 0;
+    for (size_t i = 0; i < m_perClass.size(); ++i)
+    {
+        if (m_perClass[i].numCorrect > 0 && m_perClass[i].numIncorrect > 0)
+        {
+            l_sum += m_perClass[i].rocAuc;
+            ++l_numDefined;
+        }
+    }
+    return (0 == l_numDefined) ? 0.0f : l_sum / l_numDefined;
+}
+
+float AreaUnderCurve::MacroAveragePrecision() const
+{
+    p_BuildSummaries();
+
+    float l_sum = 0.0f;
+    size_t l_numDefined = 0;
+    for (size_t i = 0; i < m_perClass.size(); ++i)
+    {
+        if (m_perClass[i].numCorrect > 0)
+        {
+            l_sum += m_perClass[i].averagePrecision;
+            ++l_numDefined;
+        }
+    }
+    return (0 == l_numDefined) ? 0.0f : l_sum / l_numDefined;
+}
+
+void AreaUnderCurve::p_BuildSummaries() const
+{
+    if (m_hasSummaries && m_summariesVersion == m_records->Version())
+    {
+        return;
+    }
+
+    // most confident first
+    vector<PredictionRecord> l_sorted(m_records->UnorderedRecords());
+    Parallel::Sort(l_sorted,
+        [](const PredictionRecord& a_lhs, const PredictionRecord& a_rhs)
+        {
+            return a_lhs.confidence > a_rhs.confidence;
+        });
+    m_overall = p_Summarize(l_sorted.data(), l_sorted.size());
+
+    // grouped by class, most confident first within each class
+    Parallel::Sort(l_sorted,
+        [](const PredictionRecord& a_lhs, const PredictionRecord& a_rhs)
+        {
+            if (a_lhs.prediction != a_rhs.prediction)
+            {
+                return a_lhs.prediction < a_rhs.prediction;
+            }
+            return a_lhs.confidence > a_rhs.confidence;
+        });
+
+    m_perClass.clear();
+    size_t l_begin = 0;
+    while (l_begin < l_sorted.size())
+    {
+        size_t l_class = l_sorted[l_begin].prediction;
+        size_t l_end = l_begin;
+        while (l_end < l_sorted.size() && l_sorted[l_end].prediction == l_class)
+        {
+            ++l_end;
+        }
+
+        // classes that were never predicted get all zeros
+        Summary l_empty = {0, 0, 0.0f, 0.0f};
+        m_perClass.resize(l_class + 1, l_empty);
+        m_perClass[l_class] = p_Summarize(&l_sorted[l_begin], l_end - l_begin);
+        l_begin = l_end;
+    }
+
+    m_hasSummaries = true;
+    m_summariesVersion = m_records->Version();
+}
+
+AreaUnderCurve::Summary AreaUnderCurve::p_Summarize(
+    const PredictionRecord* a_sorted, size_t a_numRecords)
+{
+    // split into one chunk per thread, then move the boundaries forward
+    // so runs of equal confidence never straddle two chunks
+    size_t l_numChunks = std::min(Parallel::NumThreads(), a_numRecords / 4096 + 1);
+    vector<size_t> l_bounds = Parallel::ChunkBounds(a_numRecords, l_numChunks);
+    for (size_t i = 1; i < l_numChunks; ++i)
+    {
+        l_bounds[i] = std::max(l_bounds[i], l_bounds[i - 1]);
+        while (l_bounds[i] > 0 && l_bounds[i] < a_numRecords &&
+               a_sorted[l_bounds[i]].confidence == a_sorted[l_bounds[i] - 1].confidence)
+        {
+            ++l_bounds[i];
+        }
+    }
+
+    // count correct and incorrect per chunk
+    vector<size_t> l_chunkCorrect(l_numChunks, 0);
+    vector<size_t> l_chunkIncorrect(l_numChunks, 0);
+
+    #pragma omp parallel for schedule(static, 1)
+    for (int i = 0; i < (int)l_numChunks; ++i)
+    {
+        for (size_t j = l_bounds[i]; j < l_bounds[i + 1]; ++j)
+        {
+            if (a_sorted[j].target == a_sorted[j].prediction) ++l_chunkCorrect[i];
+            else ++l_chunkIncorrect[i];
+        }
+    }
+
+    // exclusive prefix sums give every chunk the counts above it
+    vector<size_t> l_correctAbove(l_numChunks, 0);
+    vector<size_t> l_incorrectAbove(l_numChunks, 0);
+    Summary l_summary = {0, 0, 0.0f, 0.0f};
+    for (size_t i = 0; i < l_numChunks; ++i)
+    {
+        l_correctAbove[i] = l_summary.numCorrect;
+        l_incorrectAbove[i] = l_summary.numIncorrect;
+        l_summary.numCorrect += l_chunkCorrect[i];
+        l_summary.numIncorrect += l_chunkIncorrect[i];
+    }
+
+    // sweep every chunk from its starting counts, one run of equal
+    // confidences at a time
+    vector<double> l_chunkPairs(l_numChunks, 0.0);
+    vector<double> l_chunkPrecisionSum(l_numChunks, 0.0);
+
+    #pragma omp parallel for schedule(static, 1)
+    for (int i = 0; i < (int)l_numChunks; ++i)
+    {
+        double l_correct = static_cast<double>(l_correctAbove[i]);
+        double l_incorrect = static_cast<double>(l_incorrectAbove[i]);
+        size_t j = l_bounds[i];
+        while (j < l_bounds[i + 1])
+        {
+            double l_runCorrect = 0.0;
+            double l_runIncorrect = 0.0;
+            float l_confidence = a_sorted[j].confidence;
+            for (; j < l_bounds[i + 1] && a_sorted[j].confidence == l_confidence; ++j)
+            {
+                if (a_sorted[j].target == a_sorted[j].prediction) l_runCorrect += 1.0;
+                else l_runIncorrect += 1.0;
+            }
+
+            // incorrect ones in this run rank below every correct one
+            // above it and tie with the correct ones in it
+            l_chunkPairs[i] += l_runIncorrect * (l_correct + (0.5 * l_runCorrect));
+
+            l_correct += l_runCorrect;
+            l_incorrect += l_runIncorrect;
+
+            // recall goes up by l_runCorrect / numCorrect at this precision
+            l_chunkPrecisionSum[i] += l_runCorrect * (l_correct / (l_correct + l_incorrect));
+        }
+    }
+
+    double l_pairs = 0.0;
+    double l_precisionSum = 0.0;
+    for (size_t i = 0; i < l_numChunks; ++i)
+    {
+        l_pairs += l_chunkPairs[i];
+        l_precisionSum += l_chunkPrecisionSum[i];
+    }
+
+    if (l_summary.numCorrect > 0 && l_summary.numIncorrect > 0)
+    {
+        l_summary.rocAuc = static_cast<float>(
+            l_pairs / (static_cast<double>(l_summary.numCorrect) * l_summary.numIncorrect));
+    }
+    if (l_summary.numCorrect > 0)
+    {
+        l_summary.averagePrecision = static_cast<float>(
+            l_precisionSum / l_summary.numCorrect);
+    }
+    return l_summary;
+}
+
+} // namespace metric
+
+} // namespace neural
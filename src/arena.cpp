@@ -0,0 +1,176 @@
+/*
+ * Arena Implementation
+ *
+ */
+
+#include "neural/util/arena.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace neural
+{
+
+const size_t Arena::DEFAULT_CHUNK_BYTES;
+
+Arena::Arena(size_t a_chunkBytes)
+    : m_chunkBytes(std::max(a_chunkBytes, ALIGNMENT))
+    , m_chunkIdx(0)
+    , m_offset(0)
+{
+}
+
+Arena::~Arena()
+{
+    for (const Chunk& l_chunk : m_chunks)
+    {
+        p_FreeChunk(l_chunk);
+    }
+}
+
+Arena* Arena::ThreadArena()
+{
+    static thread_local Arena l_arena;
+    return &l_arena;
+}
+
+Arena::Mark Arena::GetMark() const
+{
+    Mark l_mark;
+    l_mark.m_chunk = m_chunkIdx;
+    l_mark.m_offset = m_offset;
+    return l_mark;
+}
+
+void Arena::Rewind(const Mark& a_mark)
+{
+    m_chunkIdx = a_mark.m_chunk;
+    m_offset = a_mark.m_offset;
+}
+
+void Arena::Reset()
+{
+    // spilled into more than one region, replace them all with one
+    // region big enough for the whole round
+    if (m_chunkIdx > 0)
+    {
+        size_t l_total = 0;
+        for (const Chunk& l_chunk : m_chunks)
+        {
+            l_total += l_chunk.m_size;
+            p_FreeChunk(l_chunk);
+        }
+        m_chunks.clear();
+        m_chunks.push_back(p_NewChunk(l_total));
+    }
+
+    m_chunkIdx = 0;
+    m_offset = 0;
+}
+
+size_t Arena::NumBytesUsed() const
+{
+    if (m_chunks.empty())
+    {
+        return 0;
+    }
+
+    size_t l_used = m_offset;
+    for (size_t i = 0; i < m_chunkIdx; ++i)
+    {
+        l_used += m_chunks[i].m_size;
+    }
+    return l_used;
+}
+
+size_t Arena::NumBytesReserved() const
+{
+    size_t l_reserved = 0;
+    for (const Chunk& l_chunk : m_chunks)
+    {
+        l_reserved += l_chunk.m_size;
+    }
+    return l_reserved;
+}
+
+size_t Arena::NumChunks() const
+{
+    return m_chunks.size();
+}
+
+void* Arena::p_Allocate(size_t a_bytes)
+{
+    // keep every allocation aligned by rounding sizes up
+    size_t l_bytes = std::max(ALIGNMENT, ((a_bytes + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT);
+
+    while (true)
+    {
+        if (m_chunkIdx < m_chunks.size() &&
+            m_offset + l_bytes <= m_chunks[m_chunkIdx].m_size)
+        {
+            void* l_ptr = m_chunks[m_chunkIdx].m_data + m_offset;
+            m_offset += l_bytes;
+            return l_ptr;
+        }
+
+        // move on to the next region, reusing it if it is big enough
+        size_t l_next = m_chunkIdx < m_chunks.size() ? m_chunkIdx + 1 : m_chunkIdx;
+        if (l_next == m_chunks.size())
+        {
+            m_chunks.push_back(p_NewChunk(std::max(m_chunkBytes, l_bytes)));
+        }
+        else if (m_chunks[l_next].m_size < l_bytes)
+        {
+            p_FreeChunk(m_chunks[l_next]);
+            m_chunks[l_next] = p_NewChunk(std::max(m_chunkBytes, l_bytes));
+        }
+        m_chunkIdx = l_next;
+        m_offset = 0;
+    }
+}
+
+void Arena::p_Deallocate(void* a_ptr, size_t a_bytes)
+{
+    // freed all at once by Rewind or Reset
+}
+
+Arena::Chunk Arena::p_NewChunk(size_t a_bytes) const
+{
+    Chunk l_chunk;
+    l_chunk.m_data = static_cast<char*>(MemoryPool::Instance()->Allocate(a_bytes));
+    l_chunk.m_size = a_bytes;
+    return l_chunk;
+}
+
+void Arena::p_FreeChunk(const Chunk& a_chunk) const
+{
+    MemoryPool::Instance()->Deallocate(a_chunk.m_data, a_chunk.m_size);
+}
+
+ArenaScope::ArenaScope()
+    : ArenaScope(Arena::ThreadArena())
+{
+}
+
+ArenaScope::ArenaScope(Arena* a_arena)
+    : m_arena(a_arena)
+    , m_mark(a_arena->GetMark())
+    , m_previous(MemoryResource::SetThreadDefault(a_arena))
+{
+}
+
+ArenaScope::~ArenaScope()
+{
+    MemoryResource::SetThreadDefault(m_previous);
+    if (0 == m_mark.m_chunk && 0 == m_mark.m_offset)
+    {
+        m_arena->Reset();
+    }
+    else
+    {
+        m_arena->Rewind(m_mark);
+    }
+}
+
+} // namespace neural
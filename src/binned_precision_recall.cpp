@@ -0,0 +1,304 @@
+/*
+ * BinnedPrecisionRecall Implementation
+ *
+ */
+
+#include "neural/metrics/binned_precision_recall.h"
+
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace neural
+{
+
+namespace metrics
+{
+
+BinnedPrecisionRecall::BinnedPrecisionRecall(size_t a_numBins)
+    : m_numBins(a_numBins)
+    , m_numExamples(0)
+    , m_hasSums(false)
+    , m_sumsVersion(0)
+{
+    if (0 == m_numBins)
+    {
+        throw(runtime_error("BinnedPrecisionRecall needs at least one bin"));
+    }
+}
+
+TBinnedPrecisionRecallPtr BinnedPrecisionRecall::New(size_t a_numBins)
+{
+    return TBinnedPrecisionRecallPtr(new BinnedPrecisionRecall(a_numBins));
+}
+
+ConfusionCounts BinnedPrecisionRecall::CalcConfusionCounts(float a_confidence) const
+{
+    p_BuildSums();
+    return p_CountsFromBin(NumClasses(), p_CutoffBin(a_confidence));
+}
+
+ConfusionCounts BinnedPrecisionRecall::CalcConfusionCounts(
+    float a_confidence, size_t a_class) const
+{
+    if (a_class >= NumClasses())
+    {
+        // nothing was ever predicted as this class
+        ConfusionCounts l_counts = {0, 0, 0, 0};
+        return l_counts;
+    }
+
+    p_BuildSums();
+    return p_CountsFromBin(a_class, p_CutoffBin(a_confidence));
+}
+
+size_t BinnedPrecisionRecall::NumExamples() const
+{
+    return m_numExamples;
+}
+
+std::vector<CurvePoint> BinnedPrecisionRecall::Points() const
+{
+    p_BuildSums();
+    return p_PointsForRow(NumClasses());
+}
+
+std::vector<CurvePoint> BinnedPrecisionRecall::Points(size_t a_class) const
+{
+    if (a_class >= NumClasses())
+    {
+        stringstream l_ss;
+        l_ss << "BinnedPrecisionRecall::Points class " << a_class
+             << " >= " << NumClasses();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    p_BuildSums();
+    return p_PointsForRow(a_class);
+}
+
+size_t BinnedPrecisionRecall::NumBins() const
+{
+    return m_numBins;
+}
+
+float BinnedPrecisionRecall::BinWidth() const
+{
+    return 1.0f / static_cast<float>(m_numBins);
+}
+
+size_t BinnedPrecisionRecall::NumClasses() const
+{
+    return m_correct.size() / m_numBins;
+}
+
+void BinnedPrecisionRecall::p_Add(
+    const PredictionRecord* a_records, size_t a_numRecords)
+{
+    for (size_t i = 0; i < a_numRecords; ++i)
+    {
+        const PredictionRecord& l_record = a_records[i];
+
+        // grow the histograms the first time we see a class
+        if (l_record.prediction >= NumClasses())
+        {
+            p_GrowToClasses(l_record.prediction + 1);
+        }
+
+        size_t l_idx = (l_record.prediction * m_numBins) + p_BinFor(l_record.confidence);
+        if (l_record.target == l_record.prediction)
+        {
+            ++m_correct[l_idx];
+        }
+        else
+        {
+            ++m_incorrect[l_idx];
+        }
+    }
+    m_numExamples += a_numRecords;
+}
+
+void BinnedPrecisionRecall::p_Merge(const Accumulator& a_other)
+{
+    const BinnedPrecisionRecall& l_other =
+        static_cast<const BinnedPrecisionRecall&>(a_other);
+    if (l_other.m_numBins != m_numBins)
+    {
+        stringstream l_ss;
+        l_ss << "BinnedPrecisionRecall::Merge number of bins "
+             << l_other.m_numBins << " != " << m_numBins;
+        throw(runtime_error(l_ss.str()));
+    }
+
+    if (l_other.NumClasses() > NumClasses())
+    {
+        p_GrowToClasses(l_other.NumClasses());
+    }
+
+    for (size_t i = 0; i < l_other.m_correct.size(); ++i)
+    {
+        m_correct[i] += l_other.m_correct[i];
+        m_incorrect[i] += l_other.m_incorrect[i];
+    }
+    m_numExamples += l_other.m_numExamples;
+}
+
+uint32_t BinnedPrecisionRecall::p_SerialTag() const
+{
+    return SERIAL_TAG;
+}
+
+void BinnedPrecisionRecall::p_Serialize(std::ostream& a_stream) const
+{
+    p_WriteU64(a_stream, m_numBins);
+    p_WriteU64(a_stream, NumClasses());
+    p_WriteU64(a_stream, m_numExamples);
+    for (size_t i = 0; i < m_correct.size(); ++i)
+    {
+        p_WriteU64(a_stream, m_correct[i]);
+        p_WriteU64(a_stream, m_incorrect[i]);
+    }
+}
+
+void BinnedPrecisionRecall::p_Deserialize(std::istream& a_stream)
+{
+    // the sizes are checked and the histograms read into locals first, so
+    // a corrupt stream throws and leaves this accumulator as it was
+    size_t l_numBins = p_ReadU64(a_stream);
+    if (0 == l_numBins)
+    {
+        throw(runtime_error("BinnedPrecisionRecall::Deserialize needs at least one bin"));
+    }
+
+    // predictions are 16 bit
+    size_t l_numClasses = p_ReadU64(a_stream);
+    if (l_numClasses > static_cast<size_t>(numeric_limits<uint16_t>::max()) + 1)
+    {
+        stringstream l_ss;
+        l_ss << "BinnedPrecisionRecall::Deserialize too many classes " << l_numClasses;
+        throw(runtime_error(l_ss.str()));
+    }
+    if (l_numClasses > 0 && l_numBins > numeric_limits<size_t>::max() / l_numClasses)
+    {
+        stringstream l_ss;
+        l_ss << "BinnedPrecisionRecall::Deserialize " << l_numClasses << " classes of "
+             << l_numBins << " bins is too many";
+        throw(runtime_error(l_ss.str()));
+    }
+
+    size_t l_numExamples = p_ReadU64(a_stream);
+
+    // grown as values arrive rather than allocated up front, so memory
+    // never runs ahead of what the stream actually holds
+    size_t l_size = l_numClasses * l_numBins;
+    vector<size_t> l_correct;
+    vector<size_t> l_incorrect;
+    for (size_t i = 0; i < l_size; ++i)
+    {
+        l_correct.push_back(p_ReadU64(a_stream));
+        l_incorrect.push_back(p_ReadU64(a_stream));
+    }
+
+    m_numBins = l_numBins;
+    m_numExamples = l_numExamples;
+    m_correct.swap(l_correct);
+    m_incorrect.swap(l_incorrect);
+    m_hasSums = false;
+}
+
+void BinnedPrecisionRecall::p_GrowToClasses(size_t a_numClasses)
+{
+    m_correct.resize(a_numClasses * m_numBins, 0);
+    m_incorrect.resize(a_numClasses * m_numBins, 0);
+}
+
+size_t BinnedPrecisionRecall::p_BinFor(float a_confidence) const
+{
+    // written so NaN lands in the first bin
+    if (!(a_confidence > 0.0f))
+    {
+        return 0;
+    }
+
+    size_t l_bin = static_cast<size_t>(a_confidence * static_cast<float>(m_numBins));
+    return (l_bin < m_numBins) ? l_bin : m_numBins - 1;
+}
+
+size_t BinnedPrecisionRecall::p_CutoffBin(float a_confidence) const
+{
+    // nothing is over a cutoff of 1.0 or more
+    if (a_confidence >= 1.0f)
+    {
+        return m_numBins;
+    }
+    return p_BinFor(a_confidence);
+}
+
+void BinnedPrecisionRecall::p_BuildSums() const
+{
+    if (m_hasSums && m_sumsVersion == Version())
+    {
+        return;
+    }
+
+    size_t l_numClasses = NumClasses();
+    size_t l_rowLen = m_numBins + 1;
+    m_correctFromBin.assign((l_numClasses + 1) * l_rowLen, 0);
+    m_incorrectFromBin.assign((l_numClasses + 1) * l_rowLen, 0);
+
+    size_t* l_correctTotal = &m_correctFromBin[l_numClasses * l_rowLen];
+    size_t* l_incorrectTotal = &m_incorrectFromBin[l_numClasses * l_rowLen];
+    for (size_t i = 0; i < l_numClasses; ++i)
+    {
+        const size_t* l_correct = &m_correct[i * m_numBins];
+        const size_t* l_incorrect = &m_incorrect[i * m_numBins];
+        size_t* l_correctSums = &m_correctFromBin[i * l_rowLen];
+        size_t* l_incorrectSums = &m_incorrectFromBin[i * l_rowLen];
+
+        // sum from the top bin down, the extra last entry stays 0
+        for (size_t j = m_numBins; j > 0; --j)
+        {
+            l_correctSums[j - 1] = l_correctSums[j] + l_correct[j - 1];
+            l_incorrectSums[j - 1] = l_incorrectSums[j] + l_incorrect[j - 1];
+            l_correctTotal[j - 1] += l_correctSums[j - 1];
+            l_incorrectTotal[j - 1] += l_incorrectSums[j - 1];
+        }
+    }
+
+    m_hasSums = true;
+    m_sumsVersion = Version();
+}
+
+ConfusionCounts BinnedPrecisionRecall::p_CountsFromBin(
+    size_t a_sumsRow, size_t a_bin) const
+{
+    const size_t* l_correctSums = &m_correctFromBin[a_sumsRow * (m_numBins + 1)];
+    const size_t* l_incorrectSums = &m_incorrectFromBin[a_sumsRow * (m_numBins + 1)];
+
+    // bins from a_bin up are above the cutoff, the rest are below it
+    ConfusionCounts l_counts;
+    l_counts.truePositives = l_correctSums[a_bin];
+    l_counts.falsePositives = l_incorrectSums[a_bin];
+    l_counts.falseNegatives = l_correctSums[0] - l_correctSums[a_bin];
+    l_counts.trueNegatives = l_incorrectSums[0] - l_incorrectSums[a_bin];
+    return l_counts;
+}
+
+std::vector<CurvePoint> BinnedPrecisionRecall::p_PointsForRow(size_t a_sumsRow) const
+{
+    vector<CurvePoint> l_points;
+    l_points.reserve(m_numBins);
+    for (size_t i = 0; i < m_numBins; ++i)
+    {
+        float l_edge = static_cast<float>(i) * BinWidth();
+        l_points.push_back(CurvePoint::FromCounts(
+            l_edge, p_CountsFromBin(a_sumsRow, i)));
+    }
+    return l_points;
+}
+
+} // namespace metrics
+
+} // namespace neural
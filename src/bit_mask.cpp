@@ -0,0 +1,103 @@
+/*
+ * Bit Mask Implementation
+ *
+ */
+
+#include "neural/util/bit_mask.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace neural
+{
+
+namespace
+{
+
+inline size_t PopCount64(uint64_t a_word)
+{
+    return static_cast<size_t>(__builtin_popcountll(a_word));
+}
+
+// Mask of the next 8 values, bit j is a_values[j] > a_value
+inline uint64_t Greater8(const float* a_values, float a_value)
+{
+#if defined(__AVX__)
+    __m256 l_cmp = _mm256_cmp_ps(
+        _mm256_loadu_ps(a_values), _mm256_set1_ps(a_value), _CMP_GT_OQ);
+    return static_cast<uint64_t>(_mm256_movemask_ps(l_cmp));
+#elif defined(__SSE2__)
+    __m128 l_value = _mm_set1_ps(a_value);
+    uint64_t l_low = _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(a_values), l_value));
+    uint64_t l_high = _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(a_values + 4), l_value));
+    return l_low | (l_high << 4);
+#else
+    uint64_t l_bits = 0;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        l_bits |= static_cast<uint64_t>(a_values[i] > a_value) << i;
+    }
+    return l_bits;
+#endif
+}
+
+} // namespace
+
+size_t BitMask::NumWords(size_t a_size)
+{
+    return (a_size + 63) / 64;
+}
+
+void BitMask::Greater(
+    const float* a_values, size_t a_size, float a_value, uint64_t* a_outBits)
+{
+    size_t l_numWords = NumWords(a_size);
+    for (size_t l_word = 0; l_word < l_numWords; ++l_word)
+    {
+        size_t l_begin = l_word * 64;
+        size_t l_end = (l_begin + 64 < a_size) ? l_begin + 64 : a_size;
+
+        uint64_t l_bits = 0;
+        size_t i = l_begin;
+        for (; i + 8 <= l_end; i += 8)
+        {
+            l_bits |= Greater8(a_values + i, a_value) << (i - l_begin);
+        }
+        // tail of the whole run
+        for (; i < l_end; ++i)
+        {
+            l_bits |= static_cast<uint64_t>(a_values[i] > a_value) << (i - l_begin);
+        }
+        a_outBits[l_word] = l_bits;
+    }
+}
+
+size_t BitMask::CountGreater(const float* a_values, size_t a_size, float a_value)
+{
+    size_t l_count = 0;
+    size_t i = 0;
+    for (; i + 8 <= a_size; i += 8)
+    {
+        l_count += PopCount64(Greater8(a_values + i, a_value));
+    }
+    for (; i < a_size; ++i)
+    {
+        l_count += (a_values[i] > a_value) ? 1 : 0;
+    }
+    return l_count;
+}
+
+size_t BitMask::PopCount(const uint64_t* a_bits, size_t a_numWords)
+{
+    size_t l_count = 0;
+    for (size_t i = 0; i < a_numWords; ++i)
+    {
+        l_count += PopCount64(a_bits[i]);
+    }
+    return l_count;
+}
+
+} // namespace neural
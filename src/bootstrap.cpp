@@ -0,0 +1,188 @@
+/*
+ * Bootstrap Implementation
+ *
+ */
+
+#include "neural/metrics/bootstrap.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace neural
+{
+
+namespace metrics
+{
+
+// A record's category is (slot * 2) + isCorrect, where slot says where
+// its confidence is among the sorted cutoffs: 2i if it is between cutoff
+// i - 1 and cutoff i, 2i + 1 if it is equal to cutoff i. NaN confidences
+// are neither above nor below anything, they get one extra category.
+
+std::vector<BootstrapInterval> Bootstrap::Intervals(
+    const std::vector<PredictionRecord>& a_records,
+    const std::vector<float>& a_cutoffs,
+    const TCalculateFn& a_calculate,
+    size_t a_numReplicates,
+    float a_level,
+    uint64_t a_seed)
+{
+    if (0 == a_numReplicates)
+    {
+        throw(runtime_error("Bootstrap::Intervals needs at least one replicate"));
+    }
+    if (!(a_level > 0.0f && a_level < 1.0f))
+    {
+        stringstream l_ss;
+        l_ss << "Bootstrap::Intervals level " << a_level << " not in (0, 1)";
+        throw(runtime_error(l_ss.str()));
+    }
+    // draws scale a 32 bit random number by the number of records
+    if (a_records.size() > numeric_limits<uint32_t>::max())
+    {
+        stringstream l_ss;
+        l_ss << "Bootstrap::Intervals too many records " << a_records.size();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    vector<float> l_cutoffs(a_cutoffs);
+    std::sort(l_cutoffs.begin(), l_cutoffs.end());
+    l_cutoffs.erase(std::unique(l_cutoffs.begin(), l_cutoffs.end()), l_cutoffs.end());
+    size_t l_numCutoffs = l_cutoffs.size();
+    size_t l_nanCategory = 2 * ((2 * l_numCutoffs) + 1);
+    size_t l_numCategories = l_nanCategory + 1;
+
+    size_t l_numRecords = a_records.size();
+    vector<uint32_t> l_categories(l_numRecords);
+
+    // up to 2^32 records, more than an int counts
+    #pragma omp parallel for
+    for (int64_t i = 0; i < (int64_t)l_numRecords; ++i)
+    {
+        const PredictionRecord& l_record = a_records[i];
+        if (l_record.confidence != l_record.confidence)
+        {
+            l_categories[i] = static_cast<uint32_t>(l_nanCategory);
+            continue;
+        }
+
+        size_t l_idx = std::lower_bound(l_cutoffs.begin(), l_cutoffs.end(), l_record.confidence) -
+            l_cutoffs.begin();
+        bool l_isEqual = (l_idx < l_numCutoffs && l_cutoffs[l_idx] == l_record.confidence);
+        size_t l_slot = (2 * l_idx) + (l_isEqual ? 1 : 0);
+        bool l_isCorrect = (l_record.target == l_record.prediction);
+        l_categories[i] = static_cast<uint32_t>((2 * l_slot) + (l_isCorrect ? 1 : 0));
+    }
+
+    // the point estimate is the same calculation over every record once,
+    // done first so a calculation that throws does so outside the threads
+    vector<size_t> l_fullHistogram(l_numCategories, 0);
+    for (size_t i = 0; i < l_numRecords; ++i)
+    {
+        ++l_fullHistogram[l_categories[i]];
+    }
+
+    vector<BootstrapInterval> l_sortedIntervals(l_numCutoffs);
+    for (size_t j = 0; j < l_numCutoffs; ++j)
+    {
+        l_sortedIntervals[j].threshold = l_cutoffs[j];
+        l_sortedIntervals[j].value = a_calculate(p_CountsFromHistogram(l_fullHistogram, j));
+    }
+
+    // values[(replicate * l_numCutoffs) + cutoff]
+    vector<float> l_values(a_numReplicates * l_numCutoffs);
+
+    #pragma omp parallel
+    {
+        // reused by every replicate this thread runs
+        vector<size_t> l_histogram(l_numCategories);
+
+        #pragma omp for schedule(static)
+        for (int64_t l_replicate = 0; l_replicate < (int64_t)a_numReplicates; ++l_replicate)
+        {
+            std::fill(l_histogram.begin(), l_histogram.end(), 0);
+            uint64_t l_counter = static_cast<uint64_t>(l_replicate) * l_numRecords;
+            for (size_t i = 0; i < l_numRecords; ++i)
+            {
+                uint64_t l_draw = ((p_Random(a_seed, l_counter + i) >> 32) * l_numRecords) >> 32;
+                ++l_histogram[l_categories[l_draw]];
+            }
+
+            for (size_t j = 0; j < l_numCutoffs; ++j)
+            {
+                l_values[(l_replicate * l_numCutoffs) + j] =
+                    a_calculate(p_CountsFromHistogram(l_histogram, j));
+            }
+        }
+    }
+
+    float l_tail = (1.0f - a_level) / 2.0f;
+    size_t l_lowerIdx = static_cast<size_t>(l_tail * (a_numReplicates - 1) + 0.5f);
+    size_t l_upperIdx = static_cast<size_t>((1.0f - l_tail) * (a_numReplicates - 1) + 0.5f);
+
+    vector<float> l_column(a_numReplicates);
+    for (size_t j = 0; j < l_numCutoffs; ++j)
+    {
+        for (size_t l_replicate = 0; l_replicate < a_numReplicates; ++l_replicate)
+        {
+            l_column[l_replicate] = l_values[(l_replicate * l_numCutoffs) + j];
+        }
+        std::sort(l_column.begin(), l_column.end());
+
+        l_sortedIntervals[j].lower = l_column[l_lowerIdx];
+        l_sortedIntervals[j].upper = l_column[l_upperIdx];
+    }
+
+    vector<BootstrapInterval> l_intervals;
+    l_intervals.reserve(a_cutoffs.size());
+    for (float l_cutoff : a_cutoffs)
+    {
+        size_t l_idx = std::lower_bound(l_cutoffs.begin(), l_cutoffs.end(), l_cutoff) -
+            l_cutoffs.begin();
+        l_intervals.push_back(l_sortedIntervals[l_idx]);
+    }
+    return l_intervals;
+}
+
+uint64_t Bootstrap::p_Random(uint64_t a_seed, uint64_t a_counter)
+{
+    uint64_t l_z = a_seed + ((a_counter + 1) * 0x9e3779b97f4a7c15ULL);
+    l_z = (l_z ^ (l_z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    l_z = (l_z ^ (l_z >> 27)) * 0x94d049bb133111ebULL;
+    return l_z ^ (l_z >> 31);
+}
+
+ConfusionCounts Bootstrap::p_CountsFromHistogram(
+    const std::vector<size_t>& a_histogram, size_t a_cutoff)
+{
+    // slots up to 2 * a_cutoff are below it, 2 * a_cutoff + 1 is on it
+    // and everything after that is above it
+    size_t l_equalSlot = (2 * a_cutoff) + 1;
+
+    // the last category is the NaN one, it is never counted
+    ConfusionCounts l_counts = {0, 0, 0, 0};
+    for (size_t l_slot = 0; ((2 * l_slot) + 1) < a_histogram.size(); ++l_slot)
+    {
+        size_t l_numIncorrect = a_histogram[2 * l_slot];
+        size_t l_numCorrect = a_histogram[(2 * l_slot) + 1];
+        if (l_slot < l_equalSlot)
+        {
+            l_counts.falseNegatives += l_numCorrect;
+            l_counts.trueNegatives += l_numIncorrect;
+        }
+        else if (l_slot > l_equalSlot)
+        {
+            l_counts.truePositives += l_numCorrect;
+            l_counts.falsePositives += l_numIncorrect;
+        }
+    }
+    return l_counts;
+}
+
+} // namespace metrics
+
+} // namespace neural
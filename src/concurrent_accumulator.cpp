@@ -0,0 +1,235 @@
+/*
+ * ConcurrentAccumulator Implementation
+ *
+ */
+
+#include "neural/metrics/concurrent_accumulator.h"
+#include "neural/metrics/record_accumulator.h"
+
+#include <unordered_map>
+
+using namespace std;
+
+namespace neural
+{
+
+namespace metrics
+{
+
+static TAccumulatorPtr NewRecordShard()
+{
+    return RecordAccumulator::New();
+}
+
+// Source of ConcurrentAccumulator::m_id
+static std::atomic<uint64_t> s_nextAccumulatorId(1);
+
+struct ConcurrentAccumulator::ThreadRegistry
+{
+    // only contended when an accumulator is destroyed
+    std::mutex lock;
+    std::unordered_map<uint64_t, Shard*> shards;
+};
+
+ConcurrentAccumulator::ConcurrentAccumulator()
+    : ConcurrentAccumulator(NewRecordShard)
+{
+
+}
+
+ConcurrentAccumulator::ConcurrentAccumulator(const TShardFactory& a_newShard)
+    : m_newShard(a_newShard)
+    , m_id(s_nextAccumulatorId.fetch_add(1))
+    , m_retiredVersions(0)
+{
+    m_shardedVersion = true;
+}
+
+ConcurrentAccumulator::~ConcurrentAccumulator()
+{
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        {
+            lock_guard<mutex> l_guard(m_shards[i]->registry->lock);
+            m_shards[i]->registry->shards.erase(m_id);
+        }
+        delete m_shards[i];
+    }
+}
+
+TConcurrentAccumulatorPtr ConcurrentAccumulator::New()
+{
+    return TConcurrentAccumulatorPtr(new ConcurrentAccumulator());
+}
+
+TConcurrentAccumulatorPtr ConcurrentAccumulator::New(const TShardFactory& a_newShard)
+{
+    return TConcurrentAccumulatorPtr(new ConcurrentAccumulator(a_newShard));
+}
+
+ConfusionCounts ConcurrentAccumulator::CalcConfusionCounts(float a_confidence) const
+{
+    ConfusionCounts l_total = {0, 0, 0, 0};
+
+    lock_guard<mutex> l_shardsGuard(m_shardsLock);
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        lock_guard<mutex> l_guard(m_shards[i]->lock);
+        ConfusionCounts l_counts =
+            m_shards[i]->accumulator->CalcConfusionCounts(a_confidence);
+        l_total.truePositives += l_counts.truePositives;
+        l_total.falsePositives += l_counts.falsePositives;
+        l_total.trueNegatives += l_counts.trueNegatives;
+        l_total.falseNegatives += l_counts.falseNegatives;
+    }
+    return l_total;
+}
+
+void ConcurrentAccumulator::TrackCutoff(float a_confidence)
+{
+    lock_guard<mutex> l_shardsGuard(m_shardsLock);
+    m_trackedCutoffs.push_back(a_confidence);
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        lock_guard<mutex> l_guard(m_shards[i]->lock);
+        m_shards[i]->accumulator->TrackCutoff(a_confidence);
+    }
+}
+
+size_t ConcurrentAccumulator::NumExamples() const
+{
+    size_t l_numExamples = 0;
+
+    lock_guard<mutex> l_shardsGuard(m_shardsLock);
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        lock_guard<mutex> l_guard(m_shards[i]->lock);
+        l_numExamples += m_shards[i]->accumulator->NumExamples();
+    }
+    return l_numExamples;
+}
+
+size_t ConcurrentAccumulator::Version() const
+{
+    lock_guard<mutex> l_shardsGuard(m_shardsLock);
+    size_t l_version = Accumulator::Version() + m_retiredVersions;
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        lock_guard<mutex> l_guard(m_shards[i]->lock);
+        l_version += m_shards[i]->accumulator->Version();
+    }
+    return l_version;
+}
+
+TAccumulatorPtr ConcurrentAccumulator::Snapshot() const
+{
+    TAccumulatorPtr l_snapshot = m_newShard();
+
+    lock_guard<mutex> l_shardsGuard(m_shardsLock);
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        lock_guard<mutex> l_guard(m_shards[i]->lock);
+        l_snapshot->Merge(*m_shards[i]->accumulator);
+    }
+    return l_snapshot;
+}
+
+size_t ConcurrentAccumulator::NumShards() const
+{
+    lock_guard<mutex> l_shardsGuard(m_shardsLock);
+    return m_shards.size();
+}
+
+void ConcurrentAccumulator::p_Add(
+    const PredictionRecord* a_records, size_t a_numRecords)
+{
+    // only ever contended by a reader combining shards
+    Shard& l_shard = p_ThreadShard();
+    lock_guard<mutex> l_guard(l_shard.lock);
+    l_shard.accumulator->Add(a_records, a_numRecords);
+}
+
+void ConcurrentAccumulator::p_Merge(const Accumulator& a_other)
+{
+    const ConcurrentAccumulator& l_other =
+        static_cast<const ConcurrentAccumulator&>(a_other);
+    TAccumulatorPtr l_otherSnapshot = l_other.Snapshot();
+
+    Shard& l_shard = p_ThreadShard();
+    lock_guard<mutex> l_guard(l_shard.lock);
+    l_shard.accumulator->Merge(*l_otherSnapshot);
+}
+
+uint32_t ConcurrentAccumulator::p_SerialTag() const
+{
+    return m_newShard()->p_SerialTag();
+}
+
+void ConcurrentAccumulator::p_Serialize(std::ostream& a_stream) const
+{
+    Snapshot()->p_Serialize(a_stream);
+}
+
+void ConcurrentAccumulator::p_Deserialize(std::istream& a_stream)
+{
+    TAccumulatorPtr l_loaded = m_newShard();
+    l_loaded->p_Deserialize(a_stream);
+
+    // threads hold on to their shards, so empty them rather than
+    // deleting them, and give the loaded state to the calling thread
+    Shard& l_threadShard = p_ThreadShard();
+    lock_guard<mutex> l_shardsGuard(m_shardsLock);
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        TAccumulatorPtr l_empty = (m_shards[i] == &l_threadShard) ? l_loaded : m_newShard();
+        for (size_t j = 0; j < m_trackedCutoffs.size(); ++j)
+        {
+            l_empty->TrackCutoff(m_trackedCutoffs[j]);
+        }
+
+        lock_guard<mutex> l_guard(m_shards[i]->lock);
+        m_retiredVersions += m_shards[i]->accumulator->Version();
+        m_shards[i]->accumulator = l_empty;
+    }
+}
+
+ConcurrentAccumulator::Shard& ConcurrentAccumulator::p_ThreadShard()
+{
+    // Entries are keyed by id rather than `this`, which a newer
+    // accumulator may reuse, and erased when the accumulator goes away
+    static thread_local TThreadRegistryPtr t_registry(new ThreadRegistry());
+
+    {
+        lock_guard<mutex> l_guard(t_registry->lock);
+        unordered_map<uint64_t, Shard*>::const_iterator l_found = t_registry->shards.find(m_id);
+        if (l_found != t_registry->shards.end())
+        {
+            return *l_found->second;
+        }
+    }
+
+    Shard* l_shard = p_NewShard();
+    l_shard->registry = t_registry;
+
+    lock_guard<mutex> l_guard(t_registry->lock);
+    t_registry->shards[m_id] = l_shard;
+    return *l_shard;
+}
+
+ConcurrentAccumulator::Shard* ConcurrentAccumulator::p_NewShard()
+{
+    Shard* l_shard = new Shard();
+    l_shard->accumulator = m_newShard();
+
+    lock_guard<mutex> l_shardsGuard(m_shardsLock);
+    for (size_t i = 0; i < m_trackedCutoffs.size(); ++i)
+    {
+        l_shard->accumulator->TrackCutoff(m_trackedCutoffs[i]);
+    }
+    m_shards.push_back(l_shard);
+    return l_shard;
+}
+
+} // namespace metrics
+
+} // namespace neural
@@ -0,0 +1,229 @@
+/*
+ * ConfusionMatrix Implementation
+ *
+ */
+
+#include "neural/metrics/confusion_matrix.h"
+#include "neural/metrics/metric.h"
+
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace neural
+{
+
+namespace metrics
+{
+
+ConfusionMatrix::ConfusionMatrix(size_t a_numClasses)
+    : m_numClasses(a_numClasses)
+    , m_numExamples(0)
+    , m_counts(a_numClasses * a_numClasses, 0)
+    , m_confidenceSums(a_numClasses * a_numClasses, 0.0)
+    , m_targetTotals(a_numClasses, 0)
+    , m_predictionTotals(a_numClasses, 0)
+{
+
+}
+
+void ConfusionMatrix::AddResults(
+    const TTensorPtr& a_outputs, const TTensorPtr& a_targets)
+{
+    if (a_outputs->Shape().size() != 2 || a_outputs->Shape().at(1) != m_numClasses)
+    {
+        stringstream l_ss;
+        l_ss << "ConfusionMatrix::AddResults expected " << m_numClasses
+             << " columns, got " << a_outputs->ShapeStr();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    // same single pass over the rows the other metrics use
+    static thread_local std::vector<PredictionRecord> l_batchRecords;
+    Metric::ReduceRows(a_outputs, a_targets, l_batchRecords);
+    Add(l_batchRecords.data(), l_batchRecords.size());
+}
+
+void ConfusionMatrix::Add(const PredictionRecord* a_records, size_t a_numRecords)
+{
+    for (size_t i = 0; i < a_numRecords; ++i)
+    {
+        const PredictionRecord& l_record = a_records[i];
+        if (l_record.target >= m_numClasses || l_record.prediction >= m_numClasses)
+        {
+            stringstream l_ss;
+            l_ss << "ConfusionMatrix::Add record of class " << l_record.target
+                 << " predicted as " << l_record.prediction
+                 << " outside of " << m_numClasses << " classes";
+            throw(runtime_error(l_ss.str()));
+        }
+    }
+
+    for (size_t i = 0; i < a_numRecords; ++i)
+    {
+        const PredictionRecord& l_record = a_records[i];
+        size_t l_idx = (l_record.target * m_numClasses) + l_record.prediction;
+        ++m_counts[l_idx];
+        m_confidenceSums[l_idx] += l_record.confidence;
+        ++m_targetTotals[l_record.target];
+        ++m_predictionTotals[l_record.prediction];
+    }
+    m_numExamples += a_numRecords;
+}
+
+void ConfusionMatrix::Merge(const ConfusionMatrix& a_other)
+{
+    if (a_other.m_numClasses != m_numClasses)
+    {
+        stringstream l_ss;
+        l_ss << "ConfusionMatrix::Merge number of classes "
+             << a_other.m_numClasses << " != " << m_numClasses;
+        throw(runtime_error(l_ss.str()));
+    }
+
+    for (size_t i = 0; i < m_counts.size(); ++i)
+    {
+        m_counts[i] += a_other.m_counts[i];
+        m_confidenceSums[i] += a_other.m_confidenceSums[i];
+    }
+    for (size_t i = 0; i < m_numClasses; ++i)
+    {
+        m_targetTotals[i] += a_other.m_targetTotals[i];
+        m_predictionTotals[i] += a_other.m_predictionTotals[i];
+    }
+    m_numExamples += a_other.m_numExamples;
+}
+
+size_t ConfusionMatrix::NumClasses() const
+{
+    return m_numClasses;
+}
+
+size_t ConfusionMatrix::NumExamples() const
+{
+    return m_numExamples;
+}
+
+size_t ConfusionMatrix::Count(size_t a_target, size_t a_prediction) const
+{
+    p_CheckClass(a_target);
+    p_CheckClass(a_prediction);
+    return m_counts[(a_target * m_numClasses) + a_prediction];
+}
+
+float ConfusionMatrix::MeanConfidence(size_t a_target, size_t a_prediction) const
+{
+    size_t l_count = Count(a_target, a_prediction);
+    if (0 == l_count)
+    {
+        return 0.0f;
+    }
+    return static_cast<float>(
+        m_confidenceSums[(a_target * m_numClasses) + a_prediction] / l_count);
+}
+
+float ConfusionMatrix::Precision(size_t a_class) const
+{
+    // correct out of everything predicted as this class
+    p_CheckClass(a_class);
+    return p_Ratio(Count(a_class, a_class), m_predictionTotals[a_class]);
+}
+
+float ConfusionMatrix::Recall(size_t a_class) const
+{
+    // correct out of everything that really was this class
+    p_CheckClass(a_class);
+    return p_Ratio(Count(a_class, a_class), m_targetTotals[a_class]);
+}
+
+float ConfusionMatrix::F1(size_t a_class) const
+{
+    return p_HarmonicMean(Precision(a_class), Recall(a_class));
+}
+
+float ConfusionMatrix::MacroPrecision() const
+{
+    float l_sum = 0.0f;
+    for (size_t i = 0; i < m_numClasses; ++i)
+    {
+        l_sum += Precision(i);
+    }
+    return (0 == m_numClasses) ? 0.0f : l_sum / m_numClasses;
+}
+
+float ConfusionMatrix::MacroRecall() const
+{
+    float l_sum = 0.0f;
+    for (size_t i = 0; i < m_numClasses; ++i)
+    {
+        l_sum += Recall(i);
+    }
+    return (0 == m_numClasses) ? 0.0f : l_sum / m_numClasses;
+}
+
+float ConfusionMatrix::MacroF1() const
+{
+    float l_sum = 0.0f;
+    for (size_t i = 0; i < m_numClasses; ++i)
+    {
+        l_sum += F1(i);
+    }
+    return (0 == m_numClasses) ? 0.0f : l_sum / m_numClasses;
+}
+
+float ConfusionMatrix::MicroPrecision() const
+{
+    // every example is predicted as exactly one class, so pooled
+    // tp + fp is the number of examples
+    size_t l_correct = 0;
+    for (size_t i = 0; i < m_numClasses; ++i)
+    {
+        l_correct += m_counts[(i * m_numClasses) + i];
+    }
+    return p_Ratio(l_correct, m_numExamples);
+}
+
+float ConfusionMatrix::MicroRecall() const
+{
+    // and every example has exactly one target, so pooled tp + fn is too
+    return MicroPrecision();
+}
+
+float ConfusionMatrix::MicroF1() const
+{
+    return p_HarmonicMean(MicroPrecision(), MicroRecall());
+}
+
+void ConfusionMatrix::p_CheckClass(size_t a_class) const
+{
+    if (a_class >= m_numClasses)
+    {
+        stringstream l_ss;
+        l_ss << "ConfusionMatrix class " << a_class << " >= " << m_numClasses;
+        throw(runtime_error(l_ss.str()));
+    }
+}
+
+float ConfusionMatrix::p_Ratio(size_t a_numerator, size_t a_denominator)
+{
+    if (0 == a_denominator)
+    {
+        return 0.0f;
+    }
+    return static_cast<float>(a_numerator) / static_cast<float>(a_denominator);
+}
+
+float ConfusionMatrix::p_HarmonicMean(float a_lhs, float a_rhs)
+{
+    // avoid NaN
+    if (0.0f == a_lhs and 0.0f == a_rhs)
+    {
+        return 0.0f;
+    }
+    return (2.0f * a_lhs * a_rhs) / (a_lhs + a_rhs);
+}
+
+} // namespace metrics
+
+} // namespace neural
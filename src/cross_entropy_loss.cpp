@@ -3,6 +3,8 @@
  */
 
 #include "neural/loss/cross_entropy_loss.h"
+#include "neural/math/expression.h"
+#include "neural/math/tensor_t.h"
 
 #include <glog/logging.h>
 
@@ -34,57 +36,63 @@ float CrossEntropyLoss::Forward(
     -1/n * sum((y * log(yhat)) + ((1-y) * log(1-yhat)))
     */
 
-    float l_error = 0.0;
-    for (size_t i = 0; i < a_inputs->Shape().at(0); ++i)
+    if (!a_inputs->HasSameShape(a_targets))
     {
-        for (size_t j = 0; j < a_inputs->Shape().at(1); ++j)
-        {
-            float y = a_targets->At({i,j}); // target
-            float yhat = a_inputs->At({i,j}); // predicted
-
-            // if y == 0 then we take the second half of the equation
-            // if y == 1 then we take the first half
-            // log(1) = 0
-            // log(0.1) = -1
-            // log(0.01) = -2
-            // log(0.001) = -3 ... etc
-
-            // if y == 0 and yhat == 0.001 then
-            // ((1.0 - 0.0) * log(1.0 - 0.001)) = 1.0 * ~0.0 ~= -0.0
-            // if y == 0 and yhat == 0.999 then
-            // ((1.0 - 0.0) * log(1.0 - 0.999)) = 1.0 * ~-2 = -3.0
-
-            // if y == 1 and yhat == 0.001 then
-            // (1 * log(0.001)) = -3.0
-            // if y == 1 and yhat == 0.99 then
-            // (1 * log(0.99)) ~= 0.0
-            l_error += (y * log(yhat)) + ((1.0 - y) * log(1.0 - yhat));
-        }
+        stringstream l_ss;
+        l_ss << "CrossEntropyLoss::Forward shapes must match "
+             << a_inputs->ShapeStr() << " != " << a_targets->ShapeStr() << endl;
+        throw(runtime_error(l_ss.str()));
     }
 
+    // if y == 0 then we take the second half of the equation
+    // if y == 1 then we take the first half
+    // log(1) = 0
+    // log(0.1) = -1
+    // log(0.01) = -2
+    // log(0.001) = -3 ... etc
+
+    // if y == 0 and yhat == 0.001 then
+    // ((1.0 - 0.0) * log(1.0 - 0.001)) = 1.0 * ~0.0 ~= -0.0
+    // if y == 0 and yhat == 0.999 then
+    // ((1.0 - 0.0) * log(1.0 - 0.999)) = 1.0 * ~-2 = -3.0
+
+    // if y == 1 and yhat == 0.001 then
+    // (1 * log(0.001)) = -3.0
+    // if y == 1 and yhat == 0.99 then
+    // (1 * log(0.99)) ~= 0.0
+
+    // one fused pass over the whole batch, nothing in between is stored
+    expr::Ref y(a_targets); // target
+    expr::Ref yhat(a_inputs); // predicted
+    float l_error = expr::Sum((y * expr::Log(yhat)) + ((1.0f - y) * expr::Log(1.0f - yhat)));
+
     return -1.0 * (l_error / (float)a_inputs->Shape().at(0));
 }
 
 TTensorPtr CrossEntropyLoss::Backward(
     const TTensorPtr& a_origInputs, const TTensorPtr& a_targets)
 {
-    TMutableTensorPtr l_gradient = Tensor::New(a_targets->Shape());
-    for (size_t i = 0; i < a_origInputs->Shape().at(0); ++i)
+    if (!a_origInputs->HasSameShape(a_targets))
     {
-        for (size_t j = 0; j < a_origInputs->Shape().at(1); ++j)
-        {
-            float yhat = a_origInputs->At({i,j});
-            float y = a_targets->At({i,j});
-            
-            // derivative of ln(x) is 1/x
-            // https://www.wyzant.com/resources/lessons/math/calculus/derivative_proofs/lnx
-            float l_gradVal = -1.0 * ((y / yhat) + ((1.0 - yhat) * (1.0 / (1.0 - yhat))));
-            // float l_gradVal = yhat - y;
-            l_gradient->SetAt({i,j}, l_gradVal);
-        }
+        stringstream l_ss;
+        l_ss << "CrossEntropyLoss::Backward shapes must match "
+             << a_origInputs->ShapeStr() << " != " << a_targets->ShapeStr() << endl;
+        throw(runtime_error(l_ss.str()));
     }
 
-    return make_shared<Tensor>(*l_gradient /= (float) a_origInputs->Shape().at(0));
+    TMatrix l_inputMat(a_origInputs);
+    TMutableMatrix l_gradient = TMutableMatrix::New(l_inputMat.Shape());
+
+    // derivative of ln(x) is 1/x
+    // https://www.wyzant.com/resources/lessons/math/calculus/derivative_proofs/lnx
+    // float l_gradVal = yhat - y;
+    expr::Ref y(a_targets);
+    expr::Ref yhat(a_origInputs);
+
+    // negate and average over the batch in the same pass
+    float l_scale = -(float)l_inputMat.Dim(0);
+    expr::Assign(l_gradient.Ptr(), ((y / yhat) + ((1.0f - yhat) * (1.0f / (1.0f - yhat)))) / l_scale);
+    return l_gradient.Ptr();
 }
 
 } // namespace neural
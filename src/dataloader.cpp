@@ -3,6 +3,7 @@
  */
 
 #include "neural/data/dataloader.h"
+#include "neural/math/tensor_view.h"
 
 #include <glog/logging.h>
 
@@ -61,8 +62,8 @@ void Dataloader::GetNextBatch(
     a_outInput = Tensor::New({a_batchSize, l_input->Shape().at(1)});
     a_outOutput = Tensor::New({a_batchSize, l_output->Shape().at(1)});
 
-    a_outInput->SetRow(0, l_input);
-    a_outOutput->SetRow(0, l_output);
+    a_outInput->SetRow(0, TensorView(l_input));
+    a_outOutput->SetRow(0, TensorView(l_output));
 
     for (int i = 1; i < a_batchSize; ++i)
     {
@@ -78,8 +79,8 @@ void Dataloader::GetNextBatch(
         TMutableTensorPtr l_input, l_output;
         // Populate data at index
         DataAt(l_dataIdx, l_input, l_output);
-        a_outInput->SetRow(i, l_input);
-        a_outOutput->SetRow(i, l_output);
+        a_outInput->SetRow(i, TensorView(l_input));
+        a_outOutput->SetRow(i, TensorView(l_output));
         ++m_currentIdx;
     }
 }
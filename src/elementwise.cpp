@@ -0,0 +1,644 @@
+/*
+ * Elementwise implementation
+ *
+ * Every kernel is written once per instruction set. The vector ones
+ * are compiled with a target attribute rather than -m flags, so one
+ * binary carries all of them and only runs those the CPU has.
+ */
+
+#include "neural/math/elementwise.h"
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NEURAL_ELEMENTWISE_X86 1
+// gcc 12 misreads the undefined pass-through operand inside some of the
+// AVX-512 intrinsics as uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#define NEURAL_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define NEURAL_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+using namespace std;
+
+namespace neural
+{
+
+namespace
+{
+
+typedef void (*TApplyFn)(const float*, const float*, float*, size_t);
+typedef void (*TApplyScalarFn)(const float*, float, float*, size_t);
+typedef void (*TAxpyFn)(float, const float*, float*, size_t);
+typedef void (*TUnaryFn)(const float*, float*, size_t);
+
+// One set of kernels, indexed by ElementwiseOp
+struct Kernels
+{
+    Elementwise::Isa m_isa;
+    TApplyFn m_apply[6];
+    TApplyScalarFn m_applyScalar[6];
+    TAxpyFn m_axpy;
+    TUnaryFn m_exp;
+    TUnaryFn m_log;
+};
+
+// exp clamps its input to this range first, the ends already
+// underflow to 0 and overflow to inf
+const float EXP_LO = -104.0f;
+const float EXP_HI = 89.0f;
+
+// Cephes single precision exp and log coefficients
+const float LOG2E = 1.44269504088896341f;
+const float LN2_HI = 0.693359375f;
+const float LN2_LO = -2.12194440e-4f;
+const float SQRT_HALF = 0.707106781186547524f;
+
+const float EXP_P0 = 1.9875691500e-4f;
+const float EXP_P1 = 1.3981999507e-3f;
+const float EXP_P2 = 8.3334519073e-3f;
+const float EXP_P3 = 4.1665795894e-2f;
+const float EXP_P4 = 1.6666665459e-1f;
+const float EXP_P5 = 5.0000001201e-1f;
+
+const float LOG_P0 = 7.0376836292e-2f;
+const float LOG_P1 = -1.1514610310e-1f;
+const float LOG_P2 = 1.1676998740e-1f;
+const float LOG_P3 = -1.2420140846e-1f;
+const float LOG_P4 = 1.4249322787e-1f;
+const float LOG_P5 = -1.6668057665e-1f;
+const float LOG_P6 = 2.0000714765e-1f;
+const float LOG_P7 = -2.4999993993e-1f;
+const float LOG_P8 = 3.3333331174e-1f;
+
+/*
+ * Scalar
+ */
+
+// max and min pick the right hand side when either is NaN,
+// the same as the vector instructions do
+template <ElementwiseOp Op>
+inline float ScalarOp(float a_lhs, float a_rhs)
+{
+    switch (Op)
+    {
+    case ElementwiseOp::ADD: return a_lhs + a_rhs;
+    case ElementwiseOp::SUB: return a_lhs - a_rhs;
+    case ElementwiseOp::MUL: return a_lhs * a_rhs;
+    case ElementwiseOp::DIV: return a_lhs / a_rhs;
+    case ElementwiseOp::MAX: return a_lhs > a_rhs ? a_lhs : a_rhs;
+    case ElementwiseOp::MIN: return a_lhs < a_rhs ? a_lhs : a_rhs;
+    }
+    return a_rhs;
+}
+
+template <ElementwiseOp Op>
+void ScalarApply(const float* a_lhs, const float* a_rhs, float* a_out, size_t a_size)
+{
+    for (size_t i = 0; i < a_size; ++i)
+    {
+        a_out[i] = ScalarOp<Op>(a_lhs[i], a_rhs[i]);
+    }
+}
+
+template <ElementwiseOp Op>
+void ScalarApplyScalar(const float* a_lhs, float a_rhs, float* a_out, size_t a_size)
+{
+    for (size_t i = 0; i < a_size; ++i)
+    {
+        a_out[i] = ScalarOp<Op>(a_lhs[i], a_rhs);
+    }
+}
+
+void ScalarAxpy(float a_alpha, const float* a_x, float* a_y, size_t a_size)
+{
+    for (size_t i = 0; i < a_size; ++i)
+    {
+        a_y[i] = a_y[i] + (a_alpha * a_x[i]);
+    }
+}
+
+void ScalarExp(const float* a_in, float* a_out, size_t a_size)
+{
+    for (size_t i = 0; i < a_size; ++i)
+    {
+        a_out[i] = std::exp(a_in[i]);
+    }
+}
+
+void ScalarLog(const float* a_in, float* a_out, size_t a_size)
+{
+    for (size_t i = 0; i < a_size; ++i)
+    {
+        a_out[i] = std::log(a_in[i]);
+    }
+}
+
+#if defined(NEURAL_ELEMENTWISE_X86)
+
+/*
+ * AVX2, 8 floats at a time
+ */
+
+template <ElementwiseOp Op>
+NEURAL_TARGET_AVX2 inline __m256 Avx2Op(__m256 a_lhs, __m256 a_rhs)
+{
+    switch (Op)
+    {
+    case ElementwiseOp::ADD: return _mm256_add_ps(a_lhs, a_rhs);
+    case ElementwiseOp::SUB: return _mm256_sub_ps(a_lhs, a_rhs);
+    case ElementwiseOp::MUL: return _mm256_mul_ps(a_lhs, a_rhs);
+    case ElementwiseOp::DIV: return _mm256_div_ps(a_lhs, a_rhs);
+    case ElementwiseOp::MAX: return _mm256_max_ps(a_lhs, a_rhs);
+    case ElementwiseOp::MIN: return _mm256_min_ps(a_lhs, a_rhs);
+    }
+    return a_rhs;
+}
+
+template <ElementwiseOp Op>
+NEURAL_TARGET_AVX2 void Avx2Apply(const float* a_lhs, const float* a_rhs, float* a_out, size_t a_size)
+{
+    size_t i = 0;
+    for (; i + 8 <= a_size; i += 8)
+    {
+        _mm256_storeu_ps(a_out + i, Avx2Op<Op>(_mm256_loadu_ps(a_lhs + i), _mm256_loadu_ps(a_rhs + i)));
+    }
+    ScalarApply<Op>(a_lhs + i, a_rhs + i, a_out + i, a_size - i);
+}
+
+template <ElementwiseOp Op>
+NEURAL_TARGET_AVX2 void Avx2ApplyScalar(const float* a_lhs, float a_rhs, float* a_out, size_t a_size)
+{
+    __m256 l_rhs = _mm256_set1_ps(a_rhs);
+    size_t i = 0;
+    for (; i + 8 <= a_size; i += 8)
+    {
+        _mm256_storeu_ps(a_out + i, Avx2Op<Op>(_mm256_loadu_ps(a_lhs + i), l_rhs));
+    }
+    ScalarApplyScalar<Op>(a_lhs + i, a_rhs, a_out + i, a_size - i);
+}
+
+NEURAL_TARGET_AVX2 void Avx2Axpy(float a_alpha, const float* a_x, float* a_y, size_t a_size)
+{
+    __m256 l_alpha = _mm256_set1_ps(a_alpha);
+    size_t i = 0;
+    for (; i + 8 <= a_size; i += 8)
+    {
+        _mm256_storeu_ps(a_y + i, _mm256_fmadd_ps(l_alpha, _mm256_loadu_ps(a_x + i), _mm256_loadu_ps(a_y + i)));
+    }
+    ScalarAxpy(a_alpha, a_x + i, a_y + i, a_size - i);
+}
+
+// Lanes [0, a_count) set, for the partial vector at the end of a run
+NEURAL_TARGET_AVX2 inline __m256i Avx2TailMask(size_t a_count)
+{
+    return _mm256_cmpgt_epi32(
+        _mm256_set1_epi32(static_cast<int>(a_count)),
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+NEURAL_TARGET_AVX2 inline __m256 Avx2Exp(__m256 a_x)
+{
+    // operands in this order keep NaN, the instructions return the second one
+    __m256 l_x = _mm256_min_ps(_mm256_set1_ps(EXP_HI), a_x);
+    l_x = _mm256_max_ps(_mm256_set1_ps(EXP_LO), l_x);
+
+    // exp(x) = 2^n * exp(r), n = round(x / ln2), |r| <= ln2 / 2
+    __m256 l_n = _mm256_floor_ps(_mm256_fmadd_ps(l_x, _mm256_set1_ps(LOG2E), _mm256_set1_ps(0.5f)));
+    __m256 l_r = _mm256_fnmadd_ps(l_n, _mm256_set1_ps(LN2_HI), l_x);
+    l_r = _mm256_fnmadd_ps(l_n, _mm256_set1_ps(LN2_LO), l_r);
+
+    __m256 l_y = _mm256_set1_ps(EXP_P0);
+    l_y = _mm256_fmadd_ps(l_y, l_r, _mm256_set1_ps(EXP_P1));
+    l_y = _mm256_fmadd_ps(l_y, l_r, _mm256_set1_ps(EXP_P2));
+    l_y = _mm256_fmadd_ps(l_y, l_r, _mm256_set1_ps(EXP_P3));
+    l_y = _mm256_fmadd_ps(l_y, l_r, _mm256_set1_ps(EXP_P4));
+    l_y = _mm256_fmadd_ps(l_y, l_r, _mm256_set1_ps(EXP_P5));
+    l_y = _mm256_fmadd_ps(l_y, _mm256_mul_ps(l_r, l_r), l_r);
+    l_y = _mm256_add_ps(l_y, _mm256_set1_ps(1.0f));
+
+    // n runs from -150 to 128, past what one exponent field holds, so
+    // scale by 2^(n/2) twice. That also gives proper denormals and inf.
+    __m256i l_n1 = _mm256_cvttps_epi32(l_n);
+    __m256i l_half = _mm256_srai_epi32(l_n1, 1);
+    __m256i l_rest = _mm256_sub_epi32(l_n1, l_half);
+    __m256i l_bias = _mm256_set1_epi32(127);
+    __m256 l_scale1 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(l_half, l_bias), 23));
+    __m256 l_scale2 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(l_rest, l_bias), 23));
+    return _mm256_mul_ps(_mm256_mul_ps(l_y, l_scale1), l_scale2);
+}
+
+NEURAL_TARGET_AVX2 inline __m256 Avx2Log(__m256 a_x)
+{
+    const __m256 l_one = _mm256_set1_ps(1.0f);
+    const __m256 l_zero = _mm256_setzero_ps();
+    __m256 l_isNan = _mm256_cmp_ps(a_x, l_zero, _CMP_NGE_UQ);
+    __m256 l_isZero = _mm256_cmp_ps(a_x, l_zero, _CMP_EQ_OQ);
+    __m256 l_isInf = _mm256_cmp_ps(a_x, _mm256_set1_ps(numeric_limits<float>::infinity()), _CMP_EQ_OQ);
+
+    // lift denormals into the normal range, and take it back off the exponent
+    __m256 l_isDenormal = _mm256_cmp_ps(a_x, _mm256_set1_ps(numeric_limits<float>::min()), _CMP_LT_OQ);
+    __m256 l_x = _mm256_blendv_ps(a_x, _mm256_mul_ps(a_x, _mm256_set1_ps(8388608.0f)), l_isDenormal);
+
+    // x = m * 2^e with m in [0.5, 1)
+    __m256i l_bits = _mm256_castps_si256(l_x);
+    __m256 l_e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(l_bits, 23), _mm256_set1_epi32(126)));
+    l_e = _mm256_sub_ps(l_e, _mm256_and_ps(l_isDenormal, _mm256_set1_ps(23.0f)));
+    __m256 l_m = _mm256_or_ps(
+        _mm256_and_ps(l_x, _mm256_castsi256_ps(_mm256_set1_epi32(0x007fffff))),
+        _mm256_set1_ps(0.5f));
+
+    // move m into [sqrt(1/2), sqrt(2)) and work on m - 1
+    __m256 l_small = _mm256_cmp_ps(l_m, _mm256_set1_ps(SQRT_HALF), _CMP_LT_OQ);
+    l_e = _mm256_sub_ps(l_e, _mm256_and_ps(l_small, l_one));
+    l_x = _mm256_add_ps(_mm256_sub_ps(l_m, l_one), _mm256_and_ps(l_small, l_m));
+
+    __m256 l_z = _mm256_mul_ps(l_x, l_x);
+    __m256 l_y = _mm256_set1_ps(LOG_P0);
+    l_y = _mm256_fmadd_ps(l_y, l_x, _mm256_set1_ps(LOG_P1));
+    l_y = _mm256_fmadd_ps(l_y, l_x, _mm256_set1_ps(LOG_P2));
+    l_y = _mm256_fmadd_ps(l_y, l_x, _mm256_set1_ps(LOG_P3));
+    l_y = _mm256_fmadd_ps(l_y, l_x, _mm256_set1_ps(LOG_P4));
+    l_y = _mm256_fmadd_ps(l_y, l_x, _mm256_set1_ps(LOG_P5));
+    l_y = _mm256_fmadd_ps(l_y, l_x, _mm256_set1_ps(LOG_P6));
+    l_y = _mm256_fmadd_ps(l_y, l_x, _mm256_set1_ps(LOG_P7));
+    l_y = _mm256_fmadd_ps(l_y, l_x, _mm256_set1_ps(LOG_P8));
+    l_y = _mm256_mul_ps(_mm256_mul_ps(l_y, l_x), l_z);
+
+    l_y = _mm256_fmadd_ps(l_e, _mm256_set1_ps(LN2_LO), l_y);
+    l_y = _mm256_fnmadd_ps(l_z, _mm256_set1_ps(0.5f), l_y);
+    __m256 l_ret = _mm256_fmadd_ps(l_e, _mm256_set1_ps(LN2_HI), _mm256_add_ps(l_x, l_y));
+
+    l_ret = _mm256_blendv_ps(l_ret, _mm256_set1_ps(-numeric_limits<float>::infinity()), l_isZero);
+    l_ret = _mm256_blendv_ps(l_ret, _mm256_set1_ps(numeric_limits<float>::infinity()), l_isInf);
+    return _mm256_blendv_ps(l_ret, _mm256_set1_ps(numeric_limits<float>::quiet_NaN()), l_isNan);
+}
+
+// The tail goes through the same approximation, masked,
+// so a value comes out the same wherever it sits in the run
+NEURAL_TARGET_AVX2 void Avx2Exp(const float* a_in, float* a_out, size_t a_size)
+{
+    size_t i = 0;
+    for (; i + 8 <= a_size; i += 8)
+    {
+        _mm256_storeu_ps(a_out + i, Avx2Exp(_mm256_loadu_ps(a_in + i)));
+    }
+    if (i < a_size)
+    {
+        __m256i l_mask = Avx2TailMask(a_size - i);
+        _mm256_maskstore_ps(a_out + i, l_mask, Avx2Exp(_mm256_maskload_ps(a_in + i, l_mask)));
+    }
+}
+
+NEURAL_TARGET_AVX2 void Avx2Log(const float* a_in, float* a_out, size_t a_size)
+{
+    size_t i = 0;
+    for (; i + 8 <= a_size; i += 8)
+    {
+        _mm256_storeu_ps(a_out + i, Avx2Log(_mm256_loadu_ps(a_in + i)));
+    }
+    if (i < a_size)
+    {
+        __m256i l_mask = Avx2TailMask(a_size - i);
+        _mm256_maskstore_ps(a_out + i, l_mask, Avx2Log(_mm256_maskload_ps(a_in + i, l_mask)));
+    }
+}
+
+/*
+ * AVX-512, 16 floats at a time
+ */
+
+template <ElementwiseOp Op>
+NEURAL_TARGET_AVX512 inline __m512 Avx512Op(__m512 a_lhs, __m512 a_rhs)
+{
+    switch (Op)
+    {
+    case ElementwiseOp::ADD: return _mm512_add_ps(a_lhs, a_rhs);
+    case ElementwiseOp::SUB: return _mm512_sub_ps(a_lhs, a_rhs);
+    case ElementwiseOp::MUL: return _mm512_mul_ps(a_lhs, a_rhs);
+    case ElementwiseOp::DIV: return _mm512_div_ps(a_lhs, a_rhs);
+    case ElementwiseOp::MAX: return _mm512_max_ps(a_lhs, a_rhs);
+    case ElementwiseOp::MIN: return _mm512_min_ps(a_lhs, a_rhs);
+    }
+    return a_rhs;
+}
+
+NEURAL_TARGET_AVX512 inline __mmask16 Avx512TailMask(size_t a_count)
+{
+    return static_cast<__mmask16>((1u << a_count) - 1);
+}
+
+// The tail is a masked vector too, none of these need a scalar loop
+template <ElementwiseOp Op>
+NEURAL_TARGET_AVX512 void Avx512Apply(const float* a_lhs, const float* a_rhs, float* a_out, size_t a_size)
+{
+    size_t i = 0;
+    for (; i + 16 <= a_size; i += 16)
+    {
+        _mm512_storeu_ps(a_out + i, Avx512Op<Op>(_mm512_loadu_ps(a_lhs + i), _mm512_loadu_ps(a_rhs + i)));
+    }
+    if (i < a_size)
+    {
+        __mmask16 l_mask = Avx512TailMask(a_size - i);
+        __m512 l_ret = Avx512Op<Op>(
+            _mm512_maskz_loadu_ps(l_mask, a_lhs + i), _mm512_maskz_loadu_ps(l_mask, a_rhs + i));
+        _mm512_mask_storeu_ps(a_out + i, l_mask, l_ret);
+    }
+}
+
+template <ElementwiseOp Op>
+NEURAL_TARGET_AVX512 void Avx512ApplyScalar(const float* a_lhs, float a_rhs, float* a_out, size_t a_size)
+{
+    __m512 l_rhs = _mm512_set1_ps(a_rhs);
+    size_t i = 0;
+    for (; i + 16 <= a_size; i += 16)
+    {
+        _mm512_storeu_ps(a_out + i, Avx512Op<Op>(_mm512_loadu_ps(a_lhs + i), l_rhs));
+    }
+    if (i < a_size)
+    {
+        __mmask16 l_mask = Avx512TailMask(a_size - i);
+        _mm512_mask_storeu_ps(a_out + i, l_mask, Avx512Op<Op>(_mm512_maskz_loadu_ps(l_mask, a_lhs + i), l_rhs));
+    }
+}
+
+NEURAL_TARGET_AVX512 void Avx512Axpy(float a_alpha, const float* a_x, float* a_y, size_t a_size)
+{
+    __m512 l_alpha = _mm512_set1_ps(a_alpha);
+    size_t i = 0;
+    for (; i + 16 <= a_size; i += 16)
+    {
+        _mm512_storeu_ps(a_y + i, _mm512_fmadd_ps(l_alpha, _mm512_loadu_ps(a_x + i), _mm512_loadu_ps(a_y + i)));
+    }
+    if (i < a_size)
+    {
+        __mmask16 l_mask = Avx512TailMask(a_size - i);
+        __m512 l_ret = _mm512_fmadd_ps(
+            l_alpha, _mm512_maskz_loadu_ps(l_mask, a_x + i), _mm512_maskz_loadu_ps(l_mask, a_y + i));
+        _mm512_mask_storeu_ps(a_y + i, l_mask, l_ret);
+    }
+}
+
+NEURAL_TARGET_AVX512 inline __m512 Avx512Exp(__m512 a_x)
+{
+    __m512 l_x = _mm512_min_ps(_mm512_set1_ps(EXP_HI), a_x);
+    l_x = _mm512_max_ps(_mm512_set1_ps(EXP_LO), l_x);
+
+    __m512 l_n = _mm512_roundscale_ps(
+        _mm512_fmadd_ps(l_x, _mm512_set1_ps(LOG2E), _mm512_set1_ps(0.5f)),
+        _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    __m512 l_r = _mm512_fnmadd_ps(l_n, _mm512_set1_ps(LN2_HI), l_x);
+    l_r = _mm512_fnmadd_ps(l_n, _mm512_set1_ps(LN2_LO), l_r);
+
+    __m512 l_y = _mm512_set1_ps(EXP_P0);
+    l_y = _mm512_fmadd_ps(l_y, l_r, _mm512_set1_ps(EXP_P1));
+    l_y = _mm512_fmadd_ps(l_y, l_r, _mm512_set1_ps(EXP_P2));
+    l_y = _mm512_fmadd_ps(l_y, l_r, _mm512_set1_ps(EXP_P3));
+    l_y = _mm512_fmadd_ps(l_y, l_r, _mm512_set1_ps(EXP_P4));
+    l_y = _mm512_fmadd_ps(l_y, l_r, _mm512_set1_ps(EXP_P5));
+    l_y = _mm512_fmadd_ps(l_y, _mm512_mul_ps(l_r, l_r), l_r);
+    l_y = _mm512_add_ps(l_y, _mm512_set1_ps(1.0f));
+
+    // scalef does the 2^n with denormals and inf handled
+    return _mm512_scalef_ps(l_y, l_n);
+}
+
+NEURAL_TARGET_AVX512 inline __m512 Avx512Log(__m512 a_x)
+{
+    const __m512 l_one = _mm512_set1_ps(1.0f);
+    const __m512 l_zero = _mm512_setzero_ps();
+    __mmask16 l_isNan = _mm512_cmp_ps_mask(a_x, l_zero, _CMP_NGE_UQ);
+    __mmask16 l_isZero = _mm512_cmp_ps_mask(a_x, l_zero, _CMP_EQ_OQ);
+    __mmask16 l_isInf = _mm512_cmp_ps_mask(a_x, _mm512_set1_ps(numeric_limits<float>::infinity()), _CMP_EQ_OQ);
+
+    // x = m * 2^e with m in [0.5, 1), denormals included
+    __m512 l_m = _mm512_getmant_ps(a_x, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_zero);
+    __m512 l_e = _mm512_add_ps(_mm512_getexp_ps(a_x), l_one);
+
+    __mmask16 l_small = _mm512_cmp_ps_mask(l_m, _mm512_set1_ps(SQRT_HALF), _CMP_LT_OQ);
+    l_e = _mm512_mask_sub_ps(l_e, l_small, l_e, l_one);
+    __m512 l_x = _mm512_sub_ps(l_m, l_one);
+    l_x = _mm512_mask_add_ps(l_x, l_small, l_x, l_m);
+
+    __m512 l_z = _mm512_mul_ps(l_x, l_x);
+    __m512 l_y = _mm512_set1_ps(LOG_P0);
+    l_y = _mm512_fmadd_ps(l_y, l_x, _mm512_set1_ps(LOG_P1));
+    l_y = _mm512_fmadd_ps(l_y, l_x, _mm512_set1_ps(LOG_P2));
+    l_y = _mm512_fmadd_ps(l_y, l_x, _mm512_set1_ps(LOG_P3));
+    l_y = _mm512_fmadd_ps(l_y, l_x, _mm512_set1_ps(LOG_P4));
+    l_y = _mm512_fmadd_ps(l_y, l_x, _mm512_set1_ps(LOG_P5));
+    l_y = _mm512_fmadd_ps(l_y, l_x, _mm512_set1_ps(LOG_P6));
+    l_y = _mm512_fmadd_ps(l_y, l_x, _mm512_set1_ps(LOG_P7));
+    l_y = _mm512_fmadd_ps(l_y, l_x, _mm512_set1_ps(LOG_P8));
+    l_y = _mm512_mul_ps(_mm512_mul_ps(l_y, l_x), l_z);
+
+    l_y = _mm512_fmadd_ps(l_e, _mm512_set1_ps(LN2_LO), l_y);
+    l_y = _mm512_fnmadd_ps(l_z, _mm512_set1_ps(0.5f), l_y);
+    __m512 l_ret = _mm512_fmadd_ps(l_e, _mm512_set1_ps(LN2_HI), _mm512_add_ps(l_x, l_y));
+
+    l_ret = _mm512_mask_blend_ps(l_isZero, l_ret, _mm512_set1_ps(-numeric_limits<float>::infinity()));
+    l_ret = _mm512_mask_blend_ps(l_isInf, l_ret, _mm512_set1_ps(numeric_limits<float>::infinity()));
+    return _mm512_mask_blend_ps(l_isNan, l_ret, _mm512_set1_ps(numeric_limits<float>::quiet_NaN()));
+}
+
+NEURAL_TARGET_AVX512 void Avx512Exp(const float* a_in, float* a_out, size_t a_size)
+{
+    size_t i = 0;
+    for (; i + 16 <= a_size; i += 16)
+    {
+        _mm512_storeu_ps(a_out + i, Avx512Exp(_mm512_loadu_ps(a_in + i)));
+    }
+    if (i < a_size)
+    {
+        __mmask16 l_mask = Avx512TailMask(a_size - i);
+        _mm512_mask_storeu_ps(a_out + i, l_mask, Avx512Exp(_mm512_maskz_loadu_ps(l_mask, a_in + i)));
+    }
+}
+
+NEURAL_TARGET_AVX512 void Avx512Log(const float* a_in, float* a_out, size_t a_size)
+{
+    size_t i = 0;
+    for (; i + 16 <= a_size; i += 16)
+    {
+        _mm512_storeu_ps(a_out + i, Avx512Log(_mm512_loadu_ps(a_in + i)));
+    }
+    if (i < a_size)
+    {
+        __mmask16 l_mask = Avx512TailMask(a_size - i);
+        _mm512_mask_storeu_ps(a_out + i, l_mask, Avx512Log(_mm512_maskz_loadu_ps(l_mask, a_in + i)));
+    }
+}
+
+#endif // NEURAL_ELEMENTWISE_X86
+
+#define NEURAL_ELEMENTWISE_KERNELS(a_isa, a_prefix)                  \
+    {                                                                \
+        a_isa,                                                       \
+        {                                                            \
+            a_prefix##Apply<ElementwiseOp::ADD>,                     \
+            a_prefix##Apply<ElementwiseOp::SUB>,                     \
+            a_prefix##Apply<ElementwiseOp::MUL>,                     \
+            a_prefix##Apply<ElementwiseOp::DIV>,                     \
+            a_prefix##Apply<ElementwiseOp::MAX>,                     \
+            a_prefix##Apply<ElementwiseOp::MIN>                      \
+        },                                                           \
+        {                                                            \
+            a_prefix##ApplyScalar<ElementwiseOp::ADD>,               \
+            a_prefix##ApplyScalar<ElementwiseOp::SUB>,               \
+            a_prefix##ApplyScalar<ElementwiseOp::MUL>,               \
+            a_prefix##ApplyScalar<ElementwiseOp::DIV>,               \
+            a_prefix##ApplyScalar<ElementwiseOp::MAX>,               \
+            a_prefix##ApplyScalar<ElementwiseOp::MIN>                \
+        },                                                           \
+        a_prefix##Axpy,                                              \
+        a_prefix##Exp,                                               \
+        a_prefix##Log                                                \
+    }
+
+const Kernels g_scalarKernels = NEURAL_ELEMENTWISE_KERNELS(Elementwise::Isa::SCALAR, Scalar);
+#if defined(NEURAL_ELEMENTWISE_X86)
+const Kernels g_avx2Kernels = NEURAL_ELEMENTWISE_KERNELS(Elementwise::Isa::AVX2, Avx2);
+const Kernels g_avx512Kernels = NEURAL_ELEMENTWISE_KERNELS(Elementwise::Isa::AVX512, Avx512);
+#endif
+
+#undef NEURAL_ELEMENTWISE_KERNELS
+
+// Chosen on first use
+atomic<const Kernels*> g_activeKernels(nullptr);
+
+const Kernels& KernelsFor(Elementwise::Isa a_isa)
+{
+    switch (a_isa)
+    {
+#if defined(NEURAL_ELEMENTWISE_X86)
+    case Elementwise::Isa::AVX2: return g_avx2Kernels;
+    case Elementwise::Isa::AVX512: return g_avx512Kernels;
+#endif
+    default: return g_scalarKernels;
+    }
+}
+
+inline const Kernels& ActiveKernels()
+{
+    const Kernels* l_kernels = g_activeKernels.load(memory_order_acquire);
+    if (nullptr == l_kernels)
+    {
+        // racing threads all pick the same set, so no need to lock
+        l_kernels = &KernelsFor(Elementwise::BestIsa());
+        g_activeKernels.store(l_kernels, memory_order_release);
+    }
+    return *l_kernels;
+}
+
+inline size_t OpIdx(ElementwiseOp a_op)
+{
+    return static_cast<size_t>(a_op);
+}
+
+} // namespace
+
+Elementwise::Isa Elementwise::BestIsa()
+{
+#if defined(NEURAL_ELEMENTWISE_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return Isa::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return Isa::AVX2;
+    }
+#endif
+    return Isa::SCALAR;
+}
+
+Elementwise::Isa Elementwise::ActiveIsa()
+{
+    return ActiveKernels().m_isa;
+}
+
+void Elementwise::SetIsa(Isa a_isa)
+{
+    if (a_isa > BestIsa())
+    {
+        stringstream l_ss;
+        l_ss << "Elementwise::SetIsa " << IsaName(a_isa)
+             << " is not supported here, best is " << IsaName(BestIsa());
+        throw(runtime_error(l_ss.str()));
+    }
+    g_activeKernels.store(&KernelsFor(a_isa), memory_order_release);
+}
+
+const char* Elementwise::IsaName(Isa a_isa)
+{
+    switch (a_isa)
+    {
+    case Isa::SCALAR: return "scalar";
+    case Isa::AVX2: return "avx2";
+    case Isa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+void Elementwise::Apply(ElementwiseOp a_op, const float* a_lhs, const float* a_rhs, float* a_out, size_t a_size)
+{
+    ActiveKernels().m_apply[OpIdx(a_op)](a_lhs, a_rhs, a_out, a_size);
+}
+
+void Elementwise::Apply(ElementwiseOp a_op, const float* a_lhs, float a_rhs, float* a_out, size_t a_size)
+{
+    ActiveKernels().m_applyScalar[OpIdx(a_op)](a_lhs, a_rhs, a_out, a_size);
+}
+
+void Elementwise::ApplyRow(
+    ElementwiseOp a_op, const float* a_mat, const float* a_row, float* a_out,
+    size_t a_rows, size_t a_cols)
+{
+    TApplyFn l_apply = ActiveKernels().m_apply[OpIdx(a_op)];
+    for (size_t i = 0; i < a_rows; ++i)
+    {
+        l_apply(a_mat + (i * a_cols), a_row, a_out + (i * a_cols), a_cols);
+    }
+}
+
+void Elementwise::ApplyCol(
+    ElementwiseOp a_op, const float* a_mat, const float* a_col, float* a_out,
+    size_t a_rows, size_t a_cols)
+{
+    TApplyScalarFn l_apply = ActiveKernels().m_applyScalar[OpIdx(a_op)];
+    for (size_t i = 0; i < a_rows; ++i)
+    {
+        l_apply(a_mat + (i * a_cols), a_col[i], a_out + (i * a_cols), a_cols);
+    }
+}
+
+void Elementwise::Scale(const float* a_in, float a_val, float* a_out, size_t a_size)
+{
+    Apply(ElementwiseOp::MUL, a_in, a_val, a_out, a_size);
+}
+
+void Elementwise::Axpy(float a_alpha, const float* a_x, float* a_y, size_t a_size)
+{
+    ActiveKernels().m_axpy(a_alpha, a_x, a_y, a_size);
+}
+
+void Elementwise::Exp(const float* a_in, float* a_out, size_t a_size)
+{
+    ActiveKernels().m_exp(a_in, a_out, a_size);
+}
+
+void Elementwise::Log(const float* a_in, float* a_out, size_t a_size)
+{
+    ActiveKernels().m_log(a_in, a_out, a_size);
+}
+
+} // namespace neural
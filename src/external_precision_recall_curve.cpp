@@ -0,0 +1,468 @@
+/*
+ * External Precision Recall Curve Implementation
+ *
+ */
+
+#include "neural/metrics/external_precision_recall_curve.h"
+#include "neural/metrics/metric.h"
+
+#include <algorithm>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace std;
+
+namespace neural
+{
+
+namespace metrics
+{
+
+namespace
+{
+
+// Most runs merged at once, and the fewest entries read per refill
+// before we would rather merge in more passes
+const size_t MAX_FAN_IN = 256;
+const size_t MIN_BLOCK_ENTRIES = 64;
+
+} // namespace
+
+ExternalPrecisionRecallCurve::ExternalPrecisionRecallCurve(
+    size_t a_memoryBudget, const std::string& a_tempDir)
+    : m_memoryBudget(a_memoryBudget)
+    , m_tempDir(a_tempDir)
+    , m_numExamples(0)
+    , m_numCorrect(0)
+    , m_numIncorrect(0)
+    , m_bufferSorted(true)
+    , m_hasSummary(false)
+    , m_averagePrecision(0.0f)
+    , m_rocAuc(0.0f)
+{
+
+}
+
+ExternalPrecisionRecallCurve::~ExternalPrecisionRecallCurve()
+{
+    for (size_t i = 0; i < m_runs.size(); ++i)
+    {
+        p_CloseRun(m_runs[i]);
+    }
+}
+
+void ExternalPrecisionRecallCurve::AddResults(
+    const TTensorPtr& a_outputs, const TTensorPtr& a_targets)
+{
+    static thread_local std::vector<PredictionRecord> l_batchRecords;
+    Metric::ReduceRows(a_outputs, a_targets, l_batchRecords);
+    Add(l_batchRecords.data(), l_batchRecords.size());
+}
+
+void ExternalPrecisionRecallCurve::Add(
+    const PredictionRecord* a_records, size_t a_numRecords)
+{
+    for (size_t i = 0; i < a_numRecords; ++i)
+    {
+        const PredictionRecord& l_record = a_records[i];
+        ++m_numExamples;
+
+        // NaN is never above or below a cutoff, so it is never counted
+        if (l_record.confidence != l_record.confidence)
+        {
+            continue;
+        }
+
+        Entry l_entry;
+        l_entry.confidence = l_record.confidence;
+        l_entry.isCorrect = (l_record.target == l_record.prediction) ? 1 : 0;
+        if (l_entry.isCorrect) ++m_numCorrect;
+        else ++m_numIncorrect;
+
+        // the buffer never grows past its half of the budget
+        if (m_buffer.capacity() < p_BufferEntries())
+        {
+            m_buffer.reserve(p_BufferEntries());
+        }
+        m_buffer.push_back(l_entry);
+        m_bufferSorted = false;
+        if (m_buffer.size() >= p_BufferEntries())
+        {
+            p_Spill();
+        }
+    }
+    m_hasSummary = false;
+}
+
+size_t ExternalPrecisionRecallCurve::NumExamples() const
+{
+    return m_numExamples;
+}
+
+size_t ExternalPrecisionRecallCurve::NumRuns() const
+{
+    return m_runs.size();
+}
+
+void ExternalPrecisionRecallCurve::ForEachPoint(
+    const std::function<void(const CurvePoint&)>& a_fn) const
+{
+    size_t l_correctAbove = 0;
+    size_t l_incorrectAbove = 0;
+    p_ForEachGroup([&](float a_confidence, size_t a_numCorrect, size_t a_numIncorrect)
+    {
+        // the group itself is on the cutoff so it is in none of the counts
+        ConfusionCounts l_counts;
+        l_counts.truePositives = l_correctAbove;
+        l_counts.falsePositives = l_incorrectAbove;
+        l_counts.falseNegatives = m_numCorrect - l_correctAbove - a_numCorrect;
+        l_counts.trueNegatives = m_numIncorrect - l_incorrectAbove - a_numIncorrect;
+        a_fn(CurvePoint::FromCounts(a_confidence, l_counts));
+
+        l_correctAbove += a_numCorrect;
+        l_incorrectAbove += a_numIncorrect;
+    });
+}
+
+std::vector<CurvePoint> ExternalPrecisionRecallCurve::Points(
+    const std::vector<float>& a_cutoffs) const
+{
+    // visit the cutoffs from the highest down, alongside the groups
+    vector<size_t> l_order(a_cutoffs.size());
+    for (size_t i = 0; i < l_order.size(); ++i)
+    {
+        l_order[i] = i;
+    }
+    std::sort(l_order.begin(), l_order.end(),
+        [&a_cutoffs](size_t a_lhs, size_t a_rhs)
+        {
+            return a_cutoffs[a_lhs] > a_cutoffs[a_rhs];
+        });
+
+    vector<CurvePoint> l_points(a_cutoffs.size());
+    size_t l_next = 0;
+    size_t l_correctAbove = 0;
+    size_t l_incorrectAbove = 0;
+
+    // every group seen so far is above any cutoff still to come
+    auto l_emit = [&](size_t a_idx, size_t a_equalCorrect, size_t a_equalIncorrect)
+    {
+        ConfusionCounts l_counts;
+        l_counts.truePositives = l_correctAbove;
+        l_counts.falsePositives = l_incorrectAbove;
+        l_counts.falseNegatives = m_numCorrect - l_correctAbove - a_equalCorrect;
+        l_counts.trueNegatives = m_numIncorrect - l_incorrectAbove - a_equalIncorrect;
+        l_points[a_idx] = CurvePoint::FromCounts(a_cutoffs[a_idx], l_counts);
+    };
+
+    p_ForEachGroup([&](float a_confidence, size_t a_numCorrect, size_t a_numIncorrect)
+    {
+        while (l_next < l_order.size() && a_cutoffs[l_order[l_next]] >= a_confidence)
+        {
+            bool l_isEqual = (a_cutoffs[l_order[l_next]] == a_confidence);
+            l_emit(l_order[l_next],
+                l_isEqual ? a_numCorrect : 0, l_isEqual ? a_numIncorrect : 0);
+            ++l_next;
+        }
+        l_correctAbove += a_numCorrect;
+        l_incorrectAbove += a_numIncorrect;
+    });
+
+    // cutoffs under every confidence
+    for (; l_next < l_order.size(); ++l_next)
+    {
+        l_emit(l_order[l_next], 0, 0);
+    }
+    return l_points;
+}
+
+float ExternalPrecisionRecallCurve::AveragePrecision() const
+{
+    p_BuildSummary();
+    return m_averagePrecision;
+}
+
+float ExternalPrecisionRecallCurve::RocAuc() const
+{
+    p_BuildSummary();
+    return m_rocAuc;
+}
+
+size_t ExternalPrecisionRecallCurve::p_BufferEntries() const
+{
+    return std::max(static_cast<size_t>(2), (m_memoryBudget / 2) / sizeof(Entry));
+}
+
+size_t ExternalPrecisionRecallCurve::p_MergeEntries() const
+{
+    return std::max(static_cast<size_t>(2), (m_memoryBudget - (m_memoryBudget / 2)) / sizeof(Entry));
+}
+
+void ExternalPrecisionRecallCurve::p_SortBuffer() const
+{
+    if (m_bufferSorted)
+    {
+        return;
+    }
+
+    std::sort(m_buffer.begin(), m_buffer.end(),
+        [](const Entry& a_lhs, const Entry& a_rhs)
+        {
+            return a_lhs.confidence > a_rhs.confidence;
+        });
+    m_bufferSorted = true;
+}
+
+void ExternalPrecisionRecallCurve::p_Spill() const
+{
+    if (m_buffer.empty())
+    {
+        return;
+    }
+
+    p_SortBuffer();
+
+    Run l_run = p_NewRun();
+    l_run.numEntries = m_buffer.size();
+    if (fwrite(m_buffer.data(), sizeof(Entry), m_buffer.size(), l_run.file) != m_buffer.size())
+    {
+        p_CloseRun(l_run);
+        throw(runtime_error("ExternalPrecisionRecallCurve failed to write a run"));
+    }
+    m_runs.push_back(l_run);
+
+    // keep the capacity, merging has its own half of the budget
+    m_buffer.clear();
+}
+
+void ExternalPrecisionRecallCurve::p_ReduceRuns() const
+{
+    size_t l_fanIn = std::min(MAX_FAN_IN, p_MergeEntries() / MIN_BLOCK_ENTRIES);
+    l_fanIn = std::max(static_cast<size_t>(2), l_fanIn);
+
+    while (m_runs.size() > l_fanIn)
+    {
+        // merge the first runs into a new one at the back
+        vector<Run> l_merging(m_runs.begin(), m_runs.begin() + l_fanIn);
+        Run l_merged = p_NewRun();
+
+        // one more block for what is waiting to be written
+        size_t l_blockEntries = std::max(
+            static_cast<size_t>(1), p_MergeEntries() / (l_fanIn + 1));
+        vector<Entry> l_out;
+        l_out.reserve(l_blockEntries);
+        auto l_flush = [&]()
+        {
+            if (fwrite(l_out.data(), sizeof(Entry), l_out.size(), l_merged.file) != l_out.size())
+            {
+                throw(runtime_error("ExternalPrecisionRecallCurve failed to write a merged run"));
+            }
+            l_merged.numEntries += l_out.size();
+            l_out.clear();
+        };
+
+        try
+        {
+            p_MergeRuns(l_merging, nullptr, 0, [&](const Entry& a_entry)
+            {
+                l_out.push_back(a_entry);
+                if (l_out.size() == l_blockEntries)
+                {
+                    l_flush();
+                }
+            });
+            l_flush();
+        }
+        catch (...)
+        {
+            p_CloseRun(l_merged);
+            throw;
+        }
+
+        for (size_t i = 0; i < l_merging.size(); ++i)
+        {
+            p_CloseRun(l_merging[i]);
+        }
+        m_runs.erase(m_runs.begin(), m_runs.begin() + l_fanIn);
+        m_runs.push_back(l_merged);
+    }
+}
+
+void ExternalPrecisionRecallCurve::p_MergeRuns(
+    const std::vector<Run>& a_runs, const Entry* a_sorted, size_t a_numSorted,
+    const std::function<void(const Entry&)>& a_fn) const
+{
+    size_t l_blockEntries = std::max(
+        static_cast<size_t>(1), p_MergeEntries() / (a_runs.size() + 1));
+
+    // a block of each run is in memory at a time, the sorted entries
+    // already are so they are read where they are
+    struct Reader
+    {
+        vector<Entry> storage;
+        const Entry* block;
+        size_t size;
+        size_t pos;
+        size_t remaining;
+    };
+    vector<Reader> l_readers(a_runs.size() + 1);
+
+    auto l_refill = [&](size_t a_idx)
+    {
+        Reader& l_reader = l_readers[a_idx];
+        size_t l_count = std::min(l_blockEntries, l_reader.remaining);
+        l_reader.storage.resize(l_count);
+        if (fread(l_reader.storage.data(), sizeof(Entry), l_count, a_runs[a_idx].file) != l_count)
+        {
+            throw(runtime_error("ExternalPrecisionRecallCurve failed to read a run"));
+        }
+        l_reader.block = l_reader.storage.data();
+        l_reader.size = l_count;
+        l_reader.remaining -= l_count;
+        l_reader.pos = 0;
+    };
+
+    // (confidence, run), most confident on top
+    typedef pair<float, size_t> THead;
+    priority_queue<THead> l_heads;
+    for (size_t i = 0; i < a_runs.size(); ++i)
+    {
+        rewind(a_runs[i].file);
+        l_readers[i].remaining = a_runs[i].numEntries;
+        l_refill(i);
+    }
+
+    Reader& l_sorted = l_readers[a_runs.size()];
+    l_sorted.block = a_sorted;
+    l_sorted.size = a_numSorted;
+    l_sorted.pos = 0;
+    l_sorted.remaining = 0;
+
+    for (size_t i = 0; i < l_readers.size(); ++i)
+    {
+        if (l_readers[i].size > 0)
+        {
+            l_heads.push(THead(l_readers[i].block[0].confidence, i));
+        }
+    }
+
+    while (!l_heads.empty())
+    {
+        size_t l_idx = l_heads.top().second;
+        l_heads.pop();
+
+        Reader& l_reader = l_readers[l_idx];
+        a_fn(l_reader.block[l_reader.pos]);
+        if (++l_reader.pos == l_reader.size)
+        {
+            if (0 == l_reader.remaining)
+            {
+                // this run is done, free its block
+                vector<Entry>().swap(l_reader.storage);
+                continue;
+            }
+            l_refill(l_idx);
+        }
+        l_heads.push(THead(l_reader.block[l_reader.pos].confidence, l_idx));
+    }
+}
+
+void ExternalPrecisionRecallCurve::p_ForEachGroup(const TGroupFn& a_fn) const
+{
+    // the buffer is merged from memory rather than spilled, so querying
+    // often does not leave a trail of small runs
+    p_SortBuffer();
+    p_ReduceRuns();
+
+    bool l_hasGroup = false;
+    float l_confidence = 0.0f;
+    size_t l_numCorrect = 0;
+    size_t l_numIncorrect = 0;
+    p_MergeRuns(m_runs, m_buffer.data(), m_buffer.size(), [&](const Entry& a_entry)
+    {
+        if (l_hasGroup && a_entry.confidence != l_confidence)
+        {
+            a_fn(l_confidence, l_numCorrect, l_numIncorrect);
+            l_numCorrect = 0;
+            l_numIncorrect = 0;
+        }
+        l_hasGroup = true;
+        l_confidence = a_entry.confidence;
+        if (a_entry.isCorrect) ++l_numCorrect;
+        else ++l_numIncorrect;
+    });
+
+    if (l_hasGroup)
+    {
+        a_fn(l_confidence, l_numCorrect, l_numIncorrect);
+    }
+}
+
+void ExternalPrecisionRecallCurve::p_BuildSummary() const
+{
+    if (m_hasSummary)
+    {
+        return;
+    }
+
+    // same sweep as AreaUnderCurve, one group of equal confidences at a time
+    double l_correct = 0.0;
+    double l_incorrect = 0.0;
+    double l_pairs = 0.0;
+    double l_precisionSum = 0.0;
+    p_ForEachGroup([&](float a_confidence, size_t a_numCorrect, size_t a_numIncorrect)
+    {
+        l_pairs += a_numIncorrect * (l_correct + (0.5 * a_numCorrect));
+        l_correct += a_numCorrect;
+        l_incorrect += a_numIncorrect;
+        l_precisionSum += a_numCorrect * (l_correct / (l_correct + l_incorrect));
+    });
+
+    m_averagePrecision = (0 == m_numCorrect) ? 0.0f :
+        static_cast<float>(l_precisionSum / m_numCorrect);
+    m_rocAuc = (0 == m_numCorrect || 0 == m_numIncorrect) ? 0.0f :
+        static_cast<float>(l_pairs / (static_cast<double>(m_numCorrect) * m_numIncorrect));
+    m_hasSummary = true;
+}
+
+ExternalPrecisionRecallCurve::Run ExternalPrecisionRecallCurve::p_NewRun() const
+{
+    string l_template = m_tempDir + "/neural_pr_run_XXXXXX";
+    vector<char> l_path(l_template.begin(), l_template.end());
+    l_path.push_back('\0');
+
+    int l_fd = mkstemp(l_path.data());
+    if (l_fd < 0)
+    {
+        stringstream l_ss;
+        l_ss << "ExternalPrecisionRecallCurve could not create a run in " << m_tempDir;
+        throw(runtime_error(l_ss.str()));
+    }
+    // the file goes away on its own once closed
+    unlink(l_path.data());
+
+    Run l_run;
+    l_run.file = fdopen(l_fd, "w+b");
+    l_run.numEntries = 0;
+    if (!l_run.file)
+    {
+        close(l_fd);
+        throw(runtime_error("ExternalPrecisionRecallCurve could not open a run"));
+    }
+    return l_run;
+}
+
+void ExternalPrecisionRecallCurve::p_CloseRun(Run& a_run)
+{
+    if (a_run.file)
+    {
+        fclose(a_run.file);
+        a_run.file = nullptr;
+    }
+}
+
+} // namespace metrics
+
+} // namespace neural
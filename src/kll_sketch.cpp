@@ -0,0 +1,250 @@
+/*
+ * KllSketch Implementation
+ *
+ */
+
+#include "neural/metrics/kll_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace neural
+{
+
+namespace metrics
+{
+
+KllSketch::KllSketch(size_t a_k)
+    : m_k(a_k)
+    , m_count(0)
+    , m_levels(1)
+    , m_randomState(0x9e3779b97f4a7c15ULL)
+{
+    if (m_k < 2)
+    {
+        throw(runtime_error("KllSketch needs k of at least 2"));
+    }
+}
+
+void KllSketch::Update(float a_value)
+{
+    m_levels[0].push_back(a_value);
+    ++m_count;
+    if (NumRetained() > p_TotalCapacity())
+    {
+        p_Compress();
+    }
+}
+
+void KllSketch::Merge(const KllSketch& a_other)
+{
+    if (a_other.m_k != m_k)
+    {
+        stringstream l_ss;
+        l_ss << "KllSketch::Merge k " << a_other.m_k << " != " << m_k;
+        throw(runtime_error(l_ss.str()));
+    }
+
+    if (a_other.m_levels.size() > m_levels.size())
+    {
+        m_levels.resize(a_other.m_levels.size());
+    }
+    for (size_t i = 0; i < a_other.m_levels.size(); ++i)
+    {
+        m_levels[i].insert(m_levels[i].end(),
+            a_other.m_levels[i].begin(), a_other.m_levels[i].end());
+    }
+    m_count += a_other.m_count;
+    p_Compress();
+}
+
+size_t KllSketch::K() const
+{
+    return m_k;
+}
+
+size_t KllSketch::Count() const
+{
+    return m_count;
+}
+
+size_t KllSketch::NumRetained() const
+{
+    size_t l_numRetained = 0;
+    for (const vector<float>& l_level : m_levels)
+    {
+        l_numRetained += l_level.size();
+    }
+    return l_numRetained;
+}
+
+size_t KllSketch::CountBelow(float a_value) const
+{
+    size_t l_count = 0;
+    for (size_t i = 0; i < m_levels.size(); ++i)
+    {
+        size_t l_numBelow = 0;
+        for (float l_value : m_levels[i])
+        {
+            if (l_value < a_value) ++l_numBelow;
+        }
+        l_count += l_numBelow << i;
+    }
+    return l_count;
+}
+
+size_t KllSketch::CountAtOrBelow(float a_value) const
+{
+    size_t l_count = 0;
+    for (size_t i = 0; i < m_levels.size(); ++i)
+    {
+        size_t l_numAtOrBelow = 0;
+        for (float l_value : m_levels[i])
+        {
+            if (l_value <= a_value) ++l_numAtOrBelow;
+        }
+        l_count += l_numAtOrBelow << i;
+    }
+    return l_count;
+}
+
+float KllSketch::Quantile(double a_fraction) const
+{
+    if (0 == m_count)
+    {
+        return 0.0f;
+    }
+
+    // (value, weight) of everything kept, in value order
+    vector<pair<float, size_t> > l_weighted;
+    l_weighted.reserve(NumRetained());
+    for (size_t i = 0; i < m_levels.size(); ++i)
+    {
+        for (float l_value : m_levels[i])
+        {
+            l_weighted.push_back(make_pair(l_value, static_cast<size_t>(1) << i));
+        }
+    }
+    sort(l_weighted.begin(), l_weighted.end());
+
+    double l_rank = a_fraction * static_cast<double>(m_count);
+    float l_quantile = l_weighted.front().first;
+    size_t l_below = 0;
+    for (size_t i = 0; i < l_weighted.size(); ++i)
+    {
+        // only the first of equal values has the right count below it
+        if (0 == i || l_weighted[i].first != l_weighted[i - 1].first)
+        {
+            if (static_cast<double>(l_below) > l_rank)
+            {
+                break;
+            }
+            l_quantile = l_weighted[i].first;
+        }
+        l_below += l_weighted[i].second;
+    }
+    return l_quantile;
+}
+
+const std::vector<std::vector<float> >& KllSketch::Levels() const
+{
+    return m_levels;
+}
+
+void KllSketch::Restore(size_t a_count, const std::vector<std::vector<float> >& a_levels)
+{
+    if (a_levels.size() > MAX_LEVELS)
+    {
+        stringstream l_ss;
+        l_ss << "KllSketch::Restore too many levels " << a_levels.size();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    size_t l_weight = 0;
+    for (size_t i = 0; i < a_levels.size(); ++i)
+    {
+        l_weight += a_levels[i].size() << i;
+    }
+    if (l_weight != a_count)
+    {
+        stringstream l_ss;
+        l_ss << "KllSketch::Restore levels hold " << l_weight
+             << " values, expected " << a_count;
+        throw(runtime_error(l_ss.str()));
+    }
+
+    m_count = a_count;
+    m_levels = a_levels;
+    if (m_levels.empty())
+    {
+        m_levels.resize(1);
+    }
+    p_Compress();
+}
+
+size_t KllSketch::p_Capacity(size_t a_level) const
+{
+    // top level holds k, every level below it 2/3 as many
+    size_t l_depth = m_levels.size() - a_level - 1;
+    double l_capacity = ceil(static_cast<double>(m_k) * pow(2.0 / 3.0, static_cast<double>(l_depth)));
+    return max(static_cast<size_t>(2), static_cast<size_t>(l_capacity));
+}
+
+size_t KllSketch::p_TotalCapacity() const
+{
+    size_t l_capacity = 0;
+    for (size_t i = 0; i < m_levels.size(); ++i)
+    {
+        l_capacity += p_Capacity(i);
+    }
+    return l_capacity;
+}
+
+void KllSketch::p_Compress()
+{
+    while (NumRetained() > p_TotalCapacity())
+    {
+        for (size_t i = 0; i < m_levels.size(); ++i)
+        {
+            if (m_levels[i].size() < p_Capacity(i))
+            {
+                continue;
+            }
+
+            if (i + 1 == m_levels.size())
+            {
+                m_levels.push_back(vector<float>());
+            }
+
+            // an odd one out stays behind, of each sorted pair after it
+            // a random one moves up a level with twice the weight
+            vector<float>& l_level = m_levels[i];
+            sort(l_level.begin(), l_level.end());
+            size_t l_keep = l_level.size() % 2;
+            size_t l_offset = p_RandomBit() ? 1 : 0;
+            for (size_t j = l_keep + l_offset; j < l_level.size(); j += 2)
+            {
+                m_levels[i + 1].push_back(l_level[j]);
+            }
+            l_level.resize(l_keep);
+            break;
+        }
+    }
+}
+
+bool KllSketch::p_RandomBit()
+{
+    // xorshift64, deterministic so results are reproducible
+    m_randomState ^= m_randomState << 13;
+    m_randomState ^= m_randomState >> 7;
+    m_randomState ^= m_randomState << 17;
+    return (m_randomState >> 32) & 1;
+}
+
+} // namespace metrics
+
+} // namespace neural
@@ -55,25 +55,23 @@ TTensorPtr LinearLayer::Backward(const TTensorPtr& a_origInput, const TTensorPtr
     }
 
     // Gradient wrt weights
-    // Added logging to see speed of transpose operation vs. speed of mat mul
-  //  LOG(INFO) << "LinearLayer::Backward transpose inputs " << l_input->ShapeStr() << "^T" << endl;
-    TTensorPtr l_inputT = TensorMath::Transpose(l_input);
-  //  LOG(INFO) << "LinearLayer::Backward weights gradient computation " << l_inputT->ShapeStr() << "*" << a_gradInput->ShapeStr() << endl;
+    // Transposes are views, BLAS reads the original buffers transposed
+    TensorView l_inputT = TensorView(l_input).Transpose();
+  //  LOG(INFO) << "LinearLayer::Backward weights gradient computation " << l_inputT.ShapeStr() << "*" << a_gradInput->ShapeStr() << endl;
     TTensorPtr gradWrtWeights = TensorMath::Multiply(l_inputT, a_gradInput);
     m_weightGrads.push_back(gradWrtWeights);
 
     // Gradient wrt output
-    // Added logging to see speed of transpose operation vs. speed of mat mul
-    //LOG(INFO) << "LinearLayer::Backward transpose m_weights " << m_weights->ShapeStr() << "^T" << endl;
-    TTensorPtr l_weightsT = TensorMath::Transpose(m_weights);
-    //LOG(INFO) << "End LinearLayer::Backward output gradient computation " << a_gradInput->ShapeStr() << "*" << m_weights->ShapeStr() << "^T" << endl;
-    TTensorPtr gradWrtOutput = TensorMath::Multiply(a_gradInput, l_weightsT);
-    //LOG(INFO) << "End LinearLayer::Backward gradient computation" << endl;
-
+    // The bias row of the weights only feeds the column of 1s we added,
+    // so leave it out rather than computing that column and removing it
+    TensorView l_weightsT = TensorView(m_weights).Transpose();
     if (m_hasBias)
     {
-        gradWrtOutput = TensorMath::RemoveCol(gradWrtOutput);
+        l_weightsT = TensorView(m_weights).Narrow(0, 0, m_weights->Shape().at(0) - 1).Transpose();
     }
+    //LOG(INFO) << "End LinearLayer::Backward output gradient computation " << a_gradInput->ShapeStr() << "*" << m_weights->ShapeStr() << "^T" << endl;
+    TTensorPtr gradWrtOutput = TensorMath::Multiply(a_gradInput, l_weightsT);
+    //LOG(INFO) << "End LinearLayer::Backward gradient computation" << endl;
 
     return gradWrtOutput;
 }
@@ -84,14 +82,8 @@ void LinearLayer::UpdateWeights(float a_learningRate)
     TTensorPtr l_gradient = CalcAvgWeightGrad();
     //LOG(INFO) << "LinearLayer::UpdateWeights done CalcAvgWeightGrad()" << endl;
 
-    std::vector<float>& l_weightData = m_weights->MutableData();
-    const std::vector<float>& l_gradientData = l_gradient->Data();
-
-    #pragma omp parallel for
-    for (size_t i = 0; i < l_weightData.size(); ++i)
-    {
-        l_weightData.at(i) -= a_learningRate * l_gradientData.at(i);
-    }
+    // weights -= learning rate * gradient
+    TensorMath::Axpy(-a_learningRate, l_gradient, m_weights);
 
     // clear gradients
     m_weightGrads.clear();
@@ -100,14 +92,20 @@ void LinearLayer::UpdateWeights(float a_learningRate)
 
 TTensorPtr LinearLayer::CalcAvgWeightGrad() const
 {
+    // one backward pass per update, the average is that gradient
+    if (1 == m_weightGrads.size())
+    {
+        return m_weightGrads.at(0);
+    }
+
     // Init with zeros
     TMutableTensorPtr average = Tensor::Zeros(m_weightGrads.at(0)->Shape());
-    std::vector<float>& l_averageData = average->MutableData();
+    TTensorData& l_averageData = average->MutableData();
 
     // Sum up
     for (const TTensorPtr& grad : m_weightGrads)
     {
-        const std::vector<float>& l_gradientData = grad->Data();
+        const TTensorData& l_gradientData = grad->Data();
 
         #pragma omp parallel for
         for (size_t i = 0; i < l_gradientData.size(); ++i)
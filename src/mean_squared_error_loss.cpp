@@ -3,6 +3,8 @@
  */
 
 #include "neural/loss/mean_squared_error_loss.h"
+#include "neural/math/expression.h"
+#include "neural/math/tensor_t.h"
 
 #include <glog/logging.h>
 
@@ -29,12 +31,8 @@ float MeanSquaredErrorLoss::Forward(
         throw(l_errMsg);
     }
 
-    float l_error = 0.0;
-    for (size_t i = 0; i < a_inputs->Size(); ++i)
-    {
-        float l_diff = (a_targets->Data().at(i) - a_inputs->Data().at(i));
-        l_error += (l_diff * l_diff);
-    }
+    // sum((target - input)^2), fused so the differences are never stored
+    float l_error = expr::Sum(expr::Square(expr::Ref(a_targets) - expr::Ref(a_inputs)));
 
     return (l_error / (float)a_inputs->Size());
 }
@@ -49,18 +47,14 @@ TTensorPtr MeanSquaredErrorLoss::Backward(
         throw(l_errMsg);
     }
 
-    size_t l_batchSize = a_origInputs->Shape().at(0);
-    size_t l_outputSize = a_origInputs->Shape().at(1);
-    TMutableTensorPtr l_grad = Tensor::New({l_batchSize, l_outputSize});
+    TMatrix l_inputs(a_origInputs);
+    TMatrix l_targets(a_targets);
+    TMutableMatrix l_grad = TMutableMatrix::New(l_inputs.Shape());
 
-    for (size_t i = 0; i < a_origInputs->Size(); ++i)
-    {
-        // dedl = -2.0 * (target - input)
-        float dedl = -2.0 * (a_targets->Data().at(i) - a_origInputs->Data().at(i));
-        l_grad->MutableData().at(i) = dedl;
-    }
+    // dedl = -2.0 * (target - input)
+    expr::Assign(l_grad.Ptr(), (expr::Ref(a_targets) - expr::Ref(a_origInputs)) * -2.0f);
 
-    return l_grad;
+    return l_grad.Ptr();
 }
 
 } // namespace neural
@@ -0,0 +1,244 @@
+/*
+ * Memory Pool Implementation
+ *
+ */
+
+#include "neural/util/memory_pool.h"
+
+#include <stdlib.h>
+
+#include <new>
+
+using namespace std;
+
+namespace neural
+{
+
+// Blocks a thread freed and will most likely ask for again soon,
+// touched without taking the pool's lock
+class MemoryPoolThreadCache
+{
+public:
+    ~MemoryPoolThreadCache();
+
+    std::vector<void*> m_freeLists[MemoryPool::NUM_CLASSES];
+};
+
+namespace
+{
+
+atomic<MemoryResource*> g_defaultResource(nullptr);
+
+thread_local MemoryResource* t_defaultResource = nullptr;
+
+thread_local MemoryPoolThreadCache t_cache;
+
+// Storage can be released from static destructors after this thread's
+// cache is gone, those frees go straight to the shared lists
+thread_local bool t_cacheDestroyed = false;
+
+MemoryPoolThreadCache* p_ThreadCache()
+{
+    if (t_cacheDestroyed)
+    {
+        return nullptr;
+    }
+    return &t_cache;
+}
+
+size_t p_ClassBytes(size_t a_class)
+{
+    return size_t(1) << (a_class + MemoryPool::MIN_CLASS_BITS);
+}
+
+} // namespace
+
+MemoryPoolThreadCache::~MemoryPoolThreadCache()
+{
+    t_cacheDestroyed = true;
+    for (size_t i = 0; i < MemoryPool::NUM_CLASSES; ++i)
+    {
+        MemoryPool::Instance()->p_Release(i, m_freeLists[i]);
+    }
+}
+
+const size_t MemoryResource::ALIGNMENT;
+const size_t MemoryPool::MIN_CLASS_BITS;
+const size_t MemoryPool::NUM_CLASSES;
+const size_t MemoryPool::THREAD_CACHE_BYTES;
+
+void* MemoryResource::Allocate(size_t a_bytes)
+{
+    return p_Allocate(a_bytes);
+}
+
+void MemoryResource::Deallocate(void* a_ptr, size_t a_bytes)
+{
+    if (nullptr != a_ptr)
+    {
+        p_Deallocate(a_ptr, a_bytes);
+    }
+}
+
+MemoryResource* MemoryResource::Default()
+{
+    if (nullptr != t_defaultResource)
+    {
+        return t_defaultResource;
+    }
+
+    MemoryResource* l_resource = g_defaultResource.load();
+    if (nullptr == l_resource)
+    {
+        return MemoryPool::Instance();
+    }
+    return l_resource;
+}
+
+MemoryResource* MemoryResource::SetDefault(MemoryResource* a_resource)
+{
+    MemoryResource* l_previous = g_defaultResource.exchange(a_resource);
+    if (nullptr == l_previous)
+    {
+        return MemoryPool::Instance();
+    }
+    return l_previous;
+}
+
+MemoryResource* MemoryResource::SetThreadDefault(MemoryResource* a_resource)
+{
+    MemoryResource* l_previous = t_defaultResource;
+    t_defaultResource = a_resource;
+    return l_previous;
+}
+
+MemoryPool::MemoryPool()
+    : m_numSystemAllocations(0)
+    , m_numCachedBytes(0)
+{
+}
+
+MemoryPool* MemoryPool::Instance()
+{
+    static MemoryPool* l_pool = new MemoryPool();
+    return l_pool;
+}
+
+size_t MemoryPool::NumSystemAllocations() const
+{
+    return m_numSystemAllocations.load();
+}
+
+size_t MemoryPool::NumCachedBytes() const
+{
+    return m_numCachedBytes.load();
+}
+
+void MemoryPool::Trim()
+{
+    MemoryPoolThreadCache* l_cache = p_ThreadCache();
+    if (nullptr != l_cache)
+    {
+        for (size_t i = 0; i < NUM_CLASSES; ++i)
+        {
+            p_Release(i, l_cache->m_freeLists[i]);
+        }
+    }
+
+    lock_guard<mutex> l_lock(m_mutex);
+    for (size_t i = 0; i < NUM_CLASSES; ++i)
+    {
+        for (void* l_block : m_freeLists[i])
+        {
+            free(l_block);
+        }
+        m_numCachedBytes -= m_freeLists[i].size() * p_ClassBytes(i);
+        vector<void*>().swap(m_freeLists[i]);
+    }
+}
+
+void* MemoryPool::p_Allocate(size_t a_bytes)
+{
+    size_t l_class = p_SizeClass(a_bytes);
+    if (l_class >= NUM_CLASSES)
+    {
+        throw(bad_alloc());
+    }
+
+    // most recently freed first, it is the most likely to still be in cache
+    MemoryPoolThreadCache* l_cache = p_ThreadCache();
+    if (nullptr != l_cache && !l_cache->m_freeLists[l_class].empty())
+    {
+        void* l_block = l_cache->m_freeLists[l_class].back();
+        l_cache->m_freeLists[l_class].pop_back();
+        return l_block;
+    }
+
+    {
+        lock_guard<mutex> l_lock(m_mutex);
+        if (!m_freeLists[l_class].empty())
+        {
+            void* l_block = m_freeLists[l_class].back();
+            m_freeLists[l_class].pop_back();
+            m_numCachedBytes -= p_ClassBytes(l_class);
+            return l_block;
+        }
+    }
+
+    void* l_block = nullptr;
+    if (0 != posix_memalign(&l_block, ALIGNMENT, p_ClassBytes(l_class)))
+    {
+        throw(bad_alloc());
+    }
+    ++m_numSystemAllocations;
+    return l_block;
+}
+
+void MemoryPool::p_Deallocate(void* a_ptr, size_t a_bytes)
+{
+    size_t l_class = p_SizeClass(a_bytes);
+
+    // always keep at least one block so a single large tensor
+    // allocated and freed every iteration stays thread local
+    MemoryPoolThreadCache* l_cache = p_ThreadCache();
+    if (nullptr != l_cache)
+    {
+        vector<void*>& l_freeList = l_cache->m_freeLists[l_class];
+        if (l_freeList.empty() ||
+            (l_freeList.size() + 1) * p_ClassBytes(l_class) <= THREAD_CACHE_BYTES)
+        {
+            l_freeList.push_back(a_ptr);
+            return;
+        }
+    }
+
+    lock_guard<mutex> l_lock(m_mutex);
+    m_freeLists[l_class].push_back(a_ptr);
+    m_numCachedBytes += p_ClassBytes(l_class);
+}
+
+void MemoryPool::p_Release(size_t a_class, std::vector<void*>& a_blocks)
+{
+    if (a_blocks.empty())
+    {
+        return;
+    }
+
+    lock_guard<mutex> l_lock(m_mutex);
+    m_freeLists[a_class].insert(m_freeLists[a_class].end(), a_blocks.begin(), a_blocks.end());
+    m_numCachedBytes += a_blocks.size() * p_ClassBytes(a_class);
+    a_blocks.clear();
+}
+
+size_t MemoryPool::p_SizeClass(size_t a_bytes)
+{
+    // round up to the next power of two, at least one cache line
+    size_t l_class = 0;
+    while (p_ClassBytes(l_class) < a_bytes && l_class < NUM_CLASSES)
+    {
+        ++l_class;
+    }
+    return l_class;
+}
+
+} // namespace neural
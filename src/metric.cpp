@@ -4,6 +4,13 @@
  */
 
 #include "neural/metrics/metric.h"
+#include "neural/metrics/record_accumulator.h"
+#include "neural/metrics/concurrent_accumulator.h"
+#include "neural/math/reduction.h"
+#include "neural/util/bit_mask.h"
+
+#include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
@@ -13,8 +20,18 @@ namespace neural
 namespace metrics
 {
 
-Metric::Metric(size_t a_runningAvgLen)
-    : m_runningAvgLen(a_runningAvgLen)
+Metric::Metric(size_t a_windowSize)
+    : m_accumulator(RecordAccumulator::New(a_windowSize))
+    , m_topK(1)
+    , m_isMultiLabel(false)
+{
+
+}
+
+Metric::Metric(const TAccumulatorPtr& a_accumulator)
+    : m_accumulator(a_accumulator)
+    , m_topK(1)
+    , m_isMultiLabel(false)
 {
 
 }
@@ -22,110 +39,236 @@ Metric::Metric(size_t a_runningAvgLen)
 void Metric::AddResults(
     const TTensorPtr& a_outputs, const TTensorPtr& a_targets)
 {
-    m_outputs.push_back(a_outputs);
-    m_targets.push_back(a_targets);
+    // Reused between calls, one per thread so a metric over a
+    // ConcurrentAccumulator can be fed from many threads at once
+    static thread_local std::vector<PredictionRecord> l_batchRecords;
 
-    while (m_outputs.size() > m_runningAvgLen) {
-        m_outputs.pop_front();
+    if (m_isMultiLabel)
+    {
+        ReduceCells(a_outputs, a_targets, l_batchRecords);
     }
-
-    while (m_targets.size() > m_runningAvgLen) {
-        m_targets.pop_front();
+    else
+    {
+        ReduceRows(a_outputs, a_targets, l_batchRecords, m_topK);
     }
+    m_accumulator->Add(l_batchRecords.data(), l_batchRecords.size());
+}
+
+void Metric::Merge(const Metric& a_other)
+{
+    m_accumulator->Merge(*a_other.m_accumulator);
+}
+
+void Metric::Serialize(std::ostream& a_stream) const
+{
+    m_accumulator->Serialize(a_stream);
+}
+
+void Metric::Deserialize(std::istream& a_stream)
+{
+    m_accumulator->Deserialize(a_stream);
 }
 
-size_t Metric::p_IterAndCountWithFn(
-    std::function<bool(size_t, size_t, float, float)> a_comparatorFn,
-    float a_confidence) const
+void Metric::TrackCutoff(float a_confidence)
 {
-    // total number of occurences
-    size_t l_retVal = 0;
-    // iterate over all results in the deque
-    for (size_t i = 0; i < m_targets.size(); ++i)
+    m_accumulator->TrackCutoff(a_confidence);
+}
+
+size_t Metric::NumExamples() const
+{
+    return m_accumulator->NumExamples();
+}
+
+const TAccumulatorPtr& Metric::GetAccumulator() const
+{
+    return m_accumulator;
+}
+
+std::vector<BootstrapInterval> Metric::Bootstrap(
+    const std::vector<float>& a_cutoffs,
+    size_t a_numReplicates,
+    float a_level,
+    uint64_t a_seed) const
+{
+    // resample every shard's records together
+    TAccumulatorPtr l_accumulator = m_accumulator;
+    TConcurrentAccumulatorPtr l_concurrent =
+        std::dynamic_pointer_cast<ConcurrentAccumulator>(l_accumulator);
+    if (l_concurrent)
     {
-        // get the result outputs, and targets
-        const TTensorPtr& l_outputs = m_outputs.at(i);
-        const TTensorPtr& l_targets = m_targets.at(i);
-        
-        // remember, this is probably the output of a batch of predictions
-        // iterate over rows in predictions / targets
-        for (size_t j = 0; j < l_outputs->Shape().at(0); ++j)
+        l_accumulator = l_concurrent->Snapshot();
+    }
+
+    TRecordAccumulatorPtr l_records =
+        std::dynamic_pointer_cast<RecordAccumulator>(l_accumulator);
+    if (!l_records)
+    {
+        stringstream l_ss;
+        l_ss << "Metric::Bootstrap " << GetName() << " needs exact records to resample";
+        throw(runtime_error(l_ss.str()));
+    }
+
+    vector<float> l_countsCutoffs;
+    l_countsCutoffs.reserve(a_cutoffs.size());
+    for (float l_cutoff : a_cutoffs)
+    {
+        l_countsCutoffs.push_back(p_CountsCutoff(l_cutoff));
+    }
+
+    vector<BootstrapInterval> l_intervals = metrics::Bootstrap::Intervals(
+        l_records->UnorderedRecords(), l_countsCutoffs,
+        [this](const ConfusionCounts& a_counts)
         {
-            size_t l_targetIdx = l_targets->GetRow(j)->MaxIdx();
-            size_t l_predIdx = l_outputs->GetRow(j)->MaxIdx();
-            float l_predVal = l_outputs->GetRow(j)->MaxVal();
-
-            if (a_comparatorFn(l_targetIdx, l_predIdx, l_predVal, a_confidence))
-            {
-                ++l_retVal;
-            }
-        }
+            return p_CalculateFromCounts(a_counts);
+        },
+        a_numReplicates, a_level, a_seed);
+
+    // report against the cutoffs asked for
+    for (size_t i = 0; i < l_intervals.size(); ++i)
+    {
+        l_intervals[i].threshold = a_cutoffs[i];
     }
-    return l_retVal;
+    return l_intervals;
 }
 
-size_t Metric::p_CalcNumTruePositives(
-    float a_confidenceLevel) const
+void Metric::SetTopK(size_t a_k)
 {
-    using namespace std::placeholders;
-    auto fp = std::bind(&Metric::p_ExampleIsTruePositive, this, _1, _2, _3, _4);
-    return p_IterAndCountWithFn(fp, a_confidenceLevel);
+    p_CheckNoResults("SetTopK");
+    if (0 == a_k)
+    {
+        throw(runtime_error("Metric::SetTopK k must be at least 1"));
+    }
+    m_topK = a_k;
 }
 
-size_t Metric::p_CalcNumTrueNegatives(
-    float a_confidenceLevel) const
+size_t Metric::TopK() const
 {
-    using namespace std::placeholders;
-    auto fp = std::bind(&Metric::p_ExampleIsTrueNegative, this, _1, _2, _3, _4);
-    return p_IterAndCountWithFn(fp, a_confidenceLevel);
+    return m_topK;
+}
+
+void Metric::SetMultiLabel(bool a_isMultiLabel)
+{
+    p_CheckNoResults("SetMultiLabel");
+    m_isMultiLabel = a_isMultiLabel;
+}
+
+bool Metric::IsMultiLabel() const
+{
+    return m_isMultiLabel;
+}
+
+void Metric::ReduceRows(
+    const TTensorPtr& a_outputs, const TTensorPtr& a_targets,
+    std::vector<PredictionRecord>& a_outRecords, size_t a_topK)
+{
+    p_CheckBatch("ReduceRows", a_outputs, a_targets);
+
+    // remember, this is probably the output of a batch of predictions
+    // so reduce every row to a record straight from the raw data
+    size_t l_numRows = a_outputs->Shape().at(0);
+    size_t l_numCols = a_outputs->Shape().at(1);
+    const float* l_outputData = a_outputs->Data().data();
+
+    // argmax of every row of both, one call each
+    static thread_local std::vector<size_t> l_targetIdxs;
+    static thread_local std::vector<size_t> l_predictionIdxs;
+    l_targetIdxs.resize(l_numRows);
+    l_predictionIdxs.resize(l_numRows);
+    Reduction::RowArgMax(a_targets->Data().data(), l_numRows, l_numCols, l_targetIdxs.data());
+    Reduction::RowArgMax(l_outputData, l_numRows, l_numCols, l_predictionIdxs.data());
+
+    a_outRecords.resize(l_numRows);
+    for (size_t i = 0; i < l_numRows; ++i)
+    {
+        const float* l_outputRow = l_outputData + (i * l_numCols);
+        PredictionRecord& l_record = a_outRecords[i];
+        l_record.target = static_cast<uint16_t>(l_targetIdxs[i]);
+        l_record.prediction = static_cast<uint16_t>(l_predictionIdxs[i]);
+        l_record.confidence = l_outputRow[l_record.prediction];
+
+        // the target is in the top k if fewer than k outputs beat it,
+        // then the row counts as predicting it
+        if (a_topK > 1 && l_record.target != l_record.prediction &&
+            BitMask::CountGreater(l_outputRow, l_numCols, l_outputRow[l_record.target]) < a_topK)
+        {
+            l_record.prediction = l_record.target;
+        }
+    }
 }
 
-size_t Metric::p_CalcNumFalsePositives(
-    float a_confidenceLevel) const
+void Metric::ReduceCells(
+    const TTensorPtr& a_outputs, const TTensorPtr& a_targets,
+    std::vector<PredictionRecord>& a_outRecords)
 {
-    using namespace std::placeholders;
-    auto fp = std::bind(&Metric::p_ExampleIsFalsePositive, this, _1, _2, _3, _4);
-    return p_IterAndCountWithFn(fp, a_confidenceLevel);
+    p_CheckBatch("ReduceCells", a_outputs, a_targets);
+
+    size_t l_numCols = a_outputs->Shape().at(1);
+    size_t l_numCells = a_outputs->Shape().at(0) * l_numCols;
+    const float* l_outputData = a_outputs->Data().data();
+
+    // which targets are positive, for the whole batch at once
+    static thread_local std::vector<uint64_t> l_positiveBits;
+    l_positiveBits.resize(BitMask::NumWords(l_numCells));
+    BitMask::Greater(a_targets->Data().data(), l_numCells, 0.5f, l_positiveBits.data());
+
+    a_outRecords.resize(l_numCells);
+    size_t l_col = 0;
+    for (size_t i = 0; i < l_numCells; ++i)
+    {
+        bool l_isPositive = (l_positiveBits[i / 64] >> (i % 64)) & 1;
+        PredictionRecord& l_record = a_outRecords[i];
+        l_record.prediction = static_cast<uint16_t>(l_col);
+        // any other column makes the record incorrect
+        l_record.target = static_cast<uint16_t>(l_isPositive ? l_col : l_col ^ 1);
+        l_record.confidence = l_outputData[i];
+
+        if (++l_col == l_numCols)
+        {
+            l_col = 0;
+        }
+    }
 }
 
-size_t Metric::p_CalcNumFalseNegatives(
-    float a_confidenceLevel) const
+ConfusionCounts Metric::p_CalcConfusionCounts(float a_confidence) const
 {
-    using namespace std::placeholders;
-    auto fp = std::bind(&Metric::p_ExampleIsFalseNegative, this, _1, _2, _3, _4);
-    return p_IterAndCountWithFn(fp, a_confidenceLevel);
+    return m_accumulator->CalcConfusionCounts(a_confidence);
 }
 
-bool Metric::p_ExampleIsTruePositive(
-    size_t a_targetIdx, size_t a_predIdx,
-    float a_guessConfidence, float a_confidenceCutoff) const
+float Metric::p_CalculateFromCounts(const ConfusionCounts& a_counts) const
 {
-    // correct, and above confidence threshold
-    return (a_targetIdx == a_predIdx) and (a_guessConfidence > a_confidenceCutoff);
+    stringstream l_ss;
+    l_ss << "Metric " << GetName() << " can not be calculated from counts";
+    throw(runtime_error(l_ss.str()));
 }
 
-bool Metric::p_ExampleIsFalsePositive(
-    size_t a_targetIdx, size_t a_predIdx,
-    float a_guessConfidence, float a_confidenceCutoff) const
+float Metric::p_CountsCutoff(float a_confidenceLevel) const
 {
-    // incorrect, and above confidence threshold
-    return (a_targetIdx != a_predIdx) and (a_guessConfidence > a_confidenceCutoff);
+    return a_confidenceLevel;
 }
 
-bool Metric::p_ExampleIsTrueNegative(
-    size_t a_targetIdx, size_t a_predIdx,
-    float a_guessConfidence, float a_confidenceCutoff) const
+void Metric::p_CheckBatch(
+    const char* a_caller, const TTensorPtr& a_outputs, const TTensorPtr& a_targets)
 {
-    // incorrect, but below confidence threshold
-    return (a_targetIdx != a_predIdx) and (a_guessConfidence < a_confidenceCutoff);
+    if (a_outputs->Shape().size() != 2 || !a_outputs->HasSameShape(a_targets) ||
+        a_outputs->Shape().at(1) > UINT16_MAX + 1)
+    {
+        stringstream l_ss;
+        l_ss << "Metric::" << a_caller << " expected outputs and targets to be matrices of the same shape "
+             << "with at most " << UINT16_MAX + 1 << " columns, got "
+             << a_outputs->ShapeStr() << " and " << a_targets->ShapeStr();
+        throw(runtime_error(l_ss.str()));
+    }
 }
 
-bool Metric::p_ExampleIsFalseNegative(
-    size_t a_targetIdx, size_t a_predIdx,
-    float a_guessConfidence, float a_confidenceCutoff) const
+void Metric::p_CheckNoResults(const char* a_setting) const
 {
-    // correct, but below confidence threshol
-    return (a_targetIdx == a_predIdx) and (a_guessConfidence < a_confidenceCutoff);
+    if (NumExamples() > 0)
+    {
+        stringstream l_ss;
+        l_ss << "Metric::" << a_setting << " " << GetName()
+             << " already has " << NumExamples() << " results";
+        throw(runtime_error(l_ss.str()));
+    }
 }
 
 } // namespace metrics
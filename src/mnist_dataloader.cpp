@@ -133,13 +133,14 @@ bool MNISTDataloader::DataAt(
 
     a_outOutput->SetAt({0, l_class}, 1.0);
 
+    float* l_pixels = a_outInput->MutableRowData(0);
     for (size_t i = 0; i < m_imageHeight; ++i)
     {
         for (size_t j = 0; j < m_imageWidth; ++j)
         {
             size_t l_imgDataOffset = (i * m_imageWidth) + j;
-            float l_val = (float)l_imageData.at(l_imgDataOffset);
-            a_outInput->SetAt({0, l_imgDataOffset}, p_TransformToInterval(l_val, 0.0, 255.0, -1.0, 1.0));
+            float l_val = (float)l_imageData[l_imgDataOffset];
+            l_pixels[l_imgDataOffset] = p_TransformToInterval(l_val, 0.0, 255.0, -1.0, 1.0);
         }
     }
     return true;
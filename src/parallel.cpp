@@ -0,0 +1,41 @@
+/*
+ * Parallel helpers Implementation
+ *
+ */
+
+#include "neural/util/parallel.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+namespace neural
+{
+
+size_t Parallel::NumThreads()
+{
+#ifdef _OPENMP
+    return static_cast<size_t>(omp_get_max_threads());
+#else
+    return 1;
+#endif
+}
+
+std::vector<size_t> Parallel::ChunkBounds(size_t a_size, size_t a_numChunks)
+{
+    if (0 == a_numChunks)
+    {
+        a_numChunks = 1;
+    }
+
+    vector<size_t> l_bounds(a_numChunks + 1);
+    for (size_t i = 0; i <= a_numChunks; ++i)
+    {
+        l_bounds[i] = (a_size / a_numChunks) * i + min(i, a_size % a_numChunks);
+    }
+    return l_bounds;
+}
+
+} // namespace neural
@@ -15,10 +15,18 @@ namespace metrics
 
 const std::string Precision::NAME = "precision";
 
-Precision::Precision(size_t a_runningAvgLen)
-    : Metric(a_runningAvgLen)
+Precision::Precision(size_t a_windowSize)
+    : Metric(a_windowSize)
 {
+    // keep the default cutoff O(1) to calculate
+    TrackCutoff(0.5);
+}
 
+Precision::Precision(const TAccumulatorPtr& a_accumulator)
+    : Metric(a_accumulator)
+{
+    // keep the default cutoff O(1) to calculate
+    TrackCutoff(0.5);
 }
 
 // name for logging / debugging
@@ -30,8 +38,13 @@ const std::string& Precision::GetName() const
 // calculate the metric
 float Precision::Calculate(float a_confidenceLevel) const
 {
-    float l_tp = static_cast<float>(p_CalcNumTruePositives(a_confidenceLevel));
-    float l_fp = static_cast<float>(p_CalcNumFalsePositives(a_confidenceLevel));
+    return p_CalculateFromCounts(p_CalcConfusionCounts(a_confidenceLevel));
+}
+
+float Precision::p_CalculateFromCounts(const ConfusionCounts& a_counts) const
+{
+    float l_tp = static_cast<float>(a_counts.truePositives);
+    float l_fp = static_cast<float>(a_counts.falsePositives);
 
     if (0.0f == l_tp and 0.0f == l_fp)
     {
@@ -0,0 +1,279 @@
+/*
+ * Precision Recall Curve Implementation
+ *
+ */
+
+#include "neural/metrics/precision_recall_curve.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace neural
+{
+
+namespace metrics
+{
+
+const std::string PrecisionRecallCurve::NAME = "precision_recall_curve";
+
+PrecisionRecallCurve::PrecisionRecallCurve(size_t a_windowSize)
+    : PrecisionRecallCurve(RecordAccumulator::New(a_windowSize))
+{
+
+}
+
+PrecisionRecallCurve::PrecisionRecallCurve(
+    const TRecordAccumulatorPtr& a_accumulator)
+    : Metric(a_accumulator)
+    , m_records(a_accumulator)
+    , m_hasIndex(false)
+    , m_indexVersion(0)
+{
+
+}
+
+// name for logging / debugging
+const std::string& PrecisionRecallCurve::GetName() const
+{
+    return NAME;
+}
+
+// calculate the metric
+float PrecisionRecallCurve::Calculate(float a_confidenceLevel) const
+{
+    return p_CalculateFromCounts(p_CountsAt(a_confidenceLevel));
+}
+
+float PrecisionRecallCurve::p_CalculateFromCounts(const ConfusionCounts& a_counts) const
+{
+    CurvePoint l_point = CurvePoint::FromCounts(0.0f, a_counts);
+
+    // avoid NaN
+    if (0.0f == l_point.precision and 0.0f == l_point.recall)
+    {
+        return 0.0f;
+    }
+
+    return (2.0f * l_point.precision * l_point.recall) /
+           (l_point.precision + l_point.recall);
+}
+
+std::vector<CurvePoint> PrecisionRecallCurve::Points() const
+{
+    p_BuildIndex();
+
+    vector<CurvePoint> l_points;
+    size_t l_lower = 0;
+    while (l_lower < m_sortedConfidences.size())
+    {
+        // walk to the end of the run of equal confidences
+        float l_confidence = m_sortedConfidences[l_lower];
+        size_t l_upper = l_lower + 1;
+        while (l_upper < m_sortedConfidences.size() &&
+               m_sortedConfidences[l_upper] == l_confidence)
+        {
+            ++l_upper;
+        }
+
+        l_points.push_back(CurvePoint::FromCounts(
+            l_confidence, p_CountsBetween(l_lower, l_upper)));
+        l_lower = l_upper;
+    }
+    return l_points;
+}
+
+std::vector<CurvePoint> PrecisionRecallCurve::Points(
+    const std::vector<float>& a_cutoffs) const
+{
+    vector<CurvePoint> l_points;
+    l_points.reserve(a_cutoffs.size());
+    for (size_t i = 0; i < a_cutoffs.size(); ++i)
+    {
+        l_points.push_back(CurvePoint::FromCounts(
+            a_cutoffs[i], p_CountsAt(a_cutoffs[i])));
+    }
+    return l_points;
+}
+
+bool PrecisionRecallCurve::ThresholdAtPrecision(
+    float a_precision, CurvePoint& a_outPoint) const
+{
+    p_BuildIndex();
+
+    // first run start where the best precision so far reaches the target,
+    // which is the first one whose own precision does
+    vector<float>::const_iterator l_found = std::lower_bound(
+        m_bestPrecisionThrough.begin(), m_bestPrecisionThrough.end(), a_precision);
+    if (l_found == m_bestPrecisionThrough.end())
+    {
+        return false;
+    }
+
+    a_outPoint = p_PointUnder(m_runStarts[l_found - m_bestPrecisionThrough.begin()]);
+    return true;
+}
+
+bool PrecisionRecallCurve::ThresholdAtRecall(
+    float a_recall, CurvePoint& a_outPoint) const
+{
+    p_BuildIndex();
+
+    // recall only goes down as the cutoff goes up, so find the last run
+    // start that still reaches the target
+    vector<size_t>::const_iterator l_found = std::partition_point(
+        m_runStarts.begin(), m_runStarts.end(),
+        [this, a_recall](size_t a_start)
+        {
+            return p_RecallFrom(a_start) >= a_recall;
+        });
+    if (l_found == m_runStarts.begin())
+    {
+        return false;
+    }
+
+    a_outPoint = p_PointUnder(*(l_found - 1));
+    return true;
+}
+
+bool PrecisionRecallCurve::MaxFBetaThreshold(
+    float a_beta, CurvePoint& a_outPoint) const
+{
+    p_BuildIndex();
+    if (m_runStarts.empty())
+    {
+        return false;
+    }
+
+    map<float, size_t>::const_iterator l_cached = m_bestRunByBeta.find(a_beta);
+    if (l_cached == m_bestRunByBeta.end())
+    {
+        float l_betaSquared = a_beta * a_beta;
+        size_t l_bestRun = 0;
+        float l_bestScore = -1.0f;
+        for (size_t i = 0; i < m_runStarts.size(); ++i)
+        {
+            float l_precision = p_PrecisionFrom(m_runStarts[i]);
+            float l_recall = p_RecallFrom(m_runStarts[i]);
+            float l_denominator = (l_betaSquared * l_precision) + l_recall;
+            // avoid NaN
+            float l_score = (0.0f == l_denominator) ? 0.0f :
+                ((1.0f + l_betaSquared) * l_precision * l_recall) / l_denominator;
+            if (l_score > l_bestScore)
+            {
+                l_bestScore = l_score;
+                l_bestRun = i;
+            }
+        }
+        l_cached = m_bestRunByBeta.insert(make_pair(a_beta, l_bestRun)).first;
+    }
+
+    a_outPoint = p_PointUnder(m_runStarts[l_cached->second]);
+    return true;
+}
+
+void PrecisionRecallCurve::p_BuildIndex() const
+{
+    if (m_hasIndex && m_indexVersion == m_records->Version())
+    {
+        return;
+    }
+
+    // sort a copy of the window so the ring buffer stays intact
+    vector<PredictionRecord> l_sorted(m_records->UnorderedRecords());
+    std::sort(l_sorted.begin(), l_sorted.end(),
+        [](const PredictionRecord& a_lhs, const PredictionRecord& a_rhs)
+        {
+            return a_lhs.confidence < a_rhs.confidence;
+        });
+
+    m_sortedConfidences.resize(l_sorted.size());
+    m_correctBelow.resize(l_sorted.size() + 1);
+    m_correctBelow[0] = 0;
+    for (size_t i = 0; i < l_sorted.size(); ++i)
+    {
+        bool l_isCorrect = (l_sorted[i].target == l_sorted[i].prediction);
+        m_sortedConfidences[i] = l_sorted[i].confidence;
+        m_correctBelow[i + 1] = m_correctBelow[i] + (l_isCorrect ? 1 : 0);
+    }
+
+    m_runStarts.clear();
+    m_bestPrecisionThrough.clear();
+    for (size_t i = 0; i < m_sortedConfidences.size(); ++i)
+    {
+        if (0 == i || m_sortedConfidences[i] != m_sortedConfidences[i - 1])
+        {
+            float l_precision = p_PrecisionFrom(i);
+            if (!m_bestPrecisionThrough.empty())
+            {
+                l_precision = std::max(l_precision, m_bestPrecisionThrough.back());
+            }
+            m_runStarts.push_back(i);
+            m_bestPrecisionThrough.push_back(l_precision);
+        }
+    }
+    m_bestRunByBeta.clear();
+
+    m_hasIndex = true;
+    m_indexVersion = m_records->Version();
+}
+
+ConfusionCounts PrecisionRecallCurve::p_CountsAt(float a_confidence) const
+{
+    p_BuildIndex();
+
+    size_t l_lower = std::lower_bound(
+        m_sortedConfidences.begin(), m_sortedConfidences.end(), a_confidence) -
+        m_sortedConfidences.begin();
+    size_t l_upper = std::upper_bound(
+        m_sortedConfidences.begin() + l_lower, m_sortedConfidences.end(), a_confidence) -
+        m_sortedConfidences.begin();
+    return p_CountsBetween(l_lower, l_upper);
+}
+
+ConfusionCounts PrecisionRecallCurve::p_CountsBetween(
+    size_t a_lower, size_t a_upper) const
+{
+    // everything below a_lower is under the cutoff, everything from
+    // a_upper on is over it, same as RecordAccumulator::CalcConfusionCounts
+    size_t l_numRecords = m_sortedConfidences.size();
+    size_t l_numCorrect = m_correctBelow[l_numRecords];
+
+    ConfusionCounts l_counts;
+    l_counts.truePositives = l_numCorrect - m_correctBelow[a_upper];
+    l_counts.falsePositives = (l_numRecords - a_upper) - l_counts.truePositives;
+    l_counts.falseNegatives = m_correctBelow[a_lower];
+    l_counts.trueNegatives = a_lower - l_counts.falseNegatives;
+    return l_counts;
+}
+
+float PrecisionRecallCurve::p_PrecisionFrom(size_t a_start) const
+{
+    size_t l_numRecords = m_sortedConfidences.size();
+    size_t l_numCorrect = m_correctBelow[l_numRecords] - m_correctBelow[a_start];
+    return (l_numRecords == a_start) ? 0.0f :
+        static_cast<float>(l_numCorrect) / static_cast<float>(l_numRecords - a_start);
+}
+
+float PrecisionRecallCurve::p_RecallFrom(size_t a_start) const
+{
+    size_t l_numRecords = m_sortedConfidences.size();
+    size_t l_numCorrect = m_correctBelow[l_numRecords];
+    return (0 == l_numCorrect) ? 0.0f :
+        static_cast<float>(l_numCorrect - m_correctBelow[a_start]) /
+        static_cast<float>(l_numCorrect);
+}
+
+CurvePoint PrecisionRecallCurve::p_PointUnder(size_t a_start) const
+{
+    // counted for real so the point matches Points(cutoffs) exactly
+    float l_cutoff = std::nextafter(
+        m_sortedConfidences[a_start], -numeric_limits<float>::infinity());
+    return CurvePoint::FromCounts(l_cutoff, p_CountsAt(l_cutoff));
+}
+
+} // namespace metric
+
+} // namespace neural
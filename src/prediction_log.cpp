@@ -0,0 +1,251 @@
+/*
+ * Prediction Log Implementation
+ *
+ */
+
+#include "neural/data/prediction_log.h"
+#include "neural/math/reduction.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace neural
+{
+
+const uint64_t PredictionLog::MAGIC;
+const uint64_t PredictionLog::FORMAT_VERSION;
+const size_t PredictionLog::HEADER_SIZE;
+
+PredictionLogWriter::PredictionLogWriter(const std::string& a_path, size_t a_numCols)
+    : m_stream(a_path.c_str(), ios::binary | ios::trunc)
+    , m_numCols(a_numCols)
+    , m_numRows(0)
+{
+    if (0 == m_numCols || m_numCols > UINT16_MAX + 1)
+    {
+        stringstream l_ss;
+        l_ss << "PredictionLogWriter number of columns " << m_numCols
+             << " not in [1, " << UINT16_MAX + 1 << "]";
+        throw(runtime_error(l_ss.str()));
+    }
+    if (!m_stream)
+    {
+        stringstream l_ss;
+        l_ss << "PredictionLogWriter could not open " << a_path;
+        throw(runtime_error(l_ss.str()));
+    }
+
+    uint64_t l_header[3] = {PredictionLog::MAGIC, PredictionLog::FORMAT_VERSION, m_numCols};
+    m_stream.write(reinterpret_cast<const char*>(l_header), sizeof(l_header));
+    p_CheckStream("write header");
+}
+
+void PredictionLogWriter::Append(const TTensorPtr& a_outputs, const TTensorPtr& a_targets)
+{
+    if (a_outputs->Shape().size() != 2 || !a_outputs->HasSameShape(a_targets) ||
+        a_outputs->Shape().at(1) != m_numCols)
+    {
+        stringstream l_ss;
+        l_ss << "PredictionLogWriter::Append expected outputs and targets with "
+             << m_numCols << " columns, got "
+             << a_outputs->ShapeStr() << " and " << a_targets->ShapeStr();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    size_t l_numRows = a_outputs->Shape().at(0);
+    const float* l_outputData = a_outputs->Data().data();
+    const float* l_targetData = a_targets->Data().data();
+    for (size_t i = 0; i < l_numRows; ++i)
+    {
+        uint32_t l_label = static_cast<uint32_t>(
+            Reduction::ArgMax(l_targetData + (i * m_numCols), m_numCols));
+        Append(l_outputData + (i * m_numCols), l_label);
+    }
+}
+
+void PredictionLogWriter::Append(const float* a_outputs, uint32_t a_label)
+{
+    m_stream.write(reinterpret_cast<const char*>(a_outputs), m_numCols * sizeof(float));
+    m_stream.write(reinterpret_cast<const char*>(&a_label), sizeof(a_label));
+    p_CheckStream("append");
+    ++m_numRows;
+}
+
+size_t PredictionLogWriter::NumCols() const
+{
+    return m_numCols;
+}
+
+size_t PredictionLogWriter::NumRows() const
+{
+    return m_numRows;
+}
+
+void PredictionLogWriter::Flush()
+{
+    m_stream.flush();
+    p_CheckStream("flush");
+}
+
+void PredictionLogWriter::p_CheckStream(const char* a_action)
+{
+    if (!m_stream)
+    {
+        stringstream l_ss;
+        l_ss << "PredictionLogWriter failed to " << a_action;
+        throw(runtime_error(l_ss.str()));
+    }
+}
+
+PredictionLog::PredictionLog(const std::string& a_path)
+    : m_data(nullptr)
+    , m_numBytes(0)
+    , m_numCols(0)
+    , m_numRows(0)
+    , m_rowStride(0)
+{
+    int l_fd = open(a_path.c_str(), O_RDONLY);
+    if (l_fd < 0)
+    {
+        stringstream l_ss;
+        l_ss << "PredictionLog could not open " << a_path;
+        throw(runtime_error(l_ss.str()));
+    }
+
+    struct stat l_stat;
+    if (fstat(l_fd, &l_stat) != 0 || static_cast<size_t>(l_stat.st_size) < HEADER_SIZE)
+    {
+        close(l_fd);
+        stringstream l_ss;
+        l_ss << "PredictionLog " << a_path << " is too small for a header";
+        throw(runtime_error(l_ss.str()));
+    }
+
+    m_numBytes = static_cast<size_t>(l_stat.st_size);
+    void* l_map = mmap(nullptr, m_numBytes, PROT_READ, MAP_SHARED, l_fd, 0);
+    // the mapping keeps its own reference to the file
+    close(l_fd);
+    if (MAP_FAILED == l_map)
+    {
+        stringstream l_ss;
+        l_ss << "PredictionLog could not map " << a_path;
+        throw(runtime_error(l_ss.str()));
+    }
+    m_data = static_cast<const char*>(l_map);
+    // we scan front to back, so read ahead aggressively
+    madvise(l_map, m_numBytes, MADV_SEQUENTIAL);
+
+    uint64_t l_header[3];
+    memcpy(l_header, m_data, sizeof(l_header));
+    m_numCols = static_cast<size_t>(l_header[2]);
+    m_rowStride = (m_numCols * sizeof(float)) + sizeof(uint32_t);
+
+    stringstream l_ss;
+    if (l_header[0] != MAGIC)
+    {
+        l_ss << "PredictionLog " << a_path << " is not a prediction log";
+    }
+    else if (l_header[1] != FORMAT_VERSION)
+    {
+        l_ss << "PredictionLog " << a_path << " has format version " << l_header[1]
+             << ", expected " << FORMAT_VERSION;
+    }
+    else if (0 == m_numCols || m_numCols > UINT16_MAX + 1)
+    {
+        l_ss << "PredictionLog " << a_path << " has " << m_numCols << " columns";
+    }
+    else if ((m_numBytes - HEADER_SIZE) % m_rowStride != 0)
+    {
+        l_ss << "PredictionLog " << a_path << " ends part way through a row";
+    }
+
+    if (!l_ss.str().empty())
+    {
+        munmap(l_map, m_numBytes);
+        throw(runtime_error(l_ss.str()));
+    }
+    m_numRows = (m_numBytes - HEADER_SIZE) / m_rowStride;
+}
+
+PredictionLog::~PredictionLog()
+{
+    munmap(const_cast<char*>(m_data), m_numBytes);
+}
+
+TPredictionLogPtr PredictionLog::New(const std::string& a_path)
+{
+    return TPredictionLogPtr(new PredictionLog(a_path));
+}
+
+size_t PredictionLog::NumCols() const
+{
+    return m_numCols;
+}
+
+size_t PredictionLog::NumRows() const
+{
+    return m_numRows;
+}
+
+size_t PredictionLog::NumBytes() const
+{
+    return m_numBytes;
+}
+
+const float* PredictionLog::Outputs(size_t a_row) const
+{
+    return reinterpret_cast<const float*>(p_Row(a_row));
+}
+
+uint32_t PredictionLog::Label(size_t a_row) const
+{
+    uint32_t l_label;
+    memcpy(&l_label, p_Row(a_row) + (m_numCols * sizeof(float)), sizeof(l_label));
+    return l_label;
+}
+
+void PredictionLog::ReduceRows(size_t a_begin, size_t a_end,
+    std::vector<metrics::PredictionRecord>& a_outRecords) const
+{
+    if (a_begin > a_end || a_end > m_numRows)
+    {
+        stringstream l_ss;
+        l_ss << "PredictionLog::ReduceRows range [" << a_begin << ", " << a_end
+             << ") outside of " << m_numRows << " rows";
+        throw(runtime_error(l_ss.str()));
+    }
+
+    a_outRecords.resize(a_end - a_begin);
+    for (size_t i = a_begin; i < a_end; ++i)
+    {
+        const float* l_outputs = Outputs(i);
+        uint32_t l_label = Label(i);
+        if (l_label >= m_numCols)
+        {
+            stringstream l_ss;
+            l_ss << "PredictionLog::ReduceRows row " << i << " has label " << l_label
+                 << " >= " << m_numCols << " columns";
+            throw(runtime_error(l_ss.str()));
+        }
+
+        metrics::PredictionRecord& l_record = a_outRecords[i - a_begin];
+        l_record.target = static_cast<uint16_t>(l_label);
+        l_record.prediction = static_cast<uint16_t>(Reduction::ArgMax(l_outputs, m_numCols));
+        l_record.confidence = l_outputs[l_record.prediction];
+    }
+}
+
+const char* PredictionLog::p_Row(size_t a_row) const
+{
+    return m_data + HEADER_SIZE + (a_row * m_rowStride);
+}
+
+} // namespace neural
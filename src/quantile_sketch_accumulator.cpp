@@ -0,0 +1,173 @@
+/*
+ * QuantileSketchAccumulator Implementation
+ *
+ */
+
+#include "neural/metrics/quantile_sketch_accumulator.h"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace neural
+{
+
+namespace metrics
+{
+
+QuantileSketchAccumulator::QuantileSketchAccumulator(size_t a_k)
+    : m_correct(a_k)
+    , m_incorrect(a_k)
+{
+
+}
+
+TQuantileSketchAccumulatorPtr QuantileSketchAccumulator::New(size_t a_k)
+{
+    return TQuantileSketchAccumulatorPtr(new QuantileSketchAccumulator(a_k));
+}
+
+ConfusionCounts QuantileSketchAccumulator::CalcConfusionCounts(float a_confidence) const
+{
+    ConfusionCounts l_counts;
+    l_counts.truePositives = m_correct.Count() - m_correct.CountAtOrBelow(a_confidence);
+    l_counts.falseNegatives = m_correct.CountBelow(a_confidence);
+    l_counts.falsePositives = m_incorrect.Count() - m_incorrect.CountAtOrBelow(a_confidence);
+    l_counts.trueNegatives = m_incorrect.CountBelow(a_confidence);
+    return l_counts;
+}
+
+size_t QuantileSketchAccumulator::NumExamples() const
+{
+    return m_correct.Count() + m_incorrect.Count();
+}
+
+float QuantileSketchAccumulator::ThresholdForRecall(float a_recall) const
+{
+    if (0 == m_correct.Count())
+    {
+        return 0.0f;
+    }
+
+    // at least `a_recall` of the correct confidences are >= this one,
+    // so a cutoff just under it has them all above it
+    float l_confidence = m_correct.Quantile(1.0 - a_recall);
+    return nextafter(l_confidence, -numeric_limits<float>::infinity());
+}
+
+size_t QuantileSketchAccumulator::K() const
+{
+    return m_correct.K();
+}
+
+size_t QuantileSketchAccumulator::NumRetained() const
+{
+    return m_correct.NumRetained() + m_incorrect.NumRetained();
+}
+
+void QuantileSketchAccumulator::p_Add(
+    const PredictionRecord* a_records, size_t a_numRecords)
+{
+    for (size_t i = 0; i < a_numRecords; ++i)
+    {
+        if (a_records[i].target == a_records[i].prediction)
+        {
+            m_correct.Update(a_records[i].confidence);
+        }
+        else
+        {
+            m_incorrect.Update(a_records[i].confidence);
+        }
+    }
+}
+
+void QuantileSketchAccumulator::p_Merge(const Accumulator& a_other)
+{
+    const QuantileSketchAccumulator& l_other =
+        static_cast<const QuantileSketchAccumulator&>(a_other);
+    m_correct.Merge(l_other.m_correct);
+    m_incorrect.Merge(l_other.m_incorrect);
+}
+
+uint32_t QuantileSketchAccumulator::p_SerialTag() const
+{
+    return SERIAL_TAG;
+}
+
+void QuantileSketchAccumulator::p_Serialize(std::ostream& a_stream) const
+{
+    p_WriteU64(a_stream, K());
+    p_WriteSketch(a_stream, m_correct);
+    p_WriteSketch(a_stream, m_incorrect);
+}
+
+void QuantileSketchAccumulator::p_Deserialize(std::istream& a_stream)
+{
+    // throws before touching anything if k is invalid
+    KllSketch l_correct(p_ReadU64(a_stream));
+    KllSketch l_incorrect(l_correct.K());
+    p_ReadSketch(a_stream, l_correct);
+    p_ReadSketch(a_stream, l_incorrect);
+    m_correct = l_correct;
+    m_incorrect = l_incorrect;
+}
+
+void QuantileSketchAccumulator::p_WriteSketch(
+    std::ostream& a_stream, const KllSketch& a_sketch)
+{
+    const vector<vector<float> >& l_levels = a_sketch.Levels();
+    p_WriteU64(a_stream, a_sketch.Count());
+    p_WriteU64(a_stream, l_levels.size());
+    for (const vector<float>& l_level : l_levels)
+    {
+        p_WriteU64(a_stream, l_level.size());
+        for (float l_value : l_level)
+        {
+            p_WriteF32(a_stream, l_value);
+        }
+    }
+}
+
+void QuantileSketchAccumulator::p_ReadSketch(
+    std::istream& a_stream, KllSketch& a_sketch)
+{
+    // the sizes are checked before anything is allocated for them, so
+    // a corrupt stream throws instead of asking for a huge buffer
+    size_t l_count = p_ReadU64(a_stream);
+    size_t l_numLevels = p_ReadU64(a_stream);
+    if (l_numLevels > KllSketch::MAX_LEVELS)
+    {
+        stringstream l_ss;
+        l_ss << "QuantileSketchAccumulator::Deserialize too many levels " << l_numLevels;
+        throw(runtime_error(l_ss.str()));
+    }
+
+    vector<vector<float> > l_levels(l_numLevels);
+    size_t l_remaining = l_count;
+    for (size_t i = 0; i < l_levels.size(); ++i)
+    {
+        // every value on level i stands in for 2^i of the count
+        size_t l_size = p_ReadU64(a_stream);
+        if (l_size > (l_remaining >> i))
+        {
+            stringstream l_ss;
+            l_ss << "QuantileSketchAccumulator::Deserialize level " << i << " holds "
+                 << l_size << " values, more than the count " << l_count << " allows";
+            throw(runtime_error(l_ss.str()));
+        }
+        l_remaining -= l_size << i;
+
+        for (size_t j = 0; j < l_size; ++j)
+        {
+            l_levels[i].push_back(p_ReadF32(a_stream));
+        }
+    }
+    a_sketch.Restore(l_count, l_levels);
+}
+
+} // namespace metrics
+
+} // namespace neural
@@ -15,10 +15,18 @@ namespace metrics
 
 const std::string Recall::NAME = "recall";
 
-Recall::Recall(size_t a_runningAvgLen)
-    : Metric(a_runningAvgLen)
+Recall::Recall(size_t a_windowSize)
+    : Metric(a_windowSize)
 {
+    // keep the default cutoff O(1) to calculate
+    TrackCutoff(0.5);
+}
 
+Recall::Recall(const TAccumulatorPtr& a_accumulator)
+    : Metric(a_accumulator)
+{
+    // keep the default cutoff O(1) to calculate
+    TrackCutoff(0.5);
 }
 
 // name for logging / debugging
@@ -30,8 +38,13 @@ const std::string& Recall::GetName() const
 // calculate the metric
 float Recall::Calculate(float a_confidenceLevel) const
 {
-    float l_tp = static_cast<float>(p_CalcNumTruePositives(a_confidenceLevel));
-    float l_fn = static_cast<float>(p_CalcNumFalseNegatives(a_confidenceLevel));
+    return p_CalculateFromCounts(p_CalcConfusionCounts(a_confidenceLevel));
+}
+
+float Recall::p_CalculateFromCounts(const ConfusionCounts& a_counts) const
+{
+    float l_tp = static_cast<float>(a_counts.truePositives);
+    float l_fn = static_cast<float>(a_counts.falseNegatives);
 
     if (0.0f == l_tp and 0.0f == l_fn)
     {
@@ -0,0 +1,225 @@
+/*
+ * RecordAccumulator Implementation
+ *
+ */
+
+#include "neural/metrics/record_accumulator.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace neural
+{
+
+namespace metrics
+{
+
+RecordAccumulator::RecordAccumulator(size_t a_windowSize)
+    : m_windowSize(a_windowSize)
+    , m_oldestRecord(0)
+{
+
+}
+
+TRecordAccumulatorPtr RecordAccumulator::New(size_t a_windowSize)
+{
+    return TRecordAccumulatorPtr(new RecordAccumulator(a_windowSize));
+}
+
+ConfusionCounts RecordAccumulator::CalcConfusionCounts(float a_confidence) const
+{
+    for (size_t i = 0; i < m_trackedCutoffs.size(); ++i)
+    {
+        if (m_trackedCutoffs[i] == a_confidence)
+        {
+            return m_trackedCounts[i];
+        }
+    }
+
+    // iterate over all records in the window, order does not matter
+    ConfusionCounts l_counts = {0, 0, 0, 0};
+    for (size_t i = 0; i < m_records.size(); ++i)
+    {
+        size_t* l_counter = p_CounterFor(m_records[i], a_confidence, l_counts);
+        if (l_counter)
+        {
+            ++(*l_counter);
+        }
+    }
+    return l_counts;
+}
+
+void RecordAccumulator::TrackCutoff(float a_confidence)
+{
+    for (size_t i = 0; i < m_trackedCutoffs.size(); ++i)
+    {
+        if (m_trackedCutoffs[i] == a_confidence)
+        {
+            return;
+        }
+    }
+
+    // seed the counts from whatever is already in the window
+    ConfusionCounts l_counts = CalcConfusionCounts(a_confidence);
+    m_trackedCutoffs.push_back(a_confidence);
+    m_trackedCounts.push_back(l_counts);
+}
+
+size_t RecordAccumulator::NumExamples() const
+{
+    return m_records.size();
+}
+
+std::vector<PredictionRecord> RecordAccumulator::Records() const
+{
+    // unroll the ring buffer starting at the oldest record
+    vector<PredictionRecord> l_records;
+    l_records.reserve(m_records.size());
+    l_records.insert(l_records.end(),
+        m_records.begin() + m_oldestRecord, m_records.end());
+    l_records.insert(l_records.end(),
+        m_records.begin(), m_records.begin() + m_oldestRecord);
+    return l_records;
+}
+
+const std::vector<PredictionRecord>& RecordAccumulator::UnorderedRecords() const
+{
+    return m_records;
+}
+
+void RecordAccumulator::p_Add(
+    const PredictionRecord* a_records, size_t a_numRecords)
+{
+    if (0 == m_windowSize && m_trackedCutoffs.empty())
+    {
+        // nothing is ever evicted or counted, so append in one go
+        m_records.insert(m_records.end(), a_records, a_records + a_numRecords);
+        return;
+    }
+
+    for (size_t i = 0; i < a_numRecords; ++i)
+    {
+        p_AddRecord(a_records[i]);
+    }
+}
+
+void RecordAccumulator::p_Merge(const Accumulator& a_other)
+{
+    const RecordAccumulator& l_other = static_cast<const RecordAccumulator&>(a_other);
+    vector<PredictionRecord> l_records = l_other.Records();
+    p_Add(l_records.data(), l_records.size());
+}
+
+uint32_t RecordAccumulator::p_SerialTag() const
+{
+    return SERIAL_TAG;
+}
+
+void RecordAccumulator::p_Serialize(std::ostream& a_stream) const
+{
+    p_WriteU64(a_stream, m_windowSize);
+
+    vector<PredictionRecord> l_records = Records();
+    p_WriteU64(a_stream, l_records.size());
+    for (size_t i = 0; i < l_records.size(); ++i)
+    {
+        p_WriteRecord(a_stream, l_records[i]);
+    }
+
+    p_WriteU64(a_stream, m_trackedCutoffs.size());
+    for (size_t i = 0; i < m_trackedCutoffs.size(); ++i)
+    {
+        p_WriteF32(a_stream, m_trackedCutoffs[i]);
+        p_WriteCounts(a_stream, m_trackedCounts[i]);
+    }
+}
+
+void RecordAccumulator::p_Deserialize(std::istream& a_stream)
+{
+    // everything is read into locals first, so a corrupt or truncated
+    // stream throws and leaves this accumulator as it was
+    size_t l_windowSize = p_ReadU64(a_stream);
+    size_t l_numRecords = p_ReadU64(a_stream);
+    if (0 != l_windowSize && l_numRecords > l_windowSize)
+    {
+        stringstream l_ss;
+        l_ss << "RecordAccumulator::Deserialize " << l_numRecords
+             << " records do not fit a window of " << l_windowSize;
+        throw(runtime_error(l_ss.str()));
+    }
+
+    vector<PredictionRecord> l_records;
+    for (size_t i = 0; i < l_numRecords; ++i)
+    {
+        l_records.push_back(p_ReadRecord(a_stream));
+    }
+
+    // cutoffs tracked here stay tracked, the loaded ones are added
+    vector<float> l_cutoffs(m_trackedCutoffs);
+    size_t l_numTracked = p_ReadU64(a_stream);
+    for (size_t i = 0; i < l_numTracked; ++i)
+    {
+        float l_cutoff = p_ReadF32(a_stream);
+        p_ReadCounts(a_stream);
+        if (std::find(l_cutoffs.begin(), l_cutoffs.end(), l_cutoff) == l_cutoffs.end())
+        {
+            l_cutoffs.push_back(l_cutoff);
+        }
+    }
+
+    // records were written oldest first, so the ring starts over at 0
+    m_windowSize = l_windowSize;
+    m_records.swap(l_records);
+    m_oldestRecord = 0;
+
+    // and every count is redone from the loaded records
+    m_trackedCutoffs.clear();
+    m_trackedCounts.clear();
+    for (float l_cutoff : l_cutoffs)
+    {
+        TrackCutoff(l_cutoff);
+    }
+}
+
+void RecordAccumulator::p_AddRecord(const PredictionRecord& a_record)
+{
+    if (0 == m_windowSize || m_records.size() < m_windowSize)
+    {
+        m_records.push_back(a_record);
+    }
+    else
+    {
+        // window is full, evict the oldest record from the tracked counts
+        // and reuse its slot
+        PredictionRecord& l_oldest = m_records[m_oldestRecord];
+        for (size_t i = 0; i < m_trackedCutoffs.size(); ++i)
+        {
+            size_t* l_counter = p_CounterFor(
+                l_oldest, m_trackedCutoffs[i], m_trackedCounts[i]);
+            if (l_counter)
+            {
+                --(*l_counter);
+            }
+        }
+
+        l_oldest = a_record;
+        m_oldestRecord = (m_oldestRecord + 1) % m_windowSize;
+    }
+
+    for (size_t i = 0; i < m_trackedCutoffs.size(); ++i)
+    {
+        size_t* l_counter = p_CounterFor(
+            a_record, m_trackedCutoffs[i], m_trackedCounts[i]);
+        if (l_counter)
+        {
+            ++(*l_counter);
+        }
+    }
+}
+
+} // namespace metrics
+
+} // namespace neural
@@ -0,0 +1,422 @@
+/*
+ * Reduction implementation
+ *
+ * Max, sum and find-first-equal are written once per instruction set,
+ * argmax and log-sum-exp are built from them and the Elementwise
+ * kernels. Column reductions walk the matrix a row at a time with the
+ * Elementwise kernels so they stream through memory in order.
+ */
+
+#include "neural/math/reduction.h"
+#include "neural/math/elementwise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NEURAL_REDUCTION_X86 1
+// see elementwise.cpp, gcc 12 warns from inside the AVX-512 intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#define NEURAL_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define NEURAL_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+using namespace std;
+
+namespace neural
+{
+
+namespace
+{
+
+typedef float (*TReduceFn)(const float*, size_t);
+typedef size_t (*TIndexOfFn)(const float*, size_t, float);
+
+struct Kernels
+{
+    TReduceFn m_max;
+    TReduceFn m_sum;
+    // index of the first value equal to the one given, size if none is
+    TIndexOfFn m_indexOf;
+};
+
+const float NEG_INF = -numeric_limits<float>::infinity();
+
+// Log-sum-exp shifts this many values at a time through a stack buffer
+const size_t LOG_SUM_EXP_CHUNK = 256;
+
+/*
+ * Scalar
+ */
+
+// NaN never compares greater, so it is skipped
+inline float ScalarMaxFrom(float a_max, const float* a_in, size_t a_size)
+{
+    for (size_t i = 0; i < a_size; ++i)
+    {
+        a_max = a_in[i] > a_max ? a_in[i] : a_max;
+    }
+    return a_max;
+}
+
+float ScalarMax(const float* a_in, size_t a_size)
+{
+    return ScalarMaxFrom(NEG_INF, a_in, a_size);
+}
+
+float ScalarSum(const float* a_in, size_t a_size)
+{
+    float l_sum = 0.0;
+    for (size_t i = 0; i < a_size; ++i)
+    {
+        l_sum += a_in[i];
+    }
+    return l_sum;
+}
+
+size_t ScalarIndexOf(const float* a_in, size_t a_size, float a_val)
+{
+    for (size_t i = 0; i < a_size; ++i)
+    {
+        if (a_in[i] == a_val)
+        {
+            return i;
+        }
+    }
+    return a_size;
+}
+
+#if defined(NEURAL_REDUCTION_X86)
+
+/*
+ * AVX2, 8 floats at a time
+ */
+
+NEURAL_TARGET_AVX2 float Avx2Max(const float* a_in, size_t a_size)
+{
+    // two accumulators to hide the latency of max
+    __m256 l_max0 = _mm256_set1_ps(NEG_INF);
+    __m256 l_max1 = l_max0;
+    size_t i = 0;
+    for (; i + 16 <= a_size; i += 16)
+    {
+        l_max0 = _mm256_max_ps(_mm256_loadu_ps(a_in + i), l_max0);
+        l_max1 = _mm256_max_ps(_mm256_loadu_ps(a_in + i + 8), l_max1);
+    }
+    for (; i + 8 <= a_size; i += 8)
+    {
+        l_max0 = _mm256_max_ps(_mm256_loadu_ps(a_in + i), l_max0);
+    }
+    l_max0 = _mm256_max_ps(l_max0, l_max1);
+
+    __m128 l_max = _mm_max_ps(_mm256_castps256_ps128(l_max0), _mm256_extractf128_ps(l_max0, 1));
+    l_max = _mm_max_ps(l_max, _mm_movehl_ps(l_max, l_max));
+    l_max = _mm_max_ss(l_max, _mm_shuffle_ps(l_max, l_max, 1));
+    return ScalarMaxFrom(_mm_cvtss_f32(l_max), a_in + i, a_size - i);
+}
+
+NEURAL_TARGET_AVX2 float Avx2Sum(const float* a_in, size_t a_size)
+{
+    // four accumulators to hide the latency of add
+    __m256 l_sum0 = _mm256_setzero_ps();
+    __m256 l_sum1 = l_sum0;
+    __m256 l_sum2 = l_sum0;
+    __m256 l_sum3 = l_sum0;
+    size_t i = 0;
+    for (; i + 32 <= a_size; i += 32)
+    {
+        l_sum0 = _mm256_add_ps(l_sum0, _mm256_loadu_ps(a_in + i));
+        l_sum1 = _mm256_add_ps(l_sum1, _mm256_loadu_ps(a_in + i + 8));
+        l_sum2 = _mm256_add_ps(l_sum2, _mm256_loadu_ps(a_in + i + 16));
+        l_sum3 = _mm256_add_ps(l_sum3, _mm256_loadu_ps(a_in + i + 24));
+    }
+    for (; i + 8 <= a_size; i += 8)
+    {
+        l_sum0 = _mm256_add_ps(l_sum0, _mm256_loadu_ps(a_in + i));
+    }
+    l_sum0 = _mm256_add_ps(_mm256_add_ps(l_sum0, l_sum1), _mm256_add_ps(l_sum2, l_sum3));
+
+    __m128 l_sum = _mm_add_ps(_mm256_castps256_ps128(l_sum0), _mm256_extractf128_ps(l_sum0, 1));
+    l_sum = _mm_add_ps(l_sum, _mm_movehl_ps(l_sum, l_sum));
+    l_sum = _mm_add_ss(l_sum, _mm_shuffle_ps(l_sum, l_sum, 1));
+    return _mm_cvtss_f32(l_sum) + ScalarSum(a_in + i, a_size - i);
+}
+
+NEURAL_TARGET_AVX2 size_t Avx2IndexOf(const float* a_in, size_t a_size, float a_val)
+{
+    __m256 l_val = _mm256_set1_ps(a_val);
+    size_t i = 0;
+    for (; i + 8 <= a_size; i += 8)
+    {
+        int l_bits = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(a_in + i), l_val, _CMP_EQ_OQ));
+        if (l_bits)
+        {
+            return i + __builtin_ctz(l_bits);
+        }
+    }
+    return i + ScalarIndexOf(a_in + i, a_size - i, a_val);
+}
+
+/*
+ * AVX-512, 16 floats at a time, tails are masked
+ */
+
+NEURAL_TARGET_AVX512 inline __mmask16 Avx512TailMask(size_t a_count)
+{
+    return static_cast<__mmask16>((1u << a_count) - 1);
+}
+
+NEURAL_TARGET_AVX512 float Avx512Max(const float* a_in, size_t a_size)
+{
+    __m512 l_negInf = _mm512_set1_ps(NEG_INF);
+    __m512 l_max0 = l_negInf;
+    __m512 l_max1 = l_negInf;
+    size_t i = 0;
+    for (; i + 32 <= a_size; i += 32)
+    {
+        l_max0 = _mm512_max_ps(_mm512_loadu_ps(a_in + i), l_max0);
+        l_max1 = _mm512_max_ps(_mm512_loadu_ps(a_in + i + 16), l_max1);
+    }
+    for (; i + 16 <= a_size; i += 16)
+    {
+        l_max0 = _mm512_max_ps(_mm512_loadu_ps(a_in + i), l_max0);
+    }
+    if (i < a_size)
+    {
+        // lanes past the end read as -inf
+        __m512 l_tail = _mm512_mask_loadu_ps(l_negInf, Avx512TailMask(a_size - i), a_in + i);
+        l_max1 = _mm512_max_ps(l_tail, l_max1);
+    }
+    return _mm512_reduce_max_ps(_mm512_max_ps(l_max0, l_max1));
+}
+
+NEURAL_TARGET_AVX512 float Avx512Sum(const float* a_in, size_t a_size)
+{
+    __m512 l_sum0 = _mm512_setzero_ps();
+    __m512 l_sum1 = l_sum0;
+    __m512 l_sum2 = l_sum0;
+    __m512 l_sum3 = l_sum0;
+    size_t i = 0;
+    for (; i + 64 <= a_size; i += 64)
+    {
+        l_sum0 = _mm512_add_ps(l_sum0, _mm512_loadu_ps(a_in + i));
+        l_sum1 = _mm512_add_ps(l_sum1, _mm512_loadu_ps(a_in + i + 16));
+        l_sum2 = _mm512_add_ps(l_sum2, _mm512_loadu_ps(a_in + i + 32));
+        l_sum3 = _mm512_add_ps(l_sum3, _mm512_loadu_ps(a_in + i + 48));
+    }
+    for (; i + 16 <= a_size; i += 16)
+    {
+        l_sum0 = _mm512_add_ps(l_sum0, _mm512_loadu_ps(a_in + i));
+    }
+    if (i < a_size)
+    {
+        l_sum1 = _mm512_add_ps(l_sum1, _mm512_maskz_loadu_ps(Avx512TailMask(a_size - i), a_in + i));
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(l_sum0, l_sum1), _mm512_add_ps(l_sum2, l_sum3)));
+}
+
+NEURAL_TARGET_AVX512 size_t Avx512IndexOf(const float* a_in, size_t a_size, float a_val)
+{
+    __m512 l_val = _mm512_set1_ps(a_val);
+    size_t i = 0;
+    for (; i + 16 <= a_size; i += 16)
+    {
+        __mmask16 l_bits = _mm512_cmp_ps_mask(_mm512_loadu_ps(a_in + i), l_val, _CMP_EQ_OQ);
+        if (l_bits)
+        {
+            return i + __builtin_ctz(l_bits);
+        }
+    }
+    if (i < a_size)
+    {
+        __mmask16 l_mask = Avx512TailMask(a_size - i);
+        __mmask16 l_bits = _mm512_mask_cmp_ps_mask(l_mask, _mm512_maskz_loadu_ps(l_mask, a_in + i), l_val, _CMP_EQ_OQ);
+        if (l_bits)
+        {
+            return i + __builtin_ctz(l_bits);
+        }
+    }
+    return a_size;
+}
+
+const Kernels g_avx2Kernels = {Avx2Max, Avx2Sum, Avx2IndexOf};
+const Kernels g_avx512Kernels = {Avx512Max, Avx512Sum, Avx512IndexOf};
+
+#endif // NEURAL_REDUCTION_X86
+
+const Kernels g_scalarKernels = {ScalarMax, ScalarSum, ScalarIndexOf};
+
+// Follows whatever Elementwise is using
+const Kernels& ActiveKernels()
+{
+    switch (Elementwise::ActiveIsa())
+    {
+#if defined(NEURAL_REDUCTION_X86)
+    case Elementwise::Isa::AVX2: return g_avx2Kernels;
+    case Elementwise::Isa::AVX512: return g_avx512Kernels;
+#endif
+    default: return g_scalarKernels;
+    }
+}
+
+size_t ArgMaxWith(const Kernels& a_kernels, const float* a_in, size_t a_size)
+{
+    size_t l_idx = a_kernels.m_indexOf(a_in, a_size, a_kernels.m_max(a_in, a_size));
+    return l_idx < a_size ? l_idx : 0;
+}
+
+float LogSumExpWith(const Kernels& a_kernels, const float* a_in, size_t a_size)
+{
+    // an infinite max has nothing finite to shift by, it is the answer
+    float l_max = a_kernels.m_max(a_in, a_size);
+    if (std::isinf(l_max))
+    {
+        return l_max;
+    }
+
+    float l_shifted[LOG_SUM_EXP_CHUNK];
+    float l_sum = 0.0;
+    for (size_t i = 0; i < a_size; i += LOG_SUM_EXP_CHUNK)
+    {
+        size_t l_length = std::min(LOG_SUM_EXP_CHUNK, a_size - i);
+        Elementwise::Apply(ElementwiseOp::SUB, a_in + i, l_max, l_shifted, l_length);
+        Elementwise::Exp(l_shifted, l_shifted, l_length);
+        l_sum += a_kernels.m_sum(l_shifted, l_length);
+    }
+    return l_max + std::log(l_sum);
+}
+
+float ReduceWith(const Kernels& a_kernels, ReduceOp a_op, const float* a_in, size_t a_size)
+{
+    switch (a_op)
+    {
+    case ReduceOp::MAX: return a_kernels.m_max(a_in, a_size);
+    case ReduceOp::SUM: return a_kernels.m_sum(a_in, a_size);
+    case ReduceOp::MEAN: return a_kernels.m_sum(a_in, a_size) / (float)a_size;
+    case ReduceOp::LOG_SUM_EXP: return LogSumExpWith(a_kernels, a_in, a_size);
+    }
+    return 0.0;
+}
+
+} // namespace
+
+float Reduction::Max(const float* a_in, size_t a_size)
+{
+    return ActiveKernels().m_max(a_in, a_size);
+}
+
+size_t Reduction::ArgMax(const float* a_in, size_t a_size)
+{
+    return ArgMaxWith(ActiveKernels(), a_in, a_size);
+}
+
+float Reduction::Sum(const float* a_in, size_t a_size)
+{
+    return ActiveKernels().m_sum(a_in, a_size);
+}
+
+float Reduction::Mean(const float* a_in, size_t a_size)
+{
+    return ReduceWith(ActiveKernels(), ReduceOp::MEAN, a_in, a_size);
+}
+
+float Reduction::LogSumExp(const float* a_in, size_t a_size)
+{
+    return LogSumExpWith(ActiveKernels(), a_in, a_size);
+}
+
+float Reduction::Reduce(ReduceOp a_op, const float* a_in, size_t a_size)
+{
+    return ReduceWith(ActiveKernels(), a_op, a_in, a_size);
+}
+
+void Reduction::Rows(ReduceOp a_op, const float* a_mat, size_t a_rows, size_t a_cols, float* a_out)
+{
+    const Kernels& l_kernels = ActiveKernels();
+    for (size_t i = 0; i < a_rows; ++i)
+    {
+        a_out[i] = ReduceWith(l_kernels, a_op, a_mat + (i * a_cols), a_cols);
+    }
+}
+
+void Reduction::RowArgMax(const float* a_mat, size_t a_rows, size_t a_cols, size_t* a_out)
+{
+    const Kernels& l_kernels = ActiveKernels();
+    for (size_t i = 0; i < a_rows; ++i)
+    {
+        a_out[i] = ArgMaxWith(l_kernels, a_mat + (i * a_cols), a_cols);
+    }
+}
+
+void Reduction::Cols(ReduceOp a_op, const float* a_mat, size_t a_rows, size_t a_cols, float* a_out)
+{
+    if (ReduceOp::MAX == a_op || ReduceOp::LOG_SUM_EXP == a_op)
+    {
+        // the row goes on the left so a NaN in it keeps the running max
+        std::fill(a_out, a_out + a_cols, NEG_INF);
+        for (size_t i = 0; i < a_rows; ++i)
+        {
+            Elementwise::Apply(ElementwiseOp::MAX, a_mat + (i * a_cols), a_out, a_out, a_cols);
+        }
+        if (ReduceOp::MAX == a_op)
+        {
+            return;
+        }
+
+        // a_out holds the max of each column, sum exp(x - max) beside it
+        vector<float> l_sums(a_cols, 0.0);
+        vector<float> l_shifted(a_cols);
+        for (size_t i = 0; i < a_rows; ++i)
+        {
+            Elementwise::Apply(ElementwiseOp::SUB, a_mat + (i * a_cols), a_out, l_shifted.data(), a_cols);
+            Elementwise::Exp(l_shifted.data(), l_shifted.data(), a_cols);
+            Elementwise::Apply(ElementwiseOp::ADD, l_sums.data(), l_shifted.data(), l_sums.data(), a_cols);
+        }
+        Elementwise::Log(l_sums.data(), l_sums.data(), a_cols);
+        for (size_t j = 0; j < a_cols; ++j)
+        {
+            // same as the rows, an infinite max is the answer
+            if (!std::isinf(a_out[j]))
+            {
+                a_out[j] += l_sums[j];
+            }
+        }
+        return;
+    }
+
+    std::fill(a_out, a_out + a_cols, 0.0f);
+    for (size_t i = 0; i < a_rows; ++i)
+    {
+        Elementwise::Apply(ElementwiseOp::ADD, a_out, a_mat + (i * a_cols), a_out, a_cols);
+    }
+    if (ReduceOp::MEAN == a_op)
+    {
+        Elementwise::Apply(ElementwiseOp::DIV, a_out, (float)a_rows, a_out, a_cols);
+    }
+}
+
+void Reduction::ColArgMax(const float* a_mat, size_t a_rows, size_t a_cols, size_t* a_out)
+{
+    vector<float> l_max(a_cols, NEG_INF);
+    std::fill(a_out, a_out + a_cols, 0);
+    for (size_t i = 0; i < a_rows; ++i)
+    {
+        const float* l_row = a_mat + (i * a_cols);
+        for (size_t j = 0; j < a_cols; ++j)
+        {
+            if (l_row[j] > l_max[j])
+            {
+                l_max[j] = l_row[j];
+                a_out[j] = i;
+            }
+        }
+    }
+}
+
+} // namespace neural
@@ -4,8 +4,11 @@
  */
 
 #include "neural/layers/relu_layer.h"
+#include "neural/math/tensor_math.h"
+#include "neural/math/tensor_t.h"
 
-#include <algorithm>
+#include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
@@ -19,39 +22,42 @@ ReLULayer::ReLULayer()
 
 TTensorPtr ReLULayer::Forward(const TTensorPtr& a_input) const
 {
-    // initialize our return matrix with the input
-    TMutableTensorPtr l_ret = a_input->ToMutable();
- 
-    // walk over rows
-    for (size_t i = 0; i < a_input->Shape().at(0); ++i)
-    {
-        // walk over cols
-        for (size_t j = 0; j < a_input->Shape().at(1); ++j)
-        {
-            // max(0,x)
-            l_ret->SetAt({i,j}, std::max(0.0f, l_ret->At({i,j})));
-        }
-    }
-    return l_ret;
+    // only supports matrices, throws otherwise
+    TMatrix l_input(a_input);
+    TMutableMatrix l_ret = TMutableMatrix::New(l_input.Shape());
+
+    // max(0,x)
+    TensorMath::Apply(ElementwiseOp::MAX, a_input, 0.0f, l_ret.Ptr());
+    return l_ret.Ptr();
 }
 
 TTensorPtr ReLULayer::Backward(const TTensorPtr& a_origInput, const TTensorPtr& a_gradInput)
 {
-    TMutableTensorPtr grad = a_gradInput->ToMutable();
+    if (!a_gradInput->HasSameShape(a_origInput))
+    {
+        stringstream l_ss;
+        l_ss << "ReLULayer::Backward gradient " << a_gradInput->ShapeStr()
+             << " does not match input " << a_origInput->ShapeStr();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    TMatrix l_input(a_origInput);
+    TMatrix l_gradIn(a_gradInput);
+    TMutableMatrix l_grad = TMutableMatrix::New(l_gradIn.Shape());
 
     // walk over rows
-    for (size_t i = 0; i < a_gradInput->Shape().at(0); ++i)
+    for (size_t i = 0; i < l_gradIn.Dim(0); ++i)
     {
-        // walk over cols
-        for (size_t j = 0; j < a_gradInput->Shape().at(1); ++j)
+        const float* l_in = l_input.Row(i);
+        const float* l_gradInRow = l_gradIn.Row(i);
+        float* l_gradRow = l_grad.Row(i);
+        // walk over cols, pass the gradient through where the input was >= 0
+        for (size_t j = 0; j < l_gradIn.Dim(1); ++j)
         {
-            if (a_origInput->At({i,j}) < 0)
-            {
-                grad->SetAt({i,j}, 0.0);
-            }
+            l_gradRow[j] = l_in[j] < 0 ? 0.0f : l_gradInRow[j];
         }
     }
-    return grad;
+    return l_grad.Ptr();
 }
 
 } // namespace neural
@@ -3,7 +3,9 @@
  */
 
 #include "neural/layers/softmax_layer.h"
+#include "neural/math/expression.h"
 #include "neural/math/tensor_math.h"
+#include "neural/math/tensor_t.h"
 
 #include <glog/logging.h>
 
@@ -41,46 +43,38 @@ TTensorPtr SoftmaxLayer::Forward(const TTensorPtr& a_inputs) const
     // because exp(x) can get very large, but by subtracting the max
     // we guaruntee max == 0
     // see http://cs231n.github.io/linear-classify/#softmax
-    TMutableTensorPtr l_inputs = a_inputs->ToMutable();
-    *l_inputs -= a_inputs->MaxVal();
+    // subtracting as we go saves making a shifted copy of the input,
+    // each row is shifted by its own max so no row underflows to all 0
+    TMatrix l_inputs(a_inputs);
 
-    size_t x = l_inputs->Shape().at(0);
-    size_t y = l_inputs->Shape().at(1);
-    TMutableTensorPtr l_outputs = Tensor::New({x, y});
+    size_t x = l_inputs.Dim(0);
+    size_t y = l_inputs.Dim(1);
+    TMutableMatrix l_outputs = TMutableMatrix::New({{x, y}});
 
-    vector<float> l_sums;
     for (size_t i = 0; i < x; ++i)
     {
-        float l_sum = 0.0;
-        for (size_t j = 0; j < y; ++j)
-        {
-            l_sum += exp(l_inputs->At({i, j}));
-        }
-        l_sums.push_back(l_sum);
-    }
+        const float* l_row = l_inputs.Row(i);
+        float* l_out = l_outputs.Row(i);
 
-    for (size_t i = 0; i < x; ++i)
-    {
-        for (size_t j = 0; j < y; ++j)
-        {
-            float l_val = exp(l_inputs->At({i, j})) / l_sums.at(i);
-            l_outputs->SetAt({i, j}, l_val);
-        }
+        // shift and exponentiate in one pass, then normalize in place
+        expr::Assign(l_out, y, expr::Exp(expr::Ref(l_row, y) - Reduction::Max(l_row, y)));
+        expr::Ref l_exps(l_out, y);
+        expr::Assign(l_out, y, l_exps / Reduction::Sum(l_out, y));
     }
 
-    return l_outputs;
+    return l_outputs.Ptr();
 }
 
 TTensorPtr SoftmaxLayer::Backward(
     const TTensorPtr& a_origInput, const TTensorPtr& a_gradOutput)
 {
     // TODO: cache, not computationally efficient
-    TTensorPtr l_outputs = Forward(a_origInput);
+    TMatrix l_outputs(Forward(a_origInput));
 
-    // size_t x = l_outputs->Shape().at(0);
-    size_t y = l_outputs->Shape().at(1);
+    // size_t x = l_outputs.Dim(0);
+    size_t y = l_outputs.Dim(1);
 
-    TMutableTensorPtr l_grad = Tensor::New({y, y});
+    TMutableMatrix l_grad = TMutableMatrix::New({{y, y}});
 
     // References:
     // https://deepnotes.io/softmax-crossentropy
@@ -93,23 +87,23 @@ TTensorPtr SoftmaxLayer::Backward(
             if (i == j)
             {
                 // jacobian_m[i][j] = s[i] * (1-s[i])
-                float oi = l_outputs->At({0, i});
+                float oi = l_outputs(0, i);
                 float l_val = oi * (1-oi);
-                l_grad->SetAt({i,j}, l_val);
+                l_grad(i, j) = l_val;
             }
             else
             {
                 // jacobian_m[i][j] = -s[i]*s[j]
-                float oi = l_outputs->At({0, i});
-                float oj = l_outputs->At({0, j});
+                float oi = l_outputs(0, i);
+                float oj = l_outputs(0, j);
                 float l_val = -oi * oj;
-                l_grad->SetAt({i,j}, l_val);
+                l_grad(i, j) = l_val;
             }
         }
     }
 
     // Chain rule
-    return TensorMath::Multiply(a_gradOutput, l_grad);
+    return TensorMath::Multiply(a_gradOutput, l_grad.Ptr());
 }
 
 } // namespace neural
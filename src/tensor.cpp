@@ -3,46 +3,73 @@
  */
 
 #include "neural/math/tensor.h"
+#include "neural/math/tensor_view.h"
+#include "neural/math/elementwise.h"
+#include "neural/math/reduction.h"
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <sstream>
 #include <chrono>
 #include <random>
+#include <math.h>
 
 using namespace std;
 
 namespace neural
 {
 
-Tensor::Tensor(const std::vector<size_t>& a_shape)
+Tensor::Tensor(const TensorShape& a_shape)
     : m_shape(a_shape)
     , m_strideSizes(p_ComputeStrideSizes(m_shape))
 {
     m_data.resize(p_CalcSize(a_shape));
 }
 
-Tensor::Tensor(const std::vector<size_t>& a_shape,
+Tensor::Tensor(const TensorShape& a_shape,
                const std::vector<float>& a_data)
     : m_shape(a_shape)
-    , m_data(a_data)
+    , m_data(a_data.begin(), a_data.end())
     , m_strideSizes(p_ComputeStrideSizes(m_shape))
 {
     m_data.resize(p_CalcSize(a_shape));
 }
 
-TMutableTensorPtr Tensor::New(const std::vector<size_t>& a_shape)
+Tensor::Tensor()
+{
+}
+
+TMutableTensorPtr Tensor::New(const TensorShape& a_shape)
 {
     return TMutableTensorPtr(new Tensor(a_shape));
 }
 
 TMutableTensorPtr Tensor::New(
-    const std::vector<size_t>& a_shape, const std::vector<float>& a_data)
+    const TensorShape& a_shape, const std::vector<float>& a_data)
 {
     return TMutableTensorPtr(new Tensor(a_shape, a_data));
 }
 
-TMutableTensorPtr Tensor::Random(const std::vector<size_t>& a_shape, 
+TMutableTensorPtr Tensor::Adopt(
+    const TensorShape& a_shape, TTensorData&& a_data)
+{
+    if (a_data.size() != a_shape.NumElements())
+    {
+        stringstream l_ss;
+        l_ss << "Tensor::Adopt " << a_data.size() << " elements cannot fill shape "
+             << ShapeStr(a_shape);
+        throw(runtime_error(l_ss.str()));
+    }
+
+    TMutableTensorPtr l_tensor(new Tensor());
+    l_tensor->m_shape = a_shape;
+    l_tensor->m_data = std::move(a_data);
+    l_tensor->m_strideSizes = l_tensor->p_ComputeStrideSizes(a_shape);
+    return l_tensor;
+}
+
+TMutableTensorPtr Tensor::Random(const TensorShape& a_shape, 
                           float a_min, float a_max)
 {
     // construct a trivial random generator engine from a time-based seed:
@@ -51,35 +78,31 @@ TMutableTensorPtr Tensor::Random(const std::vector<size_t>& a_shape,
 
     static std::normal_distribution<float> l_distribution(a_min, a_max);
 
-    size_t l_size(1);
-    for (size_t i = 0; i < a_shape.size(); ++i)
-    {
-        l_size *= a_shape[i];
-    }
-    vector<float> l_data;
-    for (size_t i = 0; i < l_size; ++i)
+    TMutableTensorPtr l_tensor = New(a_shape);
+    TTensorData& l_data = l_tensor->MutableData();
+    for (size_t i = 0; i < l_data.size(); ++i)
     {
-        l_data.push_back(l_distribution(l_generator));
+        l_data[i] = l_distribution(l_generator);
     }
 
-    return New(a_shape, l_data);
+    return l_tensor;
 }
 
-TMutableTensorPtr Tensor::Constant(const std::vector<size_t>& a_shape, float a_val)
+TMutableTensorPtr Tensor::Constant(const TensorShape& a_shape, float a_val)
 {
     TMutableTensorPtr l_tensor = New(a_shape);
     l_tensor->SetAll(a_val);
     return l_tensor;
 }
 
-TMutableTensorPtr Tensor::Zeros(const std::vector<size_t>& a_shape)
+TMutableTensorPtr Tensor::Zeros(const TensorShape& a_shape)
 {
     TMutableTensorPtr l_tensor = New(a_shape);
     l_tensor->SetAll(0.0);
     return l_tensor;
 }
 
-TMutableTensorPtr Tensor::Ones(const std::vector<size_t>& a_shape)
+TMutableTensorPtr Tensor::Ones(const TensorShape& a_shape)
 {
     TMutableTensorPtr l_tensor = New(a_shape);
     l_tensor->SetAll(1.0);
@@ -88,7 +111,77 @@ TMutableTensorPtr Tensor::Ones(const std::vector<size_t>& a_shape)
 
 TMutableTensorPtr Tensor::ToMutable() const
 {
-    return TMutableTensorPtr(new Tensor(m_shape, m_data));
+    return TMutableTensorPtr(new Tensor(*this));
+}
+
+TMutableTensorPtr Tensor::ToMutable(TTensorPtr&& a_tensor)
+{
+    // every Tensor is created non-const, so with nobody else looking
+    // at it we can hand the same object back as mutable
+    if (1 == a_tensor.use_count())
+    {
+        TMutableTensorPtr l_tensor = std::const_pointer_cast<Tensor>(a_tensor);
+        a_tensor.reset();
+        return l_tensor;
+    }
+
+    TMutableTensorPtr l_copy = a_tensor->ToMutable();
+    a_tensor.reset();
+    return l_copy;
+}
+
+Tensor& Tensor::Scale(float a_val)
+{
+    Elementwise::Scale(m_data.data(), a_val, m_data.data(), m_data.size());
+    return *this;
+}
+
+Tensor& Tensor::Add(float a_val)
+{
+    Elementwise::Apply(ElementwiseOp::ADD, m_data.data(), a_val, m_data.data(), m_data.size());
+    return *this;
+}
+
+Tensor& Tensor::Add(const TensorView& a_other, float a_alpha)
+{
+    if (a_other.Shape() != m_shape)
+    {
+        stringstream l_ss;
+        l_ss << "Tensor::Add shapes must match " << ShapeStr()
+             << " != " << a_other.ShapeStr();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    // views that are not contiguous, ie. transposes, get copied out first
+    TTensorPtr l_copy;
+    const float* l_other = a_other.Data();
+    if (!a_other.IsContiguous())
+    {
+        l_copy = a_other.ToTensor();
+        l_other = l_copy->Data().data();
+    }
+
+    Elementwise::Axpy(a_alpha, l_other, m_data.data(), m_data.size());
+    return *this;
+}
+
+Tensor& Tensor::Clamp(float a_min, float a_max)
+{
+    Elementwise::Apply(ElementwiseOp::MAX, m_data.data(), a_min, m_data.data(), m_data.size());
+    Elementwise::Apply(ElementwiseOp::MIN, m_data.data(), a_max, m_data.data(), m_data.size());
+    return *this;
+}
+
+Tensor& Tensor::Exp()
+{
+    Elementwise::Exp(m_data.data(), m_data.data(), m_data.size());
+    return *this;
+}
+
+Tensor& Tensor::operator/=(const float& a_val)
+{
+    Elementwise::Apply(ElementwiseOp::DIV, m_data.data(), a_val, m_data.data(), m_data.size());
+    return *this;
 }
 
 void Tensor::SetAll(float a_val)
@@ -99,12 +192,12 @@ void Tensor::SetAll(float a_val)
     }
 }
 
-const std::vector<size_t>& Tensor::Shape() const
+const TensorShape& Tensor::Shape() const
 {
     return m_shape;
 }
 
-std::string Tensor::ShapeStr(const std::vector<size_t>& a_shape)
+std::string Tensor::ShapeStr(const TensorShape& a_shape)
 {
     string l_ret("");
     for (size_t i = 0; i < a_shape.size(); ++i)
@@ -125,29 +218,34 @@ size_t Tensor::Size() const
     return m_data.size();
 }
   
-const std::vector<float>& Tensor::Data() const
+const TTensorData& Tensor::Data() const
 {
     return m_data;
 }
 
-std::vector<float>& Tensor::MutableData()
+const TensorShape& Tensor::Strides() const
+{
+    return m_strideSizes;
+}
+
+TTensorData& Tensor::MutableData()
 {
     return m_data;
 }
 
-float Tensor::At(const std::vector<size_t>& a_idx) const
+float Tensor::At(const TensorShape& a_idx) const
 {
     size_t l_offset = p_DataOffsetFromIdx(a_idx);
     return m_data[l_offset];
 }
 
-void Tensor::SetAt(const std::vector<size_t>& a_idx, float a_val)
+void Tensor::SetAt(const TensorShape& a_idx, float a_val)
 {
     size_t l_offset = p_DataOffsetFromIdx(a_idx);
     m_data[l_offset] = a_val;
 }
 
-size_t Tensor::p_CalcSize(const std::vector<size_t>& a_shape) const
+size_t Tensor::p_CalcSize(const TensorShape& a_shape) const
 {
     size_t l_size(1);
     for (size_t i = 0; i < a_shape.size(); ++i)
@@ -158,7 +256,7 @@ size_t Tensor::p_CalcSize(const std::vector<size_t>& a_shape) const
 }
 
 size_t Tensor::p_DataOffsetFromIdx(
-    const std::vector<size_t>& a_tensorIdx) const
+    const TensorShape& a_tensorIdx) const
 {
     if (m_shape.size() != a_tensorIdx.size())
     {
@@ -196,8 +294,8 @@ size_t Tensor::p_DataOffsetFromIdx(
     return l_offset;
 }
 
-vector<size_t> Tensor::p_ComputeStrideSizes(
-    const std::vector<size_t>& a_tensorShape) const
+TensorShape Tensor::p_ComputeStrideSizes(
+    const TensorShape& a_tensorShape) const
 {
     // we have to calculate the stride sizes for each part of the shape
     // for example if we have a shape of {4,2,2,3}
@@ -209,7 +307,7 @@ vector<size_t> Tensor::p_ComputeStrideSizes(
     // we get to the first offset ie 2 * (2 * 2 * 3),
     // then do the same for the next offset so 
     // (2 * (2 * 2 * 3)) + (1 * (2 * 3))
-    vector<size_t> l_strideSizes;
+    TensorShape l_strideSizes;
     for (size_t i = 0; i < a_tensorShape.size(); ++i)
     {
         size_t l_strideSize = 1;
@@ -229,64 +327,63 @@ float Tensor::MaxVal() const
 
 size_t Tensor::MaxIdx() const
 {
-    float l_max = 0.0;
-    size_t l_maxIdx = 0;
-
-    for (size_t i = 0; i < m_data.size(); ++i)
+    if (m_data.empty())
     {
-        if (m_data[i] > l_max)
-        {
-            l_max = m_data[i];
-            l_maxIdx = i;
-        }
+        throw(runtime_error("Tensor::MaxIdx of empty tensor"));
     }
-
-    return l_maxIdx;
+    return Reduction::ArgMax(m_data.data(), m_data.size());
 }
 
 bool Tensor::HasSameShape(const TTensorPtr& a_other) const
 {
-    const vector<size_t>& l_otherShape = a_other->Shape();
-    if (m_shape.size() != l_otherShape.size())
-    {
-        return false;
-    }
+    return m_shape == a_other->Shape();
+}
 
-    for (size_t i = 0; i < l_otherShape.size(); ++i)
+void Tensor::p_CheckIdx2(size_t a_row, size_t a_col) const
+{
+    if (m_shape.size() != 2 || a_row >= m_shape[0] || a_col >= m_shape[1])
     {
-        if (m_shape.at(i) != l_otherShape.at(i))
-        {
-            return false;
-        }
+        stringstream ss;
+        ss << "Tensor::At2 invalid idx: (" << a_row << ", " << a_col << ")"
+           << " for tensor " << ShapeStr(m_shape);
+        throw(runtime_error(ss.str()));
     }
-
-    return true;
 }
 
-void Tensor::SetRow(size_t a_row, const TTensorPtr& a_tensor)
+void Tensor::SetRow(size_t a_row, const TensorView& a_tensor)
 {
     if (m_shape.size() != 2)
     {
         throw("Tensor::SetRow cannot call set row on non-matrix tensor");
     }
 
-    if (a_tensor->Shape().at(0) != 1 ||
-        a_tensor->Shape().at(1) != m_shape.at(1))
+    if (a_tensor.Shape().size() != 2 ||
+        a_tensor.Shape().at(0) != 1 ||
+        a_tensor.Shape().at(1) != m_shape.at(1) ||
+        a_row >= m_shape.at(0))
     {
         stringstream l_ss;
-        l_ss << "Tensor::SetRow tensor not correct shape " << a_tensor->ShapeStr()
-             << " on tensor " << ShapeStr() << endl;
+        l_ss << "Tensor::SetRow tensor not correct shape " << a_tensor.ShapeStr()
+             << " for row " << a_row << " on tensor " << ShapeStr() << endl;
         LOG(ERROR) << l_ss.str() << endl;
         throw(l_ss.str());
     }
 
-    size_t l_offset = a_row * m_shape.at(1);
-    size_t l_end = l_offset+a_tensor->Shape().at(1);
+    float* l_out = m_data.data() + (a_row * m_shape.at(1));
+    const float* l_in = a_tensor.Data();
+    size_t l_cols = m_shape.at(1);
+    size_t l_stride = a_tensor.Strides().at(1);
 
-    for (size_t i = l_offset; i < l_end; ++i)
+    if (1 == l_stride)
+    {
+        std::copy(l_in, l_in + l_cols, l_out);
+        return;
+    }
+
+    // row of a transposed view, step over the parent's columns
+    for (size_t i = 0; i < l_cols; ++i)
     {
-        size_t l_idx = i-l_offset;
-        m_data.at(i) = a_tensor->Data().at(l_idx);
+        l_out[i] = l_in[i * l_stride];
     }
 }
 
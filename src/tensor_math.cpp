@@ -5,9 +5,11 @@
  */
 
 #include "neural/math/tensor_math.h"
+#include "neural/math/transposition.h"
 
 #include <glog/logging.h>
 #include <cblas.h>  
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
@@ -15,33 +17,50 @@ using namespace std;
 namespace neural
 {
 
-TTensorPtr TensorMath::Multiply(const TTensorPtr& a_lhs, const TTensorPtr& a_rhs)
+TTensorPtr TensorMath::Multiply(const TensorView& a_lhs, const TensorView& a_rhs)
 {
-    if (a_lhs->Shape().size() != 2 || a_rhs->Shape().size() != 2)
+    if (a_lhs.Shape().size() != 2 || a_rhs.Shape().size() != 2)
     {
         stringstream l_ss;
         l_ss << "TensorMath::Multiply for tensors of shape.size() != 2 is not supported. "
-             << "a_lhs.size = " << a_lhs->Shape().size()
-             << "a_rhs.size = " << a_rhs->Shape().size()
+             << "a_lhs.size = " << a_lhs.Shape().size()
+             << "a_rhs.size = " << a_rhs.Shape().size()
              << endl;
         LOG(ERROR) << l_ss.str() << endl;
         throw(runtime_error(l_ss.str()));
     }
 
     // Check to make sure the inner dimensions of our matrices line up
-    if (a_lhs->Shape().at(1) != a_rhs->Shape().at(0))
+    if (a_lhs.Shape().at(1) != a_rhs.Shape().at(0))
     {
         stringstream l_ss;
         l_ss << "TensorMath::Multiply Inner dimensions of matrices must match "
-             << a_lhs->ShapeStr() << " * " << a_rhs->ShapeStr();
+             << a_lhs.ShapeStr() << " * " << a_rhs.ShapeStr();
 
         LOG(ERROR) << l_ss.str() << endl;
         throw(runtime_error(l_ss.str()));
     }
 
+    // Views BLAS cannot walk directly get copied out, this only
+    // happens for views without a unit stride in either dimension
+    TensorView l_lhs = a_lhs;
+    TensorView l_rhs = a_rhs;
+    bool l_transA, l_transB;
+    int l_lda, l_ldb;
+    if (!p_BlasLayout(l_lhs, l_transA, l_lda))
+    {
+        l_lhs = TensorView(TTensorPtr(a_lhs.ToTensor()));
+        p_BlasLayout(l_lhs, l_transA, l_lda);
+    }
+    if (!p_BlasLayout(l_rhs, l_transB, l_ldb))
+    {
+        l_rhs = TensorView(TTensorPtr(a_rhs.ToTensor()));
+        p_BlasLayout(l_rhs, l_transB, l_ldb);
+    }
+
     // initialize our return matrix with the correct shape,
     // ie the outer sizes of our inputs and rhs
-    TMutableTensorPtr l_ret = Tensor::Zeros({a_lhs->Shape().at(0), a_rhs->Shape().at(1)})->ToMutable();
+    TMutableTensorPtr l_ret = Tensor::Zeros({a_lhs.Shape().at(0), a_rhs.Shape().at(1)});
 
     /*
     M
@@ -53,47 +72,89 @@ TTensorPtr TensorMath::Multiply(const TTensorPtr& a_lhs, const TTensorPtr& a_rhs
     K
     Number of columns in matrix A; number of rows in matrix B.
     */
-    int m = a_lhs->Shape().at(0);
-    int n = a_rhs->Shape().at(1);
-    int k = a_lhs->Shape().at(1);
+    int m = a_lhs.Shape().at(0);
+    int n = a_rhs.Shape().at(1);
+    int k = a_lhs.Shape().at(1);
 
-    const float* A = a_lhs->Data().data();
-    const float* B = a_rhs->Data().data();
+    const float* A = l_lhs.Data();
+    const float* B = l_rhs.Data();
     float* C = l_ret->MutableData().data();
 
     // BLAS mat mul
-    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, m, n, k, 1.0,
-                A, k, B, n, 0.0, C, n);
+    cblas_sgemm(CblasRowMajor,
+                l_transA ? CblasTrans : CblasNoTrans,
+                l_transB ? CblasTrans : CblasNoTrans,
+                m, n, k, 1.0,
+                A, l_lda, B, l_ldb, 0.0, C, n);
 
     return l_ret;
 }
 
+bool TensorMath::p_BlasLayout(const TensorView& a_view, bool& a_outTranspose, int& a_outLeadingDim)
+{
+    size_t l_rows = a_view.Shape().at(0);
+    size_t l_cols = a_view.Shape().at(1);
+    size_t l_rowStride = a_view.Strides().at(0);
+    size_t l_colStride = a_view.Strides().at(1);
+
+    // Row major, possibly narrowed: rows are l_rowStride apart.
+    // A dimension of size 1 is never stepped over so its stride is free.
+    if (1 == l_colStride || 1 == l_cols)
+    {
+        a_outTranspose = false;
+        a_outLeadingDim = (int)std::max<size_t>(1 == l_rows ? l_cols : l_rowStride, 1);
+        return true;
+    }
+
+    // Transpose of a row major matrix: columns are l_colStride apart
+    if (1 == l_rowStride || 1 == l_rows)
+    {
+        a_outTranspose = true;
+        a_outLeadingDim = (int)std::max<size_t>(l_colStride, 1);
+        return true;
+    }
+
+    return false;
+}
+
 TTensorPtr TensorMath::Transpose(const TTensorPtr& a_mat)
 {
     if (a_mat->Shape().size() != 2)
     {
-        throw(runtime_error("TensorMath::Transpose for tensors of shape > 2 is not supported yet."));
+        throw(runtime_error("TensorMath::Transpose for tensors of shape > 2 is not supported, see TensorMath::Permute."));
     }
 
     size_t x = a_mat->Shape().at(0);
     size_t y = a_mat->Shape().at(1);
     
     TMutableTensorPtr l_ret = Tensor::New({y, x});
+    Transposition::Matrix(a_mat->Data().data(), x, y, l_ret->MutableData().data());
+    return l_ret;
+}
 
-    #pragma omp parallel for
-    for(size_t n = 0; n < x*y; ++n)
+void TensorMath::TransposeInPlace(const TMutableTensorPtr& a_mat)
+{
+    const TensorShape& l_shape = a_mat->Shape();
+    if (l_shape.size() != 2 || l_shape.at(0) != l_shape.at(1))
     {
-        size_t i = n/x;
-        size_t j = n%x;
-        l_ret->MutableData()[n] = a_mat->Data()[y*j + i];
+        stringstream l_ss;
+        l_ss << "TensorMath::TransposeInPlace needs a square matrix, got " << a_mat->ShapeStr();
+        LOG(ERROR) << l_ss.str() << endl;
+        throw(runtime_error(l_ss.str()));
     }
 
-    return l_ret;
+    Transposition::InPlace(a_mat->MutableData().data(), l_shape.at(0), l_shape.at(1));
+}
+
+TTensorPtr TensorMath::Permute(const TTensorPtr& a_tensor, const std::vector<size_t>& a_axes)
+{
+    // the permuted view is just new strides, copying it out does the work
+    return TensorView(a_tensor).Permute(a_axes).ToTensor();
 }
 
 TTensorPtr TensorMath::AddCol(const TTensorPtr& a_tensor, float a_val)
 {
-    vector<size_t> l_shape = a_tensor->Shape();
+    TensorShape l_shape = a_tensor->Shape();
     if (l_shape.size() != 2)
     {
         string l_error("TensorMath::AddCol cannot call add rol on non-matrix tensor");
@@ -102,35 +163,25 @@ TTensorPtr TensorMath::AddCol(const TTensorPtr& a_tensor, float a_val)
     }
 
     // Add the column to shape
-    l_shape.at(1) += 1; 
+    size_t l_cols = l_shape.at(1);
+    l_shape.at(1) += 1;
 
-    // Copy out the old data
-    vector<float> l_data = a_tensor->Data();
-
-    // Iterate over rows
+    // Copy each row straight into the new tensor, then the new column
+    TMutableTensorPtr l_ret = Tensor::New(l_shape);
+    const float* l_in = a_tensor->Data().data();
+    float* l_out = l_ret->MutableData().data();
     for (size_t i = 0; i < l_shape.at(0); ++i)
     {
-        // Get offset into data vector
-        size_t l_offset = (i * l_shape.at(1)) + (l_shape.at(1) - 1);
-
-        // If we are at the end of the data
-        if (l_offset >= l_data.size())
-        {
-            l_data.push_back(a_val);
-        }
-        else
-        {
-            l_data.insert(l_data.begin() + l_offset, a_val);
-        }
+        std::copy(l_in + (i * l_cols), l_in + ((i + 1) * l_cols), l_out + (i * (l_cols + 1)));
+        l_out[(i * (l_cols + 1)) + l_cols] = a_val;
     }
 
-    // Return a new tensor with the new shape & data
-    return Tensor::New(l_shape, l_data);
+    return l_ret;
 }
 
 TTensorPtr TensorMath::RemoveCol(const TTensorPtr& a_tensor)
 {
-    vector<size_t> l_shape = a_tensor->Shape();
+    TensorShape l_shape = a_tensor->Shape();
     if (l_shape.size() != 2)
     {
         string l_error("TensorMath::RemoveCol cannot call add rol on non-matrix tensor");
@@ -138,29 +189,25 @@ TTensorPtr TensorMath::RemoveCol(const TTensorPtr& a_tensor)
         throw(l_error);
     }
 
-    // Copy out the old data
-    vector<float> l_data = a_tensor->Data();
+    // Remove the column from the shape
+    size_t l_cols = l_shape.at(1);
+    l_shape.at(1) -= 1;
 
-    // Iterate over rows, but start at the back to preserve indices
-    // If we delete from the front, all the indices will be shifted
-    // And it will not work
-    for (int i = l_shape.at(0)-1; i >= 0; --i)
+    // Copy each row but its last column into the new tensor
+    TMutableTensorPtr l_ret = Tensor::New(l_shape);
+    const float* l_in = a_tensor->Data().data();
+    float* l_out = l_ret->MutableData().data();
+    for (size_t i = 0; i < l_shape.at(0); ++i)
     {
-        // Get offset into data vector
-        int l_offset = (i * l_shape.at(1)) + (l_shape.at(1) - 1);
-        l_data.erase(l_data.begin()+l_offset);
+        std::copy(l_in + (i * l_cols), l_in + (i * l_cols) + (l_cols - 1), l_out + (i * (l_cols - 1)));
     }
 
-    // Remove the column from the shape
-    l_shape.at(1) -= 1;
-
-    // Return a new tensor with the new shape & data
-    return Tensor::New(l_shape, l_data);
+    return l_ret;
 }
 
 TTensorPtr TensorMath::AddRow(const TTensorPtr& a_tensor, float a_val)
 {
-    vector<size_t> l_shape = a_tensor->Shape();
+    TensorShape l_shape = a_tensor->Shape();
     if (l_shape.size() != 2)
     {
         string l_error("TensorMath::RemoveCol cannot call add rol on non-matrix tensor");
@@ -168,19 +215,20 @@ TTensorPtr TensorMath::AddRow(const TTensorPtr& a_tensor, float a_val)
         throw(l_error);
     }
 
-    // Copy out the old data
-    vector<float> l_data = a_tensor->Data();
-    for (size_t i = 0; i < l_shape.at(1); ++i)
-    {
-        l_data.push_back(a_val);
-    }
+    // Copy the old data, then fill the new last row
+    size_t l_size = a_tensor->Size();
     l_shape.at(0) += 1;
-    return Tensor::New(l_shape, l_data);
+    TMutableTensorPtr l_ret = Tensor::New(l_shape);
+    const float* l_in = a_tensor->Data().data();
+    float* l_out = l_ret->MutableData().data();
+    std::copy(l_in, l_in + l_size, l_out);
+    std::fill(l_out + l_size, l_out + l_ret->Size(), a_val);
+    return l_ret;
 }
 
 TTensorPtr TensorMath::RemoveRow(const TTensorPtr& a_tensor)
 {
-    vector<size_t> l_shape = a_tensor->Shape();
+    TensorShape l_shape = a_tensor->Shape();
     if (l_shape.size() != 2)
     {
         string l_error("TensorMath::RemoveCol cannot call add rol on non-matrix tensor");
@@ -188,15 +236,161 @@ TTensorPtr TensorMath::RemoveRow(const TTensorPtr& a_tensor)
         throw(l_error);
     }
 
-    // Copy out the old data
-    vector<float> l_data = a_tensor->Data();
-    for (size_t i = 0; i < l_shape.at(1); ++i)
+    // Copy all but the last row
+    l_shape.at(0) -= 1;
+    TMutableTensorPtr l_ret = Tensor::New(l_shape);
+    const float* l_in = a_tensor->Data().data();
+    std::copy(l_in, l_in + l_ret->Size(), l_ret->MutableData().data());
+    return l_ret;
+}
+
+void TensorMath::Apply(
+    ElementwiseOp a_op, const TTensorPtr& a_lhs, const TTensorPtr& a_rhs,
+    const TMutableTensorPtr& a_out)
+{
+    p_CheckOutput("TensorMath::Apply", a_lhs, a_out);
+
+    const float* l_lhs = a_lhs->Data().data();
+    const float* l_rhs = a_rhs->Data().data();
+    float* l_out = a_out->MutableData().data();
+
+    if (a_lhs->HasSameShape(a_rhs))
+    {
+        Elementwise::Apply(a_op, l_lhs, l_rhs, l_out, a_lhs->Size());
+        return;
+    }
+
+    if (1 == a_rhs->Size())
     {
-        // remove from the back
-        l_data.pop_back();
+        Elementwise::Apply(a_op, l_lhs, l_rhs[0], l_out, a_lhs->Size());
+        return;
+    }
+
+    // broadcasting only goes across matrices
+    const TensorShape& l_shape = a_lhs->Shape();
+    const TensorShape& l_rhsShape = a_rhs->Shape();
+    if (2 == l_shape.size() && 2 == l_rhsShape.size())
+    {
+        if (1 == l_rhsShape[0] && l_shape[1] == l_rhsShape[1])
+        {
+            Elementwise::ApplyRow(a_op, l_lhs, l_rhs, l_out, l_shape[0], l_shape[1]);
+            return;
+        }
+        if (l_shape[0] == l_rhsShape[0] && 1 == l_rhsShape[1])
+        {
+            Elementwise::ApplyCol(a_op, l_lhs, l_rhs, l_out, l_shape[0], l_shape[1]);
+            return;
+        }
+    }
+
+    stringstream l_ss;
+    l_ss << "TensorMath::Apply cannot broadcast " << a_rhs->ShapeStr()
+         << " over " << a_lhs->ShapeStr();
+    LOG(ERROR) << l_ss.str() << endl;
+    throw(runtime_error(l_ss.str()));
+}
+
+void TensorMath::Apply(
+    ElementwiseOp a_op, const TTensorPtr& a_lhs, float a_rhs,
+    const TMutableTensorPtr& a_out)
+{
+    p_CheckOutput("TensorMath::Apply", a_lhs, a_out);
+    Elementwise::Apply(a_op, a_lhs->Data().data(), a_rhs, a_out->MutableData().data(), a_lhs->Size());
+}
+
+void TensorMath::Scale(const TTensorPtr& a_in, float a_val, const TMutableTensorPtr& a_out)
+{
+    p_CheckOutput("TensorMath::Scale", a_in, a_out);
+    Elementwise::Scale(a_in->Data().data(), a_val, a_out->MutableData().data(), a_in->Size());
+}
+
+void TensorMath::Axpy(float a_alpha, const TTensorPtr& a_x, const TMutableTensorPtr& a_y)
+{
+    p_CheckOutput("TensorMath::Axpy", a_x, a_y);
+    Elementwise::Axpy(a_alpha, a_x->Data().data(), a_y->MutableData().data(), a_x->Size());
+}
+
+void TensorMath::Exp(const TTensorPtr& a_in, const TMutableTensorPtr& a_out)
+{
+    p_CheckOutput("TensorMath::Exp", a_in, a_out);
+    Elementwise::Exp(a_in->Data().data(), a_out->MutableData().data(), a_in->Size());
+}
+
+void TensorMath::Log(const TTensorPtr& a_in, const TMutableTensorPtr& a_out)
+{
+    p_CheckOutput("TensorMath::Log", a_in, a_out);
+    Elementwise::Log(a_in->Data().data(), a_out->MutableData().data(), a_in->Size());
+}
+
+void TensorMath::Reduce(ReduceOp a_op, size_t a_axis, const TTensorPtr& a_mat, const TMutableTensorPtr& a_out)
+{
+    p_CheckAxis("TensorMath::Reduce", a_axis, a_mat);
+
+    size_t l_rows = a_mat->Shape()[0];
+    size_t l_cols = a_mat->Shape()[1];
+    TensorShape l_outShape = (1 == a_axis) ? TensorShape({l_rows, 1}) : TensorShape({1, l_cols});
+    if (a_out->Shape() != l_outShape)
+    {
+        stringstream l_ss;
+        l_ss << "TensorMath::Reduce along axis " << a_axis << " of " << a_mat->ShapeStr()
+             << " needs output " << Tensor::ShapeStr(l_outShape) << " got " << a_out->ShapeStr();
+        LOG(ERROR) << l_ss.str() << endl;
+        throw(runtime_error(l_ss.str()));
+    }
+
+    const float* l_in = a_mat->Data().data();
+    float* l_out = a_out->MutableData().data();
+    if (1 == a_axis)
+    {
+        Reduction::Rows(a_op, l_in, l_rows, l_cols, l_out);
+    }
+    else
+    {
+        Reduction::Cols(a_op, l_in, l_rows, l_cols, l_out);
+    }
+}
+
+void TensorMath::ArgMax(size_t a_axis, const TTensorPtr& a_mat, std::vector<size_t>& a_out)
+{
+    p_CheckAxis("TensorMath::ArgMax", a_axis, a_mat);
+
+    size_t l_rows = a_mat->Shape()[0];
+    size_t l_cols = a_mat->Shape()[1];
+    const float* l_in = a_mat->Data().data();
+    if (1 == a_axis)
+    {
+        a_out.resize(l_rows);
+        Reduction::RowArgMax(l_in, l_rows, l_cols, a_out.data());
+    }
+    else
+    {
+        a_out.resize(l_cols);
+        Reduction::ColArgMax(l_in, l_rows, l_cols, a_out.data());
+    }
+}
+
+void TensorMath::p_CheckOutput(const char* a_name, const TTensorPtr& a_in, const TTensorPtr& a_out)
+{
+    if (!a_in->HasSameShape(a_out))
+    {
+        stringstream l_ss;
+        l_ss << a_name << " output " << a_out->ShapeStr()
+             << " does not match input " << a_in->ShapeStr();
+        LOG(ERROR) << l_ss.str() << endl;
+        throw(runtime_error(l_ss.str()));
+    }
+}
+
+void TensorMath::p_CheckAxis(const char* a_name, size_t a_axis, const TTensorPtr& a_mat)
+{
+    if (a_mat->Shape().size() != 2 || a_axis > 1)
+    {
+        stringstream l_ss;
+        l_ss << a_name << " needs a matrix and axis 0 or 1, got "
+             << a_mat->ShapeStr() << " and axis " << a_axis;
+        LOG(ERROR) << l_ss.str() << endl;
+        throw(runtime_error(l_ss.str()));
     }
-    l_shape.at(0) -= 1;
-    return Tensor::New(l_shape, l_data);
 }
 
 } // namespace neural
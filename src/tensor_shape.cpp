@@ -0,0 +1,118 @@
+/*
+ * TensorShape implementation
+ */
+
+#include "neural/math/tensor_shape.h"
+
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace neural
+{
+
+const size_t TensorShape::MAX_RANK;
+
+TensorShape::TensorShape()
+    : m_rank(0)
+{
+}
+
+TensorShape::TensorShape(std::initializer_list<size_t> a_dims)
+    : m_rank(0)
+{
+    p_Assign(a_dims.begin(), a_dims.end());
+}
+
+TensorShape::TensorShape(const std::vector<size_t>& a_dims)
+    : m_rank(0)
+{
+    p_Assign(a_dims.data(), a_dims.data() + a_dims.size());
+}
+
+TensorShape::TensorShape(const size_t* a_begin, const size_t* a_end)
+    : m_rank(0)
+{
+    p_Assign(a_begin, a_end);
+}
+
+size_t TensorShape::at(size_t a_dim) const
+{
+    if (a_dim >= m_rank)
+    {
+        stringstream l_ss;
+        l_ss << "TensorShape::at " << a_dim << " >= rank " << m_rank;
+        throw(out_of_range(l_ss.str()));
+    }
+    return m_dims[a_dim];
+}
+
+size_t& TensorShape::at(size_t a_dim)
+{
+    if (a_dim >= m_rank)
+    {
+        stringstream l_ss;
+        l_ss << "TensorShape::at " << a_dim << " >= rank " << m_rank;
+        throw(out_of_range(l_ss.str()));
+    }
+    return m_dims[a_dim];
+}
+
+void TensorShape::push_back(size_t a_dim)
+{
+    if (m_rank >= MAX_RANK)
+    {
+        stringstream l_ss;
+        l_ss << "TensorShape::push_back rank > " << MAX_RANK << " is not supported";
+        throw(runtime_error(l_ss.str()));
+    }
+    m_dims[m_rank++] = a_dim;
+}
+
+size_t TensorShape::NumElements() const
+{
+    size_t l_size(1);
+    for (size_t i = 0; i < m_rank; ++i)
+    {
+        l_size *= m_dims[i];
+    }
+    return l_size;
+}
+
+TensorShape::operator std::vector<size_t>() const
+{
+    return vector<size_t>(begin(), end());
+}
+
+bool TensorShape::operator==(const TensorShape& a_other) const
+{
+    if (m_rank != a_other.m_rank)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < m_rank; ++i)
+    {
+        if (m_dims[i] != a_other.m_dims[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TensorShape::operator!=(const TensorShape& a_other) const
+{
+    return !(*this == a_other);
+}
+
+void TensorShape::p_Assign(const size_t* a_begin, const size_t* a_end)
+{
+    for (const size_t* l_dim = a_begin; l_dim != a_end; ++l_dim)
+    {
+        push_back(*l_dim);
+    }
+}
+
+} // namespace neural
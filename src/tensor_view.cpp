@@ -0,0 +1,283 @@
+/*
+ * TensorView implementation
+ */
+
+#include "neural/math/tensor_view.h"
+#include "neural/math/reduction.h"
+#include "neural/math/transposition.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace neural
+{
+
+TensorView::TensorView(const TTensorPtr& a_tensor)
+    : m_owner(a_tensor)
+    , m_base(a_tensor->Data().data())
+    , m_shape(a_tensor->Shape())
+    , m_strides(a_tensor->Strides())
+    , m_offset(0)
+{
+}
+
+TensorView::TensorView(const TMutableTensorPtr& a_tensor)
+    : TensorView(TTensorPtr(a_tensor))
+{
+}
+
+TensorView::TensorView(const Tensor& a_tensor)
+    : m_base(a_tensor.Data().data())
+    , m_shape(a_tensor.Shape())
+    , m_strides(a_tensor.Strides())
+    , m_offset(0)
+{
+}
+
+TensorView::TensorView(
+    const TTensorPtr& a_owner,
+    const float* a_base,
+    const TensorShape& a_shape,
+    const TensorShape& a_strides,
+    size_t a_offset)
+    : m_owner(a_owner)
+    , m_base(a_base)
+    , m_shape(a_shape)
+    , m_strides(a_strides)
+    , m_offset(a_offset)
+{
+}
+
+const TensorShape& TensorView::Shape() const
+{
+    return m_shape;
+}
+
+std::string TensorView::ShapeStr() const
+{
+    return Tensor::ShapeStr(m_shape);
+}
+
+const TensorShape& TensorView::Strides() const
+{
+    return m_strides;
+}
+
+size_t TensorView::Offset() const
+{
+    return m_offset;
+}
+
+size_t TensorView::Size() const
+{
+    return m_shape.NumElements();
+}
+
+const float* TensorView::Data() const
+{
+    return m_base + m_offset;
+}
+
+bool TensorView::IsContiguous() const
+{
+    // walk from the innermost dimension out, each stride has to be the
+    // product of the sizes inside it. Dimensions of size 1 are never
+    // stepped over so their stride does not matter.
+    size_t l_expected = 1;
+    for (size_t i = m_shape.size(); i > 0; --i)
+    {
+        if (m_shape[i - 1] != 1 && m_strides[i - 1] != l_expected)
+        {
+            return false;
+        }
+        l_expected *= m_shape[i - 1];
+    }
+    return true;
+}
+
+float TensorView::At(const TensorShape& a_idx) const
+{
+    if (m_shape.size() != a_idx.size())
+    {
+        stringstream l_ss;
+        l_ss << "TensorView::At invalid shape size: " << Tensor::ShapeStr(a_idx)
+             << " for view " << ShapeStr();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    size_t l_offset = 0;
+    for (size_t i = 0; i < m_shape.size(); ++i)
+    {
+        if (a_idx[i] >= m_shape[i])
+        {
+            stringstream l_ss;
+            l_ss << "TensorView::At invalid shape idx: " << Tensor::ShapeStr(a_idx)
+                 << " for view " << ShapeStr()
+                 << ", @" << i << ": " << a_idx[i] << " >= " << m_shape[i];
+            throw(runtime_error(l_ss.str()));
+        }
+        l_offset += a_idx[i] * m_strides[i];
+    }
+    return Data()[l_offset];
+}
+
+TensorView TensorView::Row(size_t a_row) const
+{
+    if (m_shape.size() != 2)
+    {
+        stringstream l_ss;
+        l_ss << "TensorView::Row cannot take a row of non-matrix view " << ShapeStr();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    return Narrow(0, a_row, 1);
+}
+
+TensorView TensorView::Slice(size_t a_idx) const
+{
+    if (m_shape.empty() || a_idx >= m_shape[0])
+    {
+        stringstream l_ss;
+        l_ss << "TensorView::Slice " << a_idx << " out of range for view " << ShapeStr();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    TensorShape l_shape(m_shape.begin() + 1, m_shape.end());
+    TensorShape l_strides(m_strides.begin() + 1, m_strides.end());
+    return TensorView(m_owner, m_base, l_shape, l_strides, m_offset + (a_idx * m_strides[0]));
+}
+
+TensorView TensorView::Narrow(size_t a_dim, size_t a_start, size_t a_length) const
+{
+    if (a_dim >= m_shape.size() || a_start + a_length > m_shape[a_dim])
+    {
+        stringstream l_ss;
+        l_ss << "TensorView::Narrow [" << a_start << ", " << a_start + a_length
+             << ") along dim " << a_dim << " out of range for view " << ShapeStr();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    TensorShape l_shape = m_shape;
+    l_shape[a_dim] = a_length;
+    return TensorView(m_owner, m_base, l_shape, m_strides, m_offset + (a_start * m_strides[a_dim]));
+}
+
+TensorView TensorView::Transpose() const
+{
+    if (m_shape.size() != 2)
+    {
+        stringstream l_ss;
+        l_ss << "TensorView::Transpose cannot transpose non-matrix view " << ShapeStr();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    return TensorView(
+        m_owner, m_base,
+        {m_shape[1], m_shape[0]},
+        {m_strides[1], m_strides[0]},
+        m_offset);
+}
+
+TensorView TensorView::Permute(const vector<size_t>& a_axes) const
+{
+    // every dimension exactly once
+    vector<bool> l_seen(m_shape.size(), false);
+    bool l_valid = (a_axes.size() == m_shape.size());
+    for (size_t i = 0; l_valid && i < a_axes.size(); ++i)
+    {
+        l_valid = a_axes[i] < m_shape.size() && !l_seen[a_axes[i]];
+        if (l_valid)
+        {
+            l_seen[a_axes[i]] = true;
+        }
+    }
+
+    if (!l_valid)
+    {
+        stringstream l_ss;
+        l_ss << "TensorView::Permute axes " << Tensor::ShapeStr(a_axes)
+             << " are not a permutation of the dimensions of view " << ShapeStr();
+        throw(runtime_error(l_ss.str()));
+    }
+
+    TensorShape l_shape;
+    TensorShape l_strides;
+    for (size_t l_axis : a_axes)
+    {
+        l_shape.push_back(m_shape[l_axis]);
+        l_strides.push_back(m_strides[l_axis]);
+    }
+    return TensorView(m_owner, m_base, l_shape, l_strides, m_offset);
+}
+
+TMutableTensorPtr TensorView::ToTensor() const
+{
+    TMutableTensorPtr l_ret = Tensor::New(m_shape);
+    float* l_out = l_ret->MutableData().data();
+    const float* l_in = Data();
+    size_t l_size = Size();
+
+    if (IsContiguous())
+    {
+        std::copy(l_in, l_in + l_size, l_out);
+        return l_ret;
+    }
+
+    // transposes and permutations go through the tiled kernels
+    Transposition::Gather(l_in, m_shape, m_strides, l_out);
+    return l_ret;
+}
+
+float TensorView::MaxVal() const
+{
+    return Data()[p_OffsetOfElement(MaxIdx())];
+}
+
+size_t TensorView::MaxIdx() const
+{
+    size_t l_size = Size();
+    if (0 == l_size)
+    {
+        throw(runtime_error("TensorView::MaxIdx of empty view"));
+    }
+
+    const float* l_data = Data();
+    if (IsContiguous())
+    {
+        return Reduction::ArgMax(l_data, l_size);
+    }
+
+    // same rules as Reduction::ArgMax, NaN never compares greater
+    size_t l_maxIdx = 0;
+    float l_max = -numeric_limits<float>::infinity();
+    for (size_t i = 0; i < l_size; ++i)
+    {
+        float l_val = l_data[p_OffsetOfElement(i)];
+        if (l_val > l_max)
+        {
+            l_max = l_val;
+            l_maxIdx = i;
+        }
+    }
+    return l_maxIdx;
+}
+
+size_t TensorView::p_OffsetOfElement(size_t a_element) const
+{
+    // peel off the index of each dimension, innermost first
+    size_t l_offset = 0;
+    for (size_t i = m_shape.size(); i > 0; --i)
+    {
+        l_offset += (a_element % m_shape[i - 1]) * m_strides[i - 1];
+        a_element /= m_shape[i - 1];
+    }
+    return l_offset;
+}
+
+} // namespace neural
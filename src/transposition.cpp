@@ -0,0 +1,371 @@
+/*
+ * Transposition implementation
+ *
+ * Transposing a tile and swapping a tile with its mirror are written
+ * once per instruction set, around 8x8 register transposes for AVX2.
+ * Splitting into tiles, threading and the ragged edges are shared.
+ * AVX-512 machines run the AVX2 kernels, once a tile is in cache a
+ * 16x16 register transpose buys little over two 8x8 ones.
+ */
+
+#include "neural/math/transposition.h"
+#include "neural/math/elementwise.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NEURAL_TRANSPOSITION_X86 1
+// see elementwise.cpp, gcc 12 warns from inside the AVX-512 intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#define NEURAL_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+using namespace std;
+
+namespace neural
+{
+
+namespace
+{
+
+// out = in transposed for one tile of at most TILE x TILE
+typedef void (*TTileFn)(const float*, size_t, size_t, size_t, float*, size_t);
+// Swaps the blocks of rows [begin, end) and columns [begin, end) with
+// their mirrors across the diagonal, all bounds a multiple of BLOCK.
+// Blocks left of the diagonal are skipped, they are the mirrors.
+typedef void (*TSwapTileFn)(float*, size_t, size_t, size_t, size_t, size_t);
+
+struct Kernels
+{
+    TTileFn m_tile;
+    TSwapTileFn m_swapTile;
+};
+
+const size_t BLOCK = 8;
+
+// Tiles of 64x64 floats, 16KB read and 16KB written, fit L1 together
+const size_t TILE = 64;
+
+// Below this many floats a transpose is over before threads start
+const size_t PARALLEL_MIN = 64 * 1024;
+
+// Element by element, for the edges that do not fill a block
+void ScalarRange(
+    const float* a_in, size_t a_rowBegin, size_t a_rowEnd, size_t a_colBegin, size_t a_colEnd,
+    size_t a_inStride, float* a_out, size_t a_outStride)
+{
+    for (size_t i = a_rowBegin; i < a_rowEnd; ++i)
+    {
+        for (size_t j = a_colBegin; j < a_colEnd; ++j)
+        {
+            a_out[(j * a_outStride) + i] = a_in[(i * a_inStride) + j];
+        }
+    }
+}
+
+/*
+ * Scalar
+ */
+
+void ScalarTile(
+    const float* a_in, size_t a_rows, size_t a_cols, size_t a_inStride,
+    float* a_out, size_t a_outStride)
+{
+    ScalarRange(a_in, 0, a_rows, 0, a_cols, a_inStride, a_out, a_outStride);
+}
+
+void ScalarSwapTile(
+    float* a_mat, size_t a_stride, size_t a_rowBegin, size_t a_rowEnd,
+    size_t a_colBegin, size_t a_colEnd)
+{
+    for (size_t i = a_rowBegin; i < a_rowEnd; ++i)
+    {
+        for (size_t j = std::max(a_colBegin, i + 1); j < a_colEnd; ++j)
+        {
+            std::swap(a_mat[(i * a_stride) + j], a_mat[(j * a_stride) + i]);
+        }
+    }
+}
+
+/*
+ * AVX2
+ */
+
+#if defined(NEURAL_TRANSPOSITION_X86)
+
+// Eight rows in, eight columns out. Every index is a constant so the
+// rows live in registers once this is inlined.
+NEURAL_TARGET_AVX2 inline void Avx2Transpose8x8(__m256 (&a_rows)[BLOCK])
+{
+    __m256 t0 = _mm256_unpacklo_ps(a_rows[0], a_rows[1]);
+    __m256 t1 = _mm256_unpackhi_ps(a_rows[0], a_rows[1]);
+    __m256 t2 = _mm256_unpacklo_ps(a_rows[2], a_rows[3]);
+    __m256 t3 = _mm256_unpackhi_ps(a_rows[2], a_rows[3]);
+    __m256 t4 = _mm256_unpacklo_ps(a_rows[4], a_rows[5]);
+    __m256 t5 = _mm256_unpackhi_ps(a_rows[4], a_rows[5]);
+    __m256 t6 = _mm256_unpacklo_ps(a_rows[6], a_rows[7]);
+    __m256 t7 = _mm256_unpackhi_ps(a_rows[6], a_rows[7]);
+
+    __m256 s0 = _mm256_shuffle_ps(t0, t2, 0x44);
+    __m256 s1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+    __m256 s2 = _mm256_shuffle_ps(t1, t3, 0x44);
+    __m256 s3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+    __m256 s4 = _mm256_shuffle_ps(t4, t6, 0x44);
+    __m256 s5 = _mm256_shuffle_ps(t4, t6, 0xEE);
+    __m256 s6 = _mm256_shuffle_ps(t5, t7, 0x44);
+    __m256 s7 = _mm256_shuffle_ps(t5, t7, 0xEE);
+
+    // low halves hold columns 0-3, high halves columns 4-7
+    a_rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+    a_rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+    a_rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+    a_rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+    a_rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+    a_rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+    a_rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+    a_rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+NEURAL_TARGET_AVX2 inline void Avx2Load8x8(const float* a_in, size_t a_stride, __m256 (&a_rows)[BLOCK])
+{
+    a_rows[0] = _mm256_loadu_ps(a_in);
+    a_rows[1] = _mm256_loadu_ps(a_in + a_stride);
+    a_rows[2] = _mm256_loadu_ps(a_in + (2 * a_stride));
+    a_rows[3] = _mm256_loadu_ps(a_in + (3 * a_stride));
+    a_rows[4] = _mm256_loadu_ps(a_in + (4 * a_stride));
+    a_rows[5] = _mm256_loadu_ps(a_in + (5 * a_stride));
+    a_rows[6] = _mm256_loadu_ps(a_in + (6 * a_stride));
+    a_rows[7] = _mm256_loadu_ps(a_in + (7 * a_stride));
+}
+
+NEURAL_TARGET_AVX2 inline void Avx2Store8x8(const __m256 (&a_rows)[BLOCK], float* a_out, size_t a_stride)
+{
+    _mm256_storeu_ps(a_out, a_rows[0]);
+    _mm256_storeu_ps(a_out + a_stride, a_rows[1]);
+    _mm256_storeu_ps(a_out + (2 * a_stride), a_rows[2]);
+    _mm256_storeu_ps(a_out + (3 * a_stride), a_rows[3]);
+    _mm256_storeu_ps(a_out + (4 * a_stride), a_rows[4]);
+    _mm256_storeu_ps(a_out + (5 * a_stride), a_rows[5]);
+    _mm256_storeu_ps(a_out + (6 * a_stride), a_rows[6]);
+    _mm256_storeu_ps(a_out + (7 * a_stride), a_rows[7]);
+}
+
+// Whole blocks, then the right and bottom edges element by element
+NEURAL_TARGET_AVX2 void Avx2Tile(
+    const float* a_in, size_t a_rows, size_t a_cols, size_t a_inStride,
+    float* a_out, size_t a_outStride)
+{
+    size_t l_rows = a_rows - (a_rows % BLOCK);
+    size_t l_cols = a_cols - (a_cols % BLOCK);
+    __m256 l_block[BLOCK];
+    for (size_t i = 0; i < l_rows; i += BLOCK)
+    {
+        for (size_t j = 0; j < l_cols; j += BLOCK)
+        {
+            Avx2Load8x8(a_in + (i * a_inStride) + j, a_inStride, l_block);
+            Avx2Transpose8x8(l_block);
+            Avx2Store8x8(l_block, a_out + (j * a_outStride) + i, a_outStride);
+        }
+    }
+    ScalarRange(a_in, 0, a_rows, l_cols, a_cols, a_inStride, a_out, a_outStride);
+    ScalarRange(a_in, l_rows, a_rows, 0, l_cols, a_inStride, a_out, a_outStride);
+}
+
+// Both blocks are loaded before either is stored, so on the diagonal
+// a block swapping with itself transposes in place
+NEURAL_TARGET_AVX2 void Avx2SwapTile(
+    float* a_mat, size_t a_stride, size_t a_rowBegin, size_t a_rowEnd,
+    size_t a_colBegin, size_t a_colEnd)
+{
+    __m256 l_upper[BLOCK];
+    __m256 l_lower[BLOCK];
+    for (size_t i = a_rowBegin; i < a_rowEnd; i += BLOCK)
+    {
+        for (size_t j = std::max(a_colBegin, i); j < a_colEnd; j += BLOCK)
+        {
+            float* l_upperPtr = a_mat + (i * a_stride) + j;
+            float* l_lowerPtr = a_mat + (j * a_stride) + i;
+            Avx2Load8x8(l_upperPtr, a_stride, l_upper);
+            Avx2Load8x8(l_lowerPtr, a_stride, l_lower);
+            Avx2Transpose8x8(l_upper);
+            Avx2Transpose8x8(l_lower);
+            Avx2Store8x8(l_upper, l_lowerPtr, a_stride);
+            Avx2Store8x8(l_lower, l_upperPtr, a_stride);
+        }
+    }
+}
+
+const Kernels g_avx2Kernels = {Avx2Tile, Avx2SwapTile};
+
+#endif
+
+const Kernels g_scalarKernels = {ScalarTile, ScalarSwapTile};
+
+const Kernels& ActiveKernels()
+{
+    switch (Elementwise::ActiveIsa())
+    {
+#if defined(NEURAL_TRANSPOSITION_X86)
+    case Elementwise::Isa::AVX2: return g_avx2Kernels;
+    case Elementwise::Isa::AVX512: return g_avx2Kernels;
+#endif
+    default: return g_scalarKernels;
+    }
+}
+
+} // namespace
+
+void Transposition::Matrix(
+    const float* a_in, size_t a_rows, size_t a_cols, size_t a_inStride,
+    float* a_out, size_t a_outStride)
+{
+    const Kernels& l_kernels = ActiveKernels();
+    size_t l_rowTiles = (a_rows + TILE - 1) / TILE;
+    size_t l_colTiles = (a_cols + TILE - 1) / TILE;
+    size_t l_numTiles = l_rowTiles * l_colTiles;
+
+    // every tile writes its own part of a_out, so they can go to any thread
+    #pragma omp parallel for schedule(static) if (a_rows * a_cols >= PARALLEL_MIN)
+    for (size_t l_tile = 0; l_tile < l_numTiles; ++l_tile)
+    {
+        size_t i = (l_tile / l_colTiles) * TILE;
+        size_t j = (l_tile % l_colTiles) * TILE;
+        l_kernels.m_tile(
+            a_in + (i * a_inStride) + j,
+            std::min(TILE, a_rows - i), std::min(TILE, a_cols - j), a_inStride,
+            a_out + (j * a_outStride) + i, a_outStride);
+    }
+}
+
+void Transposition::Matrix(const float* a_in, size_t a_rows, size_t a_cols, float* a_out)
+{
+    Matrix(a_in, a_rows, a_cols, a_cols, a_out, a_rows);
+}
+
+void Transposition::InPlace(float* a_mat, size_t a_size, size_t a_stride)
+{
+    const Kernels& l_kernels = ActiveKernels();
+    size_t l_blocked = a_size - (a_size % BLOCK);
+    size_t l_tiles = (l_blocked + TILE - 1) / TILE;
+    bool l_parallel = a_size * a_size >= PARALLEL_MIN;
+
+    // tile row l_ti swaps with tile column l_ti, on and above the
+    // diagonal only, so no two threads ever touch the same block.
+    // Rows near the top have more tiles to their right, hence dynamic.
+    #pragma omp parallel for schedule(dynamic) if (l_parallel)
+    for (size_t l_ti = 0; l_ti < l_tiles; ++l_ti)
+    {
+        size_t l_rowEnd = std::min(l_blocked, (l_ti + 1) * TILE);
+        for (size_t l_tj = l_ti; l_tj < l_tiles; ++l_tj)
+        {
+            size_t l_colEnd = std::min(l_blocked, (l_tj + 1) * TILE);
+            l_kernels.m_swapTile(a_mat, a_stride, l_ti * TILE, l_rowEnd, l_tj * TILE, l_colEnd);
+        }
+    }
+
+    // the columns past the last whole block, and their mirror rows
+    #pragma omp parallel for if (l_parallel)
+    for (size_t i = 0; i < a_size; ++i)
+    {
+        for (size_t j = std::max(i + 1, l_blocked); j < a_size; ++j)
+        {
+            std::swap(a_mat[(i * a_stride) + j], a_mat[(j * a_stride) + i]);
+        }
+    }
+}
+
+void Transposition::Gather(
+    const float* a_in, const TensorShape& a_shape, const TensorShape& a_strides,
+    float* a_out)
+{
+    // Drop dimensions of size 1 and merge neighbours that are already
+    // laid out one after the other, ie. a 4x3x28x28 batch permuted to
+    // 4x28x28x3 is a 4 long batch of 3x784 to 784x3 transposes.
+    TensorShape l_shape;
+    TensorShape l_strides;
+    for (size_t i = 0; i < a_shape.size(); ++i)
+    {
+        if (0 == a_shape[i])
+        {
+            return;
+        }
+        if (1 == a_shape[i])
+        {
+            continue;
+        }
+
+        size_t l_last = l_shape.size() - 1;
+        if (!l_shape.empty() && l_strides[l_last] == a_strides[i] * a_shape[i])
+        {
+            l_shape[l_last] *= a_shape[i];
+            l_strides[l_last] = a_strides[i];
+        }
+        else
+        {
+            l_shape.push_back(a_shape[i]);
+            l_strides.push_back(a_strides[i]);
+        }
+    }
+
+    size_t l_rank = l_shape.size();
+    if (0 == l_rank)
+    {
+        a_out[0] = a_in[0];
+        return;
+    }
+
+    // The innermost one or two dimensions are handled in one go, as a
+    // run to copy, a matrix to transpose or failing both a strided run.
+    // Everything outside them is a batch of those.
+    size_t l_last = l_rank - 1;
+    bool l_copy = (1 == l_strides[l_last]);
+    bool l_matrix = !l_copy && l_rank >= 2 && (1 == l_strides[l_last - 1]);
+    size_t l_batchDims = l_matrix ? l_rank - 2 : l_rank - 1;
+
+    size_t l_innerSize = 1;
+    for (size_t i = l_batchDims; i < l_rank; ++i)
+    {
+        l_innerSize *= l_shape[i];
+    }
+    size_t l_numBatches = l_shape.NumElements() / l_innerSize;
+
+    // with only a few batches the matrix transpose spreads itself out
+    #pragma omp parallel for if (l_numBatches >= 16 && l_shape.NumElements() >= PARALLEL_MIN)
+    for (size_t l_batch = 0; l_batch < l_numBatches; ++l_batch)
+    {
+        // peel off the index of each batch dimension, innermost first
+        size_t l_offset = 0;
+        size_t l_rest = l_batch;
+        for (size_t i = l_batchDims; i > 0; --i)
+        {
+            l_offset += (l_rest % l_shape[i - 1]) * l_strides[i - 1];
+            l_rest /= l_shape[i - 1];
+        }
+
+        const float* l_in = a_in + l_offset;
+        float* l_out = a_out + (l_batch * l_innerSize);
+        if (l_copy)
+        {
+            std::copy(l_in, l_in + l_innerSize, l_out);
+        }
+        else if (l_matrix)
+        {
+            // the last dimension strides over rows of the input, the one
+            // before it walks along them
+            Matrix(l_in, l_shape[l_last], l_shape[l_last - 1], l_strides[l_last], l_out, l_shape[l_last]);
+        }
+        else
+        {
+            for (size_t j = 0; j < l_innerSize; ++j)
+            {
+                l_out[j] = l_in[j * l_strides[l_last]];
+            }
+        }
+    }
+}
+
+} // namespace neural
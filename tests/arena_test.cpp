@@ -0,0 +1,103 @@
+/*
+ * Arena test
+ *
+ */
+
+#include "neural/util/arena.h"
+#include "neural/math/tensor_math.h"
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+
+using namespace neural;
+using namespace std;
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(ArenaTest, TestBumpAllocation)
+{
+    Arena l_arena(1024);
+
+    float* l_first = static_cast<float*>(l_arena.Allocate(10 * sizeof(float)));
+    float* l_second = static_cast<float*>(l_arena.Allocate(10 * sizeof(float)));
+
+    // rounded up to keep the next one aligned
+    EXPECT_EQ(reinterpret_cast<char*>(l_first) + 64, reinterpret_cast<char*>(l_second));
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(l_second) % MemoryResource::ALIGNMENT);
+    EXPECT_EQ(128, l_arena.NumBytesUsed());
+
+    // freeing is a no-op, rewinding hands the same memory out again
+    Arena::Mark l_mark = l_arena.GetMark();
+    void* l_third = l_arena.Allocate(100);
+    l_arena.Deallocate(l_third, 100);
+    l_arena.Rewind(l_mark);
+    EXPECT_EQ(l_third, l_arena.Allocate(100));
+
+    l_arena.Reset();
+    EXPECT_EQ(0, l_arena.NumBytesUsed());
+    EXPECT_EQ(l_first, l_arena.Allocate(4));
+}
+
+TEST(ArenaTest, TestResetMergesChunks)
+{
+    Arena l_arena(1024);
+
+    // one that fits, one bigger than a chunk, one more that fits
+    l_arena.Allocate(1000);
+    l_arena.Allocate(4000);
+    l_arena.Allocate(1000);
+    EXPECT_EQ(3, l_arena.NumChunks());
+
+    size_t l_reserved = l_arena.NumBytesReserved();
+    l_arena.Reset();
+    EXPECT_EQ(1, l_arena.NumChunks());
+    EXPECT_EQ(l_reserved, l_arena.NumBytesReserved());
+
+    // the same round now fits in the merged chunk
+    l_arena.Allocate(1000);
+    l_arena.Allocate(4000);
+    l_arena.Allocate(1000);
+    EXPECT_EQ(1, l_arena.NumChunks());
+}
+
+TEST(ArenaTest, TestScopeRoutesTensors)
+{
+    Arena* l_arena = Arena::ThreadArena();
+    TTensorPtr l_weights = Tensor::Random({30, 20});
+    EXPECT_EQ(MemoryPool::Instance(), l_weights->Data().get_allocator().Resource());
+
+    {
+        ArenaScope l_scope;
+        EXPECT_EQ(l_arena, MemoryResource::Default());
+
+        TTensorPtr l_input = Tensor::Ones({8, 30});
+        TTensorPtr l_output = TensorMath::Multiply(l_input, l_weights);
+        EXPECT_EQ(l_arena, l_input->Data().get_allocator().Resource());
+        EXPECT_EQ(l_arena, l_output->Data().get_allocator().Resource());
+        EXPECT_LT(0, l_arena->NumBytesUsed());
+
+        // nested scopes rewind to where they started
+        size_t l_used = l_arena->NumBytesUsed();
+        {
+            ArenaScope l_inner;
+            TTensorPtr l_copy = l_output->ToMutable();
+            EXPECT_LT(l_used, l_arena->NumBytesUsed());
+        }
+        EXPECT_EQ(l_used, l_arena->NumBytesUsed());
+    }
+
+    EXPECT_EQ(0, l_arena->NumBytesUsed());
+    EXPECT_EQ(MemoryPool::Instance(), MemoryResource::Default());
+
+    // copies made outside the scope are regular pooled tensors
+    TMutableTensorPtr l_kept;
+    {
+        ArenaScope l_scope;
+        TTensorPtr l_temp = Tensor::Ones({2, 2});
+        MemoryResource* l_previous = MemoryResource::SetThreadDefault(nullptr);
+        l_kept = l_temp->ToMutable();
+        MemoryResource::SetThreadDefault(l_previous);
+    }
+    EXPECT_EQ(MemoryPool::Instance(), l_kept->Data().get_allocator().Resource());
+    EXPECT_EQ(1.0, l_kept->At({1, 1}));
+}
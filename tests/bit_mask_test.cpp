@@ -0,0 +1,55 @@
+/*
+ * Bit Mask Test
+ *
+ */
+
+#include "neural/util/bit_mask.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace neural;
+using namespace std;
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(BitMaskTest, TestGreaterMatchesScalar)
+{
+    mt19937 l_random(17);
+    uniform_int_distribution<int> l_value(0, 9);
+
+    // sizes on and off the 8 wide and 64 wide boundaries
+    for (size_t l_size : {0, 1, 7, 8, 9, 63, 64, 65, 200})
+    {
+        vector<float> l_values(l_size);
+        for (float& l_item : l_values)
+        {
+            l_item = l_value(l_random) / 10.0f;
+        }
+        if (l_size > 3)
+        {
+            l_values[3] = numeric_limits<float>::quiet_NaN();
+        }
+
+        vector<uint64_t> l_bits(BitMask::NumWords(l_size), ~0ULL);
+        BitMask::Greater(l_values.data(), l_size, 0.5f, l_bits.data());
+
+        size_t l_expectedCount = 0;
+        for (size_t i = 0; i < l_size; ++i)
+        {
+            bool l_isGreater = l_values[i] > 0.5f;
+            l_expectedCount += l_isGreater ? 1 : 0;
+            EXPECT_EQ(l_isGreater, ((l_bits[i / 64] >> (i % 64)) & 1) == 1);
+        }
+        // high bits of the last word are cleared
+        if (l_size % 64 != 0)
+        {
+            EXPECT_EQ(0, l_bits.back() >> (l_size % 64));
+        }
+        EXPECT_EQ(l_expectedCount, BitMask::PopCount(l_bits.data(), l_bits.size()));
+        EXPECT_EQ(l_expectedCount, BitMask::CountGreater(l_values.data(), l_size, 0.5f));
+    }
+}
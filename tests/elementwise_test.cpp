@@ -0,0 +1,219 @@
+/*
+ * Elementwise Test
+ *
+ */
+
+#include "neural/math/elementwise.h"
+#include "neural/math/tensor_math.h"
+#include "isa_test_util.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+vector<float> RandomValues(size_t a_size, float a_min, float a_max, unsigned a_seed)
+{
+    mt19937 l_random(a_seed);
+    uniform_real_distribution<float> l_value(a_min, a_max);
+    vector<float> l_values(a_size);
+    for (float& l_item : l_values)
+    {
+        l_item = l_value(l_random);
+    }
+    return l_values;
+}
+
+float Expected(ElementwiseOp a_op, float a_lhs, float a_rhs)
+{
+    switch (a_op)
+    {
+    case ElementwiseOp::ADD: return a_lhs + a_rhs;
+    case ElementwiseOp::SUB: return a_lhs - a_rhs;
+    case ElementwiseOp::MUL: return a_lhs * a_rhs;
+    case ElementwiseOp::DIV: return a_lhs / a_rhs;
+    case ElementwiseOp::MAX: return a_lhs > a_rhs ? a_lhs : a_rhs;
+    case ElementwiseOp::MIN: return a_lhs < a_rhs ? a_lhs : a_rhs;
+    }
+    return 0.0;
+}
+
+// Bitwise, so NaN matches NaN
+bool SameBits(float a_lhs, float a_rhs)
+{
+    if (std::isnan(a_lhs) && std::isnan(a_rhs))
+    {
+        return true;
+    }
+    return 0 == memcmp(&a_lhs, &a_rhs, sizeof(float));
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(ElementwiseTest, TestOpsMatchScalarOnEveryIsa)
+{
+    const ElementwiseOp l_ops[] = {
+        ElementwiseOp::ADD, ElementwiseOp::SUB, ElementwiseOp::MUL,
+        ElementwiseOp::DIV, ElementwiseOp::MAX, ElementwiseOp::MIN};
+
+    for (Elementwise::Isa l_isa : SupportedIsas())
+    {
+        ScopedIsa l_scopedIsa(l_isa);
+        EXPECT_EQ(l_isa, Elementwise::ActiveIsa());
+
+        // sizes on and off the 8 and 16 wide boundaries
+        for (size_t l_size : {0, 1, 7, 8, 9, 15, 16, 17, 100})
+        {
+            vector<float> l_lhs = RandomValues(l_size, -10.0, 10.0, 3);
+            vector<float> l_rhs = RandomValues(l_size, -10.0, 10.0, 4);
+            if (l_size > 5)
+            {
+                // NaN on either side comes out as the right hand side for max and min
+                l_lhs[2] = numeric_limits<float>::quiet_NaN();
+                l_rhs[5] = numeric_limits<float>::quiet_NaN();
+            }
+
+            for (ElementwiseOp l_op : l_ops)
+            {
+                vector<float> l_out(l_size);
+                Elementwise::Apply(l_op, l_lhs.data(), l_rhs.data(), l_out.data(), l_size);
+                for (size_t i = 0; i < l_size; ++i)
+                {
+                    EXPECT_TRUE(SameBits(Expected(l_op, l_lhs[i], l_rhs[i]), l_out[i]))
+                        << Elementwise::IsaName(l_isa) << " size " << l_size << " @" << i;
+                }
+
+                // scalar right hand side, written over the input
+                vector<float> l_inPlace = l_lhs;
+                Elementwise::Apply(l_op, l_inPlace.data(), 2.5f, l_inPlace.data(), l_size);
+                for (size_t i = 0; i < l_size; ++i)
+                {
+                    EXPECT_TRUE(SameBits(Expected(l_op, l_lhs[i], 2.5f), l_inPlace[i]))
+                        << Elementwise::IsaName(l_isa) << " size " << l_size << " @" << i;
+                }
+            }
+
+            // the vector paths fuse the multiply-add, so allow an ulp
+            vector<float> l_y = l_rhs;
+            Elementwise::Axpy(-0.1f, l_lhs.data(), l_y.data(), l_size);
+            for (size_t i = 0; i < l_size; ++i)
+            {
+                if (!std::isnan(l_lhs[i]) && !std::isnan(l_rhs[i]))
+                {
+                    float l_expected = l_rhs[i] + (-0.1f * l_lhs[i]);
+                    EXPECT_NEAR(l_expected, l_y[i], std::fabs(l_expected) * 2e-7 + 1e-6)
+                        << Elementwise::IsaName(l_isa) << " size " << l_size << " @" << i;
+                }
+            }
+        }
+    }
+}
+
+TEST(ElementwiseTest, TestExpLogAccuracy)
+{
+    vector<float> l_expIn = RandomValues(1001, -87.0, 88.0, 5);
+    vector<float> l_logIn = RandomValues(1001, 0.0, 1000.0, 6);
+    // small and large magnitudes for log
+    l_logIn[0] = 1.0;
+    l_logIn[1] = 1e-30f;
+    l_logIn[2] = 3e38f;
+
+    for (Elementwise::Isa l_isa : SupportedIsas())
+    {
+        ScopedIsa l_scopedIsa(l_isa);
+
+        vector<float> l_out(l_expIn.size());
+        Elementwise::Exp(l_expIn.data(), l_out.data(), l_out.size());
+        for (size_t i = 0; i < l_out.size(); ++i)
+        {
+            float l_expected = std::exp(l_expIn[i]);
+            EXPECT_NEAR(l_expected, l_out[i], l_expected * 1e-6) << Elementwise::IsaName(l_isa);
+        }
+
+        Elementwise::Log(l_logIn.data(), l_out.data(), l_out.size());
+        for (size_t i = 0; i < l_out.size(); ++i)
+        {
+            float l_expected = std::log(l_logIn[i]);
+            EXPECT_NEAR(l_expected, l_out[i], std::max(std::fabs(l_expected) * 1e-6, 1e-7))
+                << Elementwise::IsaName(l_isa) << " log " << l_logIn[i];
+        }
+    }
+}
+
+TEST(ElementwiseTest, TestExpLogSpecialValues)
+{
+    const float l_inf = numeric_limits<float>::infinity();
+    const float l_nan = numeric_limits<float>::quiet_NaN();
+
+    for (Elementwise::Isa l_isa : SupportedIsas())
+    {
+        ScopedIsa l_scopedIsa(l_isa);
+
+        vector<float> l_in = {-l_inf, -200.0, 0.0, 100.0, l_inf, l_nan};
+        vector<float> l_out(l_in.size());
+        Elementwise::Exp(l_in.data(), l_out.data(), l_in.size());
+        EXPECT_EQ(0.0, l_out[0]);
+        EXPECT_EQ(0.0, l_out[1]);
+        EXPECT_EQ(1.0, l_out[2]);
+        EXPECT_EQ(l_inf, l_out[3]);
+        EXPECT_EQ(l_inf, l_out[4]);
+        EXPECT_TRUE(std::isnan(l_out[5]));
+
+        l_in = {0.0, -1.0, l_inf, l_nan, 1e-40f};
+        l_out.resize(l_in.size());
+        Elementwise::Log(l_in.data(), l_out.data(), l_in.size());
+        EXPECT_EQ(-l_inf, l_out[0]);
+        EXPECT_TRUE(std::isnan(l_out[1]));
+        EXPECT_EQ(l_inf, l_out[2]);
+        EXPECT_TRUE(std::isnan(l_out[3]));
+        // denormals are not flushed to zero
+        EXPECT_NEAR(std::log(1e-40), l_out[4], 1e-4);
+    }
+}
+
+TEST(ElementwiseTest, TestTensorBroadcast)
+{
+    TTensorPtr l_mat = Tensor::New({2, 3}, {1.0, 2.0, 3.0,
+                                            4.0, 5.0, 6.0});
+    TMutableTensorPtr l_out = Tensor::New({2, 3});
+
+    TensorMath::Apply(ElementwiseOp::ADD, l_mat, Tensor::New({1, 3}, {10.0, 20.0, 30.0}), l_out);
+    EXPECT_EQ(vector<float>({11.0, 22.0, 33.0, 14.0, 25.0, 36.0}),
+              vector<float>(l_out->Data().begin(), l_out->Data().end()));
+
+    TensorMath::Apply(ElementwiseOp::MUL, l_mat, Tensor::New({2, 1}, {2.0, -1.0}), l_out);
+    EXPECT_EQ(vector<float>({2.0, 4.0, 6.0, -4.0, -5.0, -6.0}),
+              vector<float>(l_out->Data().begin(), l_out->Data().end()));
+
+    TensorMath::Apply(ElementwiseOp::SUB, l_mat, l_mat, l_out);
+    EXPECT_EQ(vector<float>(6, 0.0), vector<float>(l_out->Data().begin(), l_out->Data().end()));
+
+    TensorMath::Apply(ElementwiseOp::MAX, l_mat, Tensor::New({1, 1}, {3.5}), l_out);
+    EXPECT_EQ(vector<float>({3.5, 3.5, 3.5, 4.0, 5.0, 6.0}),
+              vector<float>(l_out->Data().begin(), l_out->Data().end()));
+
+    // in place into the input
+    TMutableTensorPtr l_inPlace = Tensor::New({2, 3}, {1.0, 2.0, 3.0, 4.0, 5.0, 6.0});
+    TensorMath::Apply(ElementwiseOp::DIV, l_inPlace, 2.0f, l_inPlace);
+    EXPECT_EQ(vector<float>({0.5, 1.0, 1.5, 2.0, 2.5, 3.0}),
+              vector<float>(l_inPlace->Data().begin(), l_inPlace->Data().end()));
+
+    TensorMath::Axpy(2.0, l_mat, l_inPlace);
+    EXPECT_EQ(vector<float>({2.5, 5.0, 7.5, 10.0, 12.5, 15.0}),
+              vector<float>(l_inPlace->Data().begin(), l_inPlace->Data().end()));
+
+    EXPECT_THROW(TensorMath::Apply(ElementwiseOp::ADD, l_mat, Tensor::New({1, 2}), l_out), std::runtime_error);
+    EXPECT_THROW(TensorMath::Apply(ElementwiseOp::ADD, l_mat, 1.0f, Tensor::New({3, 2})), std::runtime_error);
+    EXPECT_THROW(TensorMath::Exp(l_mat, Tensor::New({6})), std::runtime_error);
+}
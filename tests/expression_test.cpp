@@ -0,0 +1,97 @@
+/*
+ * Expression Test
+ *
+ */
+
+#include "neural/math/expression.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+TMutableTensorPtr RandomTensor(size_t a_rows, size_t a_cols, unsigned a_seed)
+{
+    mt19937 l_random(a_seed);
+    uniform_real_distribution<float> l_value(0.1, 0.9);
+    TMutableTensorPtr l_ret = Tensor::New({a_rows, a_cols});
+    for (float& l_item : l_ret->MutableData())
+    {
+        l_item = l_value(l_random);
+    }
+    return l_ret;
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(ExpressionTest, TestFusedMatchesStepByStep)
+{
+    // a few blocks and a partial one at the end
+    TTensorPtr l_targets = RandomTensor(7, 301, 1);
+    TTensorPtr l_inputs = RandomTensor(7, 301, 2);
+    TMutableTensorPtr l_out = Tensor::New({7, 301});
+
+    expr::Assign(l_out, (expr::Ref(l_targets) - expr::Ref(l_inputs)) * -2.0f);
+    for (size_t i = 0; i < l_out->Size(); ++i)
+    {
+        EXPECT_EQ(-2.0f * (l_targets->Data()[i] - l_inputs->Data()[i]), l_out->Data()[i]);
+    }
+
+    // constants on the left, unary functions, and max
+    expr::Ref y(l_targets);
+    expr::Ref yhat(l_inputs);
+    expr::Assign(l_out, expr::Max(1.0f - y, 0.5f) * expr::Exp(yhat) / expr::Log(2.0f + yhat));
+    for (size_t i = 0; i < l_out->Size(); ++i)
+    {
+        float l_y = l_targets->Data()[i];
+        float l_yhat = l_inputs->Data()[i];
+        float l_expected = std::max(1.0f - l_y, 0.5f) * std::exp(l_yhat) / std::log(2.0f + l_yhat);
+        EXPECT_NEAR(l_expected, l_out->Data()[i], 1e-5);
+    }
+
+    float l_expectedSum = 0.0;
+    for (size_t i = 0; i < l_out->Size(); ++i)
+    {
+        float l_diff = l_targets->Data()[i] - l_inputs->Data()[i];
+        l_expectedSum += l_diff * l_diff;
+    }
+    EXPECT_NEAR(l_expectedSum, expr::Sum(expr::Square(y - yhat)), 1e-3);
+}
+
+TEST(ExpressionTest, TestAssignIntoLeaf)
+{
+    TMutableTensorPtr l_tensor = Tensor::New({2, 3}, {1.0, 2.0, 3.0, 4.0, 5.0, 6.0});
+    expr::Ref l_ref(l_tensor);
+    expr::Assign(l_tensor, (l_ref * l_ref) + 1.0f);
+    EXPECT_EQ(vector<float>({2.0, 5.0, 10.0, 17.0, 26.0, 37.0}),
+              vector<float>(l_tensor->Data().begin(), l_tensor->Data().end()));
+
+    // a bare leaf or a constant is a copy or a fill
+    TMutableTensorPtr l_copy = expr::Evaluate({2, 3}, expr::Ref(l_tensor));
+    EXPECT_EQ(l_tensor->Data(), l_copy->Data());
+    expr::Assign(l_copy, expr::Constant(3.0));
+    EXPECT_EQ(vector<float>(6, 3.0), vector<float>(l_copy->Data().begin(), l_copy->Data().end()));
+}
+
+TEST(ExpressionTest, TestSizesMustMatch)
+{
+    TTensorPtr l_small = Tensor::New({1, 3});
+    TTensorPtr l_large = Tensor::New({2, 3});
+    EXPECT_THROW(expr::Ref(l_small) + expr::Ref(l_large), std::runtime_error);
+    EXPECT_THROW(expr::Assign(Tensor::New({1, 3}), expr::Ref(l_large) * 2.0f), std::runtime_error);
+
+    // an empty leaf is not a constant, it does not fit a bigger output
+    TTensorPtr l_empty = Tensor::New({0, 3});
+    EXPECT_THROW(expr::Assign(Tensor::New({1, 3}), expr::Ref(l_empty) + 1.0f), std::runtime_error);
+    EXPECT_EQ(0.0, expr::Sum(expr::Ref(l_empty) * 2.0f));
+    EXPECT_THROW(expr::Sum(expr::Constant(1.0) + 1.0f), std::runtime_error);
+}
@@ -0,0 +1,52 @@
+/*
+ * Helpers for tests that run every Elementwise code path
+ *
+ */
+
+#pragma once
+
+#include "neural/math/elementwise.h"
+
+#include <vector>
+
+namespace neural
+{
+
+// Every code path this machine can run, plain loop first
+inline std::vector<Elementwise::Isa> SupportedIsas()
+{
+    std::vector<Elementwise::Isa> l_isas;
+    for (Elementwise::Isa l_isa : {Elementwise::Isa::SCALAR, Elementwise::Isa::AVX2, Elementwise::Isa::AVX512})
+    {
+        if (l_isa <= Elementwise::BestIsa())
+        {
+            l_isas.push_back(l_isa);
+        }
+    }
+    return l_isas;
+}
+
+// Forces a code path until it goes out of scope, so a failed ASSERT
+// does not leave it forced for the tests that run after
+class ScopedIsa
+{
+public:
+    explicit ScopedIsa(Elementwise::Isa a_isa)
+        : m_previous(Elementwise::ActiveIsa())
+    {
+        Elementwise::SetIsa(a_isa);
+    }
+
+    ~ScopedIsa()
+    {
+        Elementwise::SetIsa(m_previous);
+    }
+
+    ScopedIsa(const ScopedIsa&) = delete;
+    ScopedIsa& operator=(const ScopedIsa&) = delete;
+
+private:
+    Elementwise::Isa m_previous;
+};
+
+} // namespace neural
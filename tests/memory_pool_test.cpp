@@ -0,0 +1,145 @@
+/*
+ * Memory Pool test
+ *
+ */
+
+#include "neural/util/memory_pool.h"
+#include "neural/math/tensor_math.h"
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+// Forwards to the pool, counting what goes through it
+class CountingResource : public MemoryResource
+{
+public:
+    CountingResource() : m_numAllocations(0), m_numDeallocations(0) {}
+
+    size_t m_numAllocations;
+    size_t m_numDeallocations;
+
+protected:
+    virtual void* p_Allocate(size_t a_bytes) override
+    {
+        ++m_numAllocations;
+        return MemoryPool::Instance()->Allocate(a_bytes);
+    }
+
+    virtual void p_Deallocate(void* a_ptr, size_t a_bytes) override
+    {
+        ++m_numDeallocations;
+        MemoryPool::Instance()->Deallocate(a_ptr, a_bytes);
+    }
+};
+
+// One forward / backward worth of temporaries
+void TrainingStep(const TTensorPtr& a_input, const TTensorPtr& a_weights)
+{
+    TTensorPtr l_input = TensorMath::AddCol(a_input, 1.0);
+    TTensorPtr l_output = TensorMath::Multiply(l_input, a_weights);
+    TMutableTensorPtr l_grad = l_output->ToMutable();
+    TTensorPtr l_weightGrad = TensorMath::Multiply(TensorView(l_input).Transpose(), l_grad);
+    TTensorPtr l_inputGrad = TensorMath::RemoveCol(
+        TensorMath::Multiply(l_grad, TensorView(a_weights).Transpose()));
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(MemoryPoolTest, TestTensorDataIsAligned)
+{
+    for (size_t l_size : {1, 3, 17, 785, 4096})
+    {
+        TTensorPtr t = Tensor::New({l_size, 3});
+        uintptr_t l_address = reinterpret_cast<uintptr_t>(t->Data().data());
+        EXPECT_EQ(0, l_address % MemoryResource::ALIGNMENT);
+    }
+}
+
+TEST(MemoryPoolTest, TestFreedBlocksAreReused)
+{
+    MemoryPool* l_pool = MemoryPool::Instance();
+
+    const float* l_first;
+    {
+        TTensorPtr t = Tensor::Zeros({100, 300});
+        l_first = t->Data().data();
+    }
+
+    size_t l_numSystem = l_pool->NumSystemAllocations();
+
+    // same size class, comes back off this thread's free list
+    TTensorPtr t = Tensor::Zeros({120, 250});
+    EXPECT_EQ(l_first, t->Data().data());
+    EXPECT_EQ(l_numSystem, l_pool->NumSystemAllocations());
+}
+
+TEST(MemoryPoolTest, TestSteadyStateMakesNoSystemAllocations)
+{
+    MemoryPool* l_pool = MemoryPool::Instance();
+    TTensorPtr l_input = Tensor::Random({32, 784});
+    TTensorPtr l_weights = Tensor::Random({785, 300});
+
+    // first iteration fills the free lists
+    TrainingStep(l_input, l_weights);
+    size_t l_numSystem = l_pool->NumSystemAllocations();
+
+    for (size_t i = 0; i < 10; ++i)
+    {
+        TrainingStep(l_input, l_weights);
+    }
+    EXPECT_EQ(l_numSystem, l_pool->NumSystemAllocations());
+}
+
+TEST(MemoryPoolTest, TestDefaultResourceIsPluggable)
+{
+    CountingResource l_resource;
+    MemoryResource* l_previous = MemoryResource::SetDefault(&l_resource);
+    EXPECT_EQ(MemoryPool::Instance(), l_previous);
+
+    {
+        TTensorPtr t = Tensor::Ones({4, 4});
+        EXPECT_EQ(1, l_resource.m_numAllocations);
+
+        // copies take the current default too
+        TMutableTensorPtr l_copy = t->ToMutable();
+        EXPECT_EQ(2, l_resource.m_numAllocations);
+
+        MemoryResource::SetDefault(l_previous);
+
+        // freed back through the resource they came from
+        t.reset();
+        EXPECT_EQ(1, l_resource.m_numDeallocations);
+    }
+    EXPECT_EQ(2, l_resource.m_numDeallocations);
+    EXPECT_EQ(MemoryPool::Instance(), MemoryResource::Default());
+}
+
+TEST(MemoryPoolTest, TestTrim)
+{
+    MemoryPool* l_pool = MemoryPool::Instance();
+
+    // more than a thread keeps to itself, the rest spills to the shared lists
+    {
+        vector<TTensorPtr> l_tensors;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            l_tensors.push_back(Tensor::New({1024, 1024}));
+        }
+    }
+    EXPECT_LT(0, l_pool->NumCachedBytes());
+
+    l_pool->Trim();
+    EXPECT_EQ(0, l_pool->NumCachedBytes());
+
+    size_t l_numSystem = l_pool->NumSystemAllocations();
+    TTensorPtr t = Tensor::New({1024, 1024});
+    EXPECT_EQ(l_numSystem + 1, l_pool->NumSystemAllocations());
+}
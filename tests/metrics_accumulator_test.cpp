@@ -0,0 +1,202 @@
+/*
+ * Accumulator Merge / Serialize Test
+ *
+ */
+
+#include "neural/metrics/precision.h"
+#include "neural/metrics/recall.h"
+#include "neural/metrics/record_accumulator.h"
+#include "neural/metrics/binned_precision_recall.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+// Shard i of a fake test set, each shard has a different mix of results
+void ShardBatch(size_t a_shard, TTensorPtr& a_outOutputs, TTensorPtr& a_outTargets)
+{
+    float l_conf = 0.4f + (0.1f * a_shard);
+    a_outOutputs = Tensor::New({3, 2},
+        {
+            l_conf, 1.0f - l_conf,
+            0.9f, 0.1f,
+            0.2f, 0.8f
+        });
+    a_outTargets = Tensor::New({3, 2},
+        {
+            1, 0,
+            a_shard % 2 == 0 ? 0.0f : 1.0f, a_shard % 2 == 0 ? 1.0f : 0.0f,
+            0, 1
+        });
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(StatsTest, TestMetricsMergeShardsAcrossProcesses)
+{
+    const size_t l_numShards = 4;
+
+    // each child process evaluates its own shard and writes it to disk
+    vector<string> l_files;
+    vector<pid_t> l_children;
+    for (size_t i = 0; i < l_numShards; ++i)
+    {
+        char l_path[] = "/tmp/neural_metric_shard_XXXXXX";
+        int l_fd = mkstemp(l_path);
+        ASSERT_NE(-1, l_fd);
+        close(l_fd);
+        l_files.push_back(l_path);
+
+        pid_t l_pid = fork();
+        ASSERT_NE(-1, l_pid);
+        if (0 == l_pid)
+        {
+            TTensorPtr l_outputs, l_targets;
+            ShardBatch(i, l_outputs, l_targets);
+
+            metrics::Precision l_shard;
+            l_shard.AddResults(l_outputs, l_targets);
+
+            ofstream l_out(l_path, ios::binary);
+            l_shard.Serialize(l_out);
+            l_out.close();
+            _exit(l_out ? 0 : 1);
+        }
+        l_children.push_back(l_pid);
+    }
+
+    for (size_t i = 0; i < l_children.size(); ++i)
+    {
+        int l_status = 0;
+        waitpid(l_children.at(i), &l_status, 0);
+        EXPECT_TRUE(WIFEXITED(l_status));
+        EXPECT_EQ(0, WEXITSTATUS(l_status));
+    }
+
+    // reduce the shards and compare to evaluating everything in one place
+    metrics::Precision l_merged;
+    metrics::Precision l_expected;
+    for (size_t i = 0; i < l_numShards; ++i)
+    {
+        ifstream l_in(l_files.at(i), ios::binary);
+        metrics::Precision l_shard;
+        l_shard.Deserialize(l_in);
+        l_merged.Merge(l_shard);
+        remove(l_files.at(i).c_str());
+
+        TTensorPtr l_outputs, l_targets;
+        ShardBatch(i, l_outputs, l_targets);
+        l_expected.AddResults(l_outputs, l_targets);
+    }
+
+    EXPECT_EQ(l_expected.NumExamples(), l_merged.NumExamples());
+    for (float l_cutoff : {0.1f, 0.45f, 0.5f, 0.65f, 0.85f})
+    {
+        EXPECT_NEAR(l_expected.Calculate(l_cutoff), l_merged.Calculate(l_cutoff), 0.0001);
+    }
+}
+
+TEST(StatsTest, TestMetricsSerializeRoundTrip)
+{
+    TTensorPtr l_outputs, l_targets;
+    ShardBatch(1, l_outputs, l_targets);
+
+    // windowed records keep the window and tracked cutoffs
+    metrics::TRecordAccumulatorPtr l_records = metrics::RecordAccumulator::New(4);
+    l_records->TrackCutoff(0.5);
+    metrics::Recall l_recall(l_records);
+    l_recall.AddResults(l_outputs, l_targets);
+    l_recall.AddResults(l_outputs, l_targets);
+
+    stringstream l_stream;
+    l_recall.Serialize(l_stream);
+    metrics::TAccumulatorPtr l_loaded = metrics::Accumulator::Load(l_stream);
+    metrics::Recall l_loadedRecall(l_loaded);
+
+    EXPECT_EQ(4, l_loaded->NumExamples());
+    EXPECT_NEAR(l_recall.Calculate(0.5), l_loadedRecall.Calculate(0.5), 0.0001);
+    EXPECT_NEAR(l_recall.Calculate(0.3), l_loadedRecall.Calculate(0.3), 0.0001);
+
+    // histograms merge and round trip too
+    metrics::TBinnedPrecisionRecallPtr l_binned = metrics::BinnedPrecisionRecall::New(16);
+    metrics::TBinnedPrecisionRecallPtr l_otherBinned = metrics::BinnedPrecisionRecall::New(16);
+    metrics::Precision l_precision(l_binned);
+    metrics::Precision l_otherPrecision(l_otherBinned);
+    l_precision.AddResults(l_outputs, l_targets);
+    ShardBatch(2, l_outputs, l_targets);
+    l_otherPrecision.AddResults(l_outputs, l_targets);
+    l_precision.Merge(l_otherPrecision);
+    EXPECT_EQ(6, l_binned->NumExamples());
+
+    stringstream l_binnedStream;
+    l_precision.Serialize(l_binnedStream);
+    metrics::Precision l_loadedPrecision(metrics::BinnedPrecisionRecall::New(4));
+    l_loadedPrecision.Deserialize(l_binnedStream);
+    EXPECT_EQ(6, l_loadedPrecision.NumExamples());
+    EXPECT_NEAR(l_precision.Calculate(0.5), l_loadedPrecision.Calculate(0.5), 0.0001);
+}
+
+TEST(StatsTest, TestMetricsMergeMismatchedAccumulators)
+{
+    metrics::Precision l_records;
+    metrics::Precision l_binned(metrics::BinnedPrecisionRecall::New());
+    EXPECT_THROW(l_records.Merge(l_binned), runtime_error);
+
+    stringstream l_stream;
+    l_binned.Serialize(l_stream);
+    EXPECT_THROW(l_records.Deserialize(l_stream), runtime_error);
+
+    stringstream l_truncated("NMAC");
+    EXPECT_THROW(metrics::Accumulator::Load(l_truncated), runtime_error);
+}
+
+TEST(StatsTest, TestMetricsDeserializeKeepsTrackedCutoffs)
+{
+    // saved without any cutoff tracked
+    vector<metrics::PredictionRecord> l_records = {{0, 0, 0.9f}, {1, 0, 0.7f}, {1, 1, 0.3f}};
+    metrics::TRecordAccumulatorPtr l_saved = metrics::RecordAccumulator::New();
+    l_saved->Add(l_records.data(), l_records.size());
+    stringstream l_stream;
+    l_saved->Serialize(l_stream);
+    string l_state = l_stream.str();
+
+    // precision tracks 0.5 and keeps counting it after a load
+    TTensorPtr l_outputs, l_targets;
+    ShardBatch(2, l_outputs, l_targets);
+    metrics::Precision l_precision;
+    l_precision.AddResults(l_outputs, l_targets);
+    l_precision.AddResults(l_outputs, l_targets);
+    float l_before = l_precision.Calculate(0.5);
+
+    // a truncated stream leaves the records and counts alone
+    stringstream l_truncated(l_state.substr(0, l_state.size() - 4));
+    EXPECT_THROW(l_precision.Deserialize(l_truncated), runtime_error);
+    EXPECT_EQ(6, l_precision.NumExamples());
+    EXPECT_EQ(l_before, l_precision.Calculate(0.5));
+
+    stringstream l_full(l_state);
+    l_precision.Deserialize(l_full);
+    EXPECT_EQ(3, l_precision.NumExamples());
+    // 0.9 is a true positive and 0.7 a false positive
+    EXPECT_NEAR(0.5, l_precision.Calculate(0.5), 0.0001);
+
+    // counts at the tracked cutoff follow records added after the load
+    metrics::TRecordAccumulatorPtr l_expectedRecords = metrics::RecordAccumulator::New();
+    l_expectedRecords->Add(l_records.data(), l_records.size());
+    metrics::Precision l_expected(l_expectedRecords);
+    l_precision.AddResults(l_outputs, l_targets);
+    l_expected.AddResults(l_outputs, l_targets);
+    EXPECT_NEAR(l_expected.Calculate(0.5), l_precision.Calculate(0.5), 0.0001);
+}
@@ -35,3 +35,45 @@ TEST(StatsTest, TestMetricsAccuracy)
 
     EXPECT_NEAR(0.5, l_accuracy.Calculate(), 0.001);
 }
+
+TEST(StatsTest, TestMetricsAccuracyRunningWindow)
+{
+    TTensorPtr l_wrongOutputs = Tensor::New({2, 2},
+        {
+            0.9, 0.1,
+            0.8, 0.2
+        });
+
+    TTensorPtr l_rightOutputs = Tensor::New({1, 2},
+        {
+            0.3, 0.7
+        });
+
+    TTensorPtr l_wrongTargets = Tensor::New({2, 2},
+        {
+            0, 1,
+            0, 1
+        });
+
+    TTensorPtr l_rightTargets = Tensor::New({1, 2},
+        {
+            0, 1
+        });
+
+    // only keep the last 3 examples around
+    metrics::Accuracy l_accuracy(3);
+    l_accuracy.AddResults(l_wrongOutputs, l_wrongTargets);
+    l_accuracy.AddResults(l_rightOutputs, l_rightTargets);
+    EXPECT_EQ(3, l_accuracy.NumExamples());
+    EXPECT_NEAR(1.0 / 3.0, l_accuracy.Calculate(), 0.001);
+
+    // first wrong example falls out of the window
+    l_accuracy.AddResults(l_rightOutputs, l_rightTargets);
+    EXPECT_EQ(3, l_accuracy.NumExamples());
+    EXPECT_NEAR(2.0 / 3.0, l_accuracy.Calculate(), 0.001);
+
+    // and then the second one
+    l_accuracy.AddResults(l_rightOutputs, l_rightTargets);
+    EXPECT_EQ(3, l_accuracy.NumExamples());
+    EXPECT_NEAR(1.0, l_accuracy.Calculate(), 0.001);
+}
@@ -0,0 +1,163 @@
+/*
+ * Area Under Curve Test
+ *
+ */
+
+#include "neural/metrics/area_under_curve.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+// O(correct * incorrect) ROC AUC, ties count half
+float BruteForceRocAuc(const vector<metrics::PredictionRecord>& a_records)
+{
+    double l_pairs = 0.0;
+    double l_numCorrect = 0.0;
+    double l_numIncorrect = 0.0;
+    for (const metrics::PredictionRecord& l_correct : a_records)
+    {
+        if (l_correct.target != l_correct.prediction) continue;
+        l_numCorrect += 1.0;
+        for (const metrics::PredictionRecord& l_incorrect : a_records)
+        {
+            if (l_incorrect.target == l_incorrect.prediction) continue;
+            if (l_correct.confidence > l_incorrect.confidence) l_pairs += 1.0;
+            else if (l_correct.confidence == l_incorrect.confidence) l_pairs += 0.5;
+        }
+    }
+    l_numIncorrect = a_records.size() - l_numCorrect;
+    return static_cast<float>(l_pairs / (l_numCorrect * l_numIncorrect));
+}
+
+// Precision at every correct example's confidence, averaged
+float BruteForceAveragePrecision(const vector<metrics::PredictionRecord>& a_records)
+{
+    double l_sum = 0.0;
+    double l_numCorrect = 0.0;
+    for (const metrics::PredictionRecord& l_record : a_records)
+    {
+        if (l_record.target != l_record.prediction) continue;
+        l_numCorrect += 1.0;
+
+        double l_atOrAbove = 0.0;
+        double l_correctAtOrAbove = 0.0;
+        for (const metrics::PredictionRecord& l_other : a_records)
+        {
+            if (l_other.confidence >= l_record.confidence)
+            {
+                l_atOrAbove += 1.0;
+                if (l_other.target == l_other.prediction) l_correctAtOrAbove += 1.0;
+            }
+        }
+        l_sum += l_correctAtOrAbove / l_atOrAbove;
+    }
+    return static_cast<float>(l_sum / l_numCorrect);
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(StatsTest, TestMetricsAreaUnderCurveSmall)
+{
+    TTensorPtr l_outputs = Tensor::New({4, 2},
+        {
+            0.9, 0.1, // correct
+            0.8, 0.2, // incorrect
+            0.3, 0.7, // correct
+            0.6, 0.4  // incorrect
+        });
+
+    TTensorPtr l_targets = Tensor::New({4, 2},
+        {
+            1, 0,
+            0, 1,
+            0, 1,
+            0, 1
+        });
+
+    metrics::AreaUnderCurve l_auc;
+    l_auc.AddResults(l_outputs, l_targets);
+
+    // 0.8 only loses to 0.9, 0.6 loses to both
+    EXPECT_NEAR(0.75, l_auc.RocAuc(), 0.0001);
+
+    // precision 1 @0.9 and 2/3 @0.7, each adding half the recall
+    EXPECT_NEAR(0.8333, l_auc.AveragePrecision(), 0.0001);
+    EXPECT_NEAR(0.8333, l_auc.Calculate(), 0.0001);
+
+    // class 0 got 0.9 right and 0.8, 0.6 wrong
+    EXPECT_NEAR(1.0, l_auc.RocAuc(0), 0.0001);
+    EXPECT_NEAR(1.0, l_auc.AveragePrecision(0), 0.0001);
+
+    // class 1 never got anything wrong, so there is no ROC AUC
+    EXPECT_NEAR(0.0, l_auc.RocAuc(1), 0.0001);
+    EXPECT_NEAR(1.0, l_auc.AveragePrecision(1), 0.0001);
+    EXPECT_NEAR(0.0, l_auc.RocAuc(2), 0.0001);
+
+    EXPECT_NEAR(1.0, l_auc.MacroRocAuc(), 0.0001);
+    EXPECT_NEAR(1.0, l_auc.MacroAveragePrecision(), 0.0001);
+
+    // all ties is a coin flip
+    metrics::AreaUnderCurve l_ties;
+    l_ties.AddResults(
+        Tensor::New({2, 2}, {0.6, 0.4, 0.6, 0.4}),
+        Tensor::New({2, 2}, {1, 0, 0, 1}));
+    EXPECT_NEAR(0.5, l_ties.RocAuc(), 0.0001);
+    EXPECT_NEAR(0.5, l_ties.AveragePrecision(), 0.0001);
+}
+
+TEST(StatsTest, TestMetricsAreaUnderCurveMatchesBruteForce)
+{
+    mt19937 l_random(7);
+    uniform_int_distribution<int> l_class(0, 3);
+    // few distinct confidences so there are lots of ties
+    uniform_int_distribution<int> l_level(25, 100);
+
+    vector<metrics::PredictionRecord> l_records(9000);
+    for (metrics::PredictionRecord& l_record : l_records)
+    {
+        l_record.prediction = static_cast<uint16_t>(l_class(l_random));
+        l_record.target = (l_class(l_random) == 0) ? 3 - l_record.prediction : l_record.prediction;
+        l_record.confidence = l_level(l_random) / 100.0f;
+        // make the confidence mean something
+        if (l_record.target == l_record.prediction && l_class(l_random) != 0)
+        {
+            l_record.confidence = std::min(1.0f, l_record.confidence + 0.1f);
+        }
+    }
+
+    metrics::TRecordAccumulatorPtr l_accumulator = metrics::RecordAccumulator::New();
+    // two batches so the cache has to be rebuilt
+    l_accumulator->Add(l_records.data(), l_records.size() / 2);
+    metrics::AreaUnderCurve l_auc(l_accumulator);
+    l_auc.RocAuc();
+    l_accumulator->Add(l_records.data() + (l_records.size() / 2), l_records.size() - (l_records.size() / 2));
+
+    EXPECT_NEAR(BruteForceRocAuc(l_records), l_auc.RocAuc(), 0.0001);
+    EXPECT_NEAR(BruteForceAveragePrecision(l_records), l_auc.AveragePrecision(), 0.0001);
+
+    float l_macroRocAuc = 0.0f;
+    float l_macroAveragePrecision = 0.0f;
+    for (uint16_t i = 0; i < 4; ++i)
+    {
+        vector<metrics::PredictionRecord> l_classRecords;
+        for (const metrics::PredictionRecord& l_record : l_records)
+        {
+            if (l_record.prediction == i) l_classRecords.push_back(l_record);
+        }
+        EXPECT_NEAR(BruteForceRocAuc(l_classRecords), l_auc.RocAuc(i), 0.0001);
+        EXPECT_NEAR(BruteForceAveragePrecision(l_classRecords), l_auc.AveragePrecision(i), 0.0001);
+        l_macroRocAuc += l_auc.RocAuc(i) / 4.0f;
+        l_macroAveragePrecision += l_auc.AveragePrecision(i) / 4.0f;
+    }
+    EXPECT_NEAR(l_macroRocAuc, l_auc.MacroRocAuc(), 0.0001);
+    EXPECT_NEAR(l_macroAveragePrecision, l_auc.MacroAveragePrecision(), 0.0001);
+}
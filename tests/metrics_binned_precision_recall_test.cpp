@@ -0,0 +1,164 @@
+/*
+ * Binned Precision Recall Test
+ *
+ */
+
+#include "neural/metrics/binned_precision_recall.h"
+#include "neural/metrics/record_accumulator.h"
+#include "neural/metrics/precision.h"
+#include "neural/metrics/recall.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+TTensorPtr BinnedTestOutputs()
+{
+    return Tensor::New({6, 3},
+        {
+            0.75, 0.15, 0.1,
+            0.62, 0.18, 0.2,
+            0.1, 0.25, 0.65,
+            0.1, 0.44, 0.46,
+            0.34, 0.33, 0.33,
+            0.05, 0.93, 0.02
+        });
+}
+
+TTensorPtr BinnedTestTargets()
+{
+    return Tensor::New({6, 3},
+        {
+            1, 0, 0,
+            0, 1, 0,
+            0, 0, 1,
+            0, 0, 1,
+            1, 0, 0,
+            0, 1, 0
+        });
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(StatsTest, TestMetricsBinnedMatchesExactOnBinEdges)
+{
+    metrics::TBinnedPrecisionRecallPtr l_binned = metrics::BinnedPrecisionRecall::New(10);
+    metrics::Precision l_binnedPrecision(l_binned);
+    metrics::Recall l_binnedRecall(l_binned);
+    metrics::Precision l_precision;
+    metrics::Recall l_recall;
+
+    // add the same batch a few times, the histograms only grow in counts
+    for (size_t i = 0; i < 3; ++i)
+    {
+        l_binnedPrecision.AddResults(BinnedTestOutputs(), BinnedTestTargets());
+        l_precision.AddResults(BinnedTestOutputs(), BinnedTestTargets());
+        l_recall.AddResults(BinnedTestOutputs(), BinnedTestTargets());
+    }
+    EXPECT_EQ(18, l_binned->NumExamples());
+    EXPECT_EQ(3, l_binned->NumClasses());
+
+    // none of the confidences sit on an edge so these are exact
+    for (float l_cutoff : {0.0f, 0.2f, 0.4f, 0.5f, 0.7f, 0.9f, 1.0f})
+    {
+        EXPECT_NEAR(l_precision.Calculate(l_cutoff), l_binnedPrecision.Calculate(l_cutoff), 0.0001);
+        EXPECT_NEAR(l_recall.Calculate(l_cutoff), l_binnedRecall.Calculate(l_cutoff), 0.0001);
+    }
+
+    // one point per bin lower edge
+    vector<metrics::CurvePoint> l_points = l_binned->Points();
+    ASSERT_EQ(10, l_points.size());
+    EXPECT_NEAR(0.5, l_points.at(5).threshold, 0.0001);
+    EXPECT_NEAR(l_precision.Calculate(0.5), l_points.at(5).precision, 0.0001);
+    EXPECT_NEAR(l_recall.Calculate(0.5), l_points.at(5).recall, 0.0001);
+}
+
+TEST(StatsTest, TestMetricsBinnedPerClass)
+{
+    metrics::TBinnedPrecisionRecallPtr l_binned = metrics::BinnedPrecisionRecall::New(10);
+    metrics::Precision l_precision(l_binned);
+    l_precision.AddResults(BinnedTestOutputs(), BinnedTestTargets());
+
+    // predicted class 0: 0.75 correct, 0.62 incorrect, 0.34 correct
+    metrics::ConfusionCounts l_counts = l_binned->CalcConfusionCounts(0.5, 0);
+    EXPECT_EQ(1, l_counts.truePositives);
+    EXPECT_EQ(1, l_counts.falsePositives);
+    EXPECT_EQ(1, l_counts.falseNegatives);
+    EXPECT_EQ(0, l_counts.trueNegatives);
+
+    // predicted class 1: 0.93 correct
+    l_counts = l_binned->CalcConfusionCounts(0.5, 1);
+    EXPECT_EQ(1, l_counts.truePositives);
+    EXPECT_EQ(0, l_counts.falsePositives);
+
+    // predicted class 2: 0.65 and 0.46 both correct
+    vector<metrics::CurvePoint> l_points = l_binned->Points(2);
+    EXPECT_NEAR(1.0, l_points.at(5).precision, 0.0001);
+    EXPECT_NEAR(0.5, l_points.at(5).recall, 0.0001);
+
+    // never predicted
+    l_counts = l_binned->CalcConfusionCounts(0.5, 7);
+    EXPECT_EQ(0, l_counts.truePositives + l_counts.falsePositives +
+                 l_counts.trueNegatives + l_counts.falseNegatives);
+}
+
+TEST(StatsTest, TestMetricsBinnedErrorBoundedByBinWidth)
+{
+    // confidences right above a cutoff in the same bin get counted as above
+    metrics::TBinnedPrecisionRecallPtr l_binned = metrics::BinnedPrecisionRecall::New(4);
+    metrics::Precision l_precision(l_binned);
+    l_precision.AddResults(
+        Tensor::New({2, 2}, {0.3, 0.7, 0.6, 0.4}),
+        Tensor::New({2, 2}, {0, 1, 0, 1}));
+
+    // @0.65 the exact answer is 1 tp and 0 fp, but 0.6 shares the
+    // [0.5, 0.75) bin so it is counted as above as well
+    metrics::ConfusionCounts l_counts = l_binned->CalcConfusionCounts(0.65);
+    EXPECT_EQ(1, l_counts.truePositives);
+    EXPECT_EQ(1, l_counts.falsePositives);
+
+    // a cutoff a bin width higher has no error
+    l_counts = l_binned->CalcConfusionCounts(0.65 + l_binned->BinWidth());
+    EXPECT_EQ(0, l_counts.truePositives);
+    EXPECT_EQ(0, l_counts.falsePositives);
+    EXPECT_EQ(1, l_counts.falseNegatives);
+    EXPECT_EQ(1, l_counts.trueNegatives);
+}
+
+TEST(StatsTest, TestMetricsBinnedCorruptStream)
+{
+    metrics::TBinnedPrecisionRecallPtr l_binned = metrics::BinnedPrecisionRecall::New(4);
+    metrics::Precision l_precision(l_binned);
+    l_precision.AddResults(BinnedTestOutputs(), BinnedTestTargets());
+    stringstream l_stream;
+    l_binned->Serialize(l_stream);
+    string l_state = l_stream.str();
+
+    // after the header the number of bins and of classes, each 8 bytes
+    size_t l_numBinsAt = 24;
+    size_t l_numClassesAt = 32;
+    for (size_t l_at : {l_numBinsAt, l_numClassesAt})
+    {
+        string l_corrupt = l_state;
+        l_corrupt.replace(l_at, 8, 8, '\xff');
+        stringstream l_corruptStream(l_corrupt);
+        EXPECT_THROW(metrics::Accumulator::Load(l_corruptStream), std::runtime_error);
+    }
+
+    // a truncated stream leaves what was there alone
+    metrics::TBinnedPrecisionRecallPtr l_other = metrics::BinnedPrecisionRecall::New(8);
+    stringstream l_truncated(l_state.substr(0, l_state.size() - 4));
+    EXPECT_THROW(l_other->Deserialize(l_truncated), std::runtime_error);
+    EXPECT_EQ(8, l_other->NumBins());
+    EXPECT_EQ(0, l_other->NumClasses());
+
+    stringstream l_goodStream(l_state);
+    EXPECT_EQ(6, metrics::Accumulator::Load(l_goodStream)->NumExamples());
+}
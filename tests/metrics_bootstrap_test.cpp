@@ -0,0 +1,112 @@
+/*
+ * Bootstrap Test
+ *
+ */
+
+#include "neural/metrics/precision.h"
+#include "neural/metrics/recall.h"
+#include "neural/metrics/accuracy.h"
+#include "neural/metrics/area_under_curve.h"
+#include "neural/metrics/binned_precision_recall.h"
+#include "neural/metrics/concurrent_accumulator.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+// Correct about as often as the confidence says
+metrics::TRecordAccumulatorPtr BootstrapTestRecords(size_t a_numRecords)
+{
+    mt19937 l_random(13);
+    uniform_real_distribution<float> l_unit(0.0f, 1.0f);
+
+    vector<metrics::PredictionRecord> l_records(a_numRecords);
+    for (metrics::PredictionRecord& l_record : l_records)
+    {
+        l_record.prediction = 0;
+        l_record.confidence = l_unit(l_random);
+        l_record.target = (l_unit(l_random) < l_record.confidence) ? 0 : 1;
+    }
+
+    metrics::TRecordAccumulatorPtr l_accumulator = metrics::RecordAccumulator::New();
+    l_accumulator->Add(l_records.data(), l_records.size());
+    return l_accumulator;
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(StatsTest, TestMetricsBootstrapIntervals)
+{
+    metrics::TRecordAccumulatorPtr l_records = BootstrapTestRecords(10000);
+    metrics::Precision l_precision(l_records);
+    metrics::Recall l_recall(l_records);
+
+    // unsorted with a repeat, answers come back in the same order
+    vector<float> l_cutoffs = {0.5, 0.25, 0.75, 0.5};
+    vector<metrics::BootstrapInterval> l_intervals = l_precision.Bootstrap(l_cutoffs, 500);
+    ASSERT_EQ(l_cutoffs.size(), l_intervals.size());
+    for (size_t i = 0; i < l_cutoffs.size(); ++i)
+    {
+        const metrics::BootstrapInterval& l_interval = l_intervals.at(i);
+        EXPECT_EQ(l_cutoffs.at(i), l_interval.threshold);
+        EXPECT_NEAR(l_precision.Calculate(l_cutoffs.at(i)), l_interval.value, 0.0001);
+        EXPECT_LE(l_interval.lower, l_interval.value);
+        EXPECT_GE(l_interval.upper, l_interval.value);
+
+        // close to the normal approximation of a proportion
+        metrics::ConfusionCounts l_counts = l_records->CalcConfusionCounts(l_cutoffs.at(i));
+        float l_numAbove = l_counts.truePositives + l_counts.falsePositives;
+        float l_expectedWidth = 2.0f * 1.96f *
+            sqrt(l_interval.value * (1.0f - l_interval.value) / l_numAbove);
+        EXPECT_NEAR(l_expectedWidth, l_interval.upper - l_interval.lower, 0.3f * l_expectedWidth);
+    }
+
+    // same seed, same answer, whatever the thread count
+    vector<metrics::BootstrapInterval> l_again = l_precision.Bootstrap(l_cutoffs, 500);
+    EXPECT_EQ(l_intervals.at(0).lower, l_again.at(0).lower);
+    EXPECT_EQ(l_intervals.at(0).upper, l_again.at(0).upper);
+
+    // wider intervals when asking for more coverage
+    vector<metrics::BootstrapInterval> l_recallNarrow = l_recall.Bootstrap({0.5}, 500, 0.5);
+    vector<metrics::BootstrapInterval> l_recallWide = l_recall.Bootstrap({0.5}, 500, 0.99);
+    EXPECT_NEAR(l_recall.Calculate(0.5), l_recallWide.at(0).value, 0.0001);
+    EXPECT_LT(l_recallNarrow.at(0).upper - l_recallNarrow.at(0).lower,
+              l_recallWide.at(0).upper - l_recallWide.at(0).lower);
+}
+
+TEST(StatsTest, TestMetricsBootstrapNeedsRecords)
+{
+    // accuracy is over every example whatever cutoff is asked for
+    metrics::Accuracy l_accuracy(BootstrapTestRecords(1000));
+    vector<metrics::BootstrapInterval> l_intervals = l_accuracy.Bootstrap({0.5, 0.9}, 100);
+    EXPECT_NEAR(l_accuracy.Calculate(), l_intervals.at(0).value, 0.0001);
+    EXPECT_NEAR(l_accuracy.Calculate(), l_intervals.at(1).value, 0.0001);
+    EXPECT_EQ(0.9f, l_intervals.at(1).threshold);
+
+    // shards of records are resampled together
+    metrics::TConcurrentAccumulatorPtr l_concurrent = metrics::ConcurrentAccumulator::New();
+    metrics::Precision l_concurrentPrecision(l_concurrent);
+    l_concurrentPrecision.AddResults(
+        Tensor::New({4, 2}, {0.9, 0.1, 0.8, 0.2, 0.3, 0.7, 0.4, 0.6}),
+        Tensor::New({4, 2}, {1, 0, 0, 1, 0, 1, 1, 0}));
+    EXPECT_NEAR(l_concurrentPrecision.Calculate(0.5),
+        l_concurrentPrecision.Bootstrap({0.5}, 100).at(0).value, 0.0001);
+
+    metrics::Precision l_binned(metrics::BinnedPrecisionRecall::New());
+    EXPECT_THROW(l_binned.Bootstrap({0.5}), std::runtime_error);
+
+    metrics::AreaUnderCurve l_auc;
+    EXPECT_THROW(l_auc.Bootstrap({0.5}), std::runtime_error);
+
+    metrics::Precision l_precision;
+    EXPECT_THROW(l_precision.Bootstrap({0.5}, 0), std::runtime_error);
+    EXPECT_THROW(l_precision.Bootstrap({0.5}, 100, 1.0f), std::runtime_error);
+}
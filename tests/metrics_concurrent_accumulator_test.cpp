@@ -0,0 +1,169 @@
+/*
+ * Concurrent Accumulator Test
+ *
+ */
+
+#include "neural/metrics/concurrent_accumulator.h"
+#include "neural/metrics/binned_precision_recall.h"
+#include "neural/metrics/precision.h"
+#include "neural/metrics/record_accumulator.h"
+#include "neural/metrics/recall.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+// Batch that depends on which thread and iteration made it
+void ThreadBatch(size_t a_thread, size_t a_iter, TTensorPtr& a_outOutputs, TTensorPtr& a_outTargets)
+{
+    float l_conf = 0.35f + (0.05f * ((a_thread + a_iter) % 12));
+    a_outOutputs = Tensor::New({2, 2},
+        {
+            l_conf, 1.0f - l_conf,
+            1.0f - l_conf, l_conf
+        });
+    a_outTargets = Tensor::New({2, 2},
+        {
+            1, 0,
+            (a_iter % 3 == 0) ? 0.0f : 1.0f, (a_iter % 3 == 0) ? 1.0f : 0.0f
+        });
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(StatsTest, TestMetricsConcurrentAddResults)
+{
+    const size_t l_numThreads = 8;
+    const size_t l_numIters = 200;
+
+    metrics::TConcurrentAccumulatorPtr l_concurrent = metrics::ConcurrentAccumulator::New();
+    metrics::Precision l_precision(l_concurrent);
+    metrics::Recall l_recall(l_concurrent);
+
+    vector<thread> l_threads;
+    for (size_t i = 0; i < l_numThreads; ++i)
+    {
+        l_threads.push_back(thread([&l_precision, i, l_numIters]()
+        {
+            for (size_t j = 0; j < l_numIters; ++j)
+            {
+                TTensorPtr l_outputs, l_targets;
+                ThreadBatch(i, j, l_outputs, l_targets);
+                l_precision.AddResults(l_outputs, l_targets);
+            }
+        }));
+    }
+
+    // reading while the writers are going is safe, just not final
+    EXPECT_LE(l_precision.NumExamples(), l_numThreads * l_numIters * 2);
+
+    for (size_t i = 0; i < l_threads.size(); ++i)
+    {
+        l_threads.at(i).join();
+    }
+
+    metrics::Precision l_expectedPrecision;
+    metrics::Recall l_expectedRecall;
+    for (size_t i = 0; i < l_numThreads; ++i)
+    {
+        for (size_t j = 0; j < l_numIters; ++j)
+        {
+            TTensorPtr l_outputs, l_targets;
+            ThreadBatch(i, j, l_outputs, l_targets);
+            l_expectedPrecision.AddResults(l_outputs, l_targets);
+            l_expectedRecall.AddResults(l_outputs, l_targets);
+        }
+    }
+
+    EXPECT_EQ(l_numThreads, l_concurrent->NumShards());
+    EXPECT_EQ(l_expectedPrecision.NumExamples(), l_precision.NumExamples());
+    for (float l_cutoff : {0.3f, 0.5f, 0.62f, 0.8f})
+    {
+        EXPECT_NEAR(l_expectedPrecision.Calculate(l_cutoff), l_precision.Calculate(l_cutoff), 0.0001);
+        EXPECT_NEAR(l_expectedRecall.Calculate(l_cutoff), l_recall.Calculate(l_cutoff), 0.0001);
+    }
+}
+
+TEST(StatsTest, TestMetricsConcurrentBinnedSnapshot)
+{
+    metrics::TConcurrentAccumulatorPtr l_concurrent = metrics::ConcurrentAccumulator::New(
+        []() { return metrics::BinnedPrecisionRecall::New(20); });
+    metrics::Precision l_precision(l_concurrent);
+
+    vector<thread> l_threads;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        l_threads.push_back(thread([&l_precision, i]()
+        {
+            for (size_t j = 0; j < 50; ++j)
+            {
+                TTensorPtr l_outputs, l_targets;
+                ThreadBatch(i, j, l_outputs, l_targets);
+                l_precision.AddResults(l_outputs, l_targets);
+            }
+        }));
+    }
+    for (size_t i = 0; i < l_threads.size(); ++i)
+    {
+        l_threads.at(i).join();
+    }
+
+    // the snapshot is a plain histogram with every shard in it
+    metrics::TBinnedPrecisionRecallPtr l_snapshot =
+        dynamic_pointer_cast<metrics::BinnedPrecisionRecall>(l_concurrent->Snapshot());
+    ASSERT_TRUE(l_snapshot != nullptr);
+    EXPECT_EQ(400, l_snapshot->NumExamples());
+    EXPECT_NEAR(l_precision.Calculate(0.5),
+                l_snapshot->Points().at(10).precision, 0.0001);
+
+    // and serializes as one, so a reducer does not need to know
+    stringstream l_stream;
+    l_precision.Serialize(l_stream);
+    metrics::TAccumulatorPtr l_loaded = metrics::Accumulator::Load(l_stream);
+    EXPECT_TRUE(dynamic_pointer_cast<metrics::BinnedPrecisionRecall>(l_loaded) != nullptr);
+    EXPECT_EQ(400, l_loaded->NumExamples());
+}
+
+TEST(StatsTest, TestMetricsConcurrentAccumulatorPerEpoch)
+{
+    metrics::PredictionRecord l_record = {1, 1, 0.9f};
+
+    // a new accumulator every epoch, fed by the same long lived thread
+    metrics::TConcurrentAccumulatorPtr l_concurrent;
+    for (size_t l_epoch = 0; l_epoch < 20; ++l_epoch)
+    {
+        l_concurrent = metrics::ConcurrentAccumulator::New();
+        size_t l_version = l_concurrent->Version();
+        l_concurrent->Add(&l_record, 1);
+        l_concurrent->Add(&l_record, 1);
+        EXPECT_EQ(2, l_concurrent->NumExamples());
+        EXPECT_EQ(1, l_concurrent->NumShards());
+        EXPECT_LT(l_version, l_concurrent->Version());
+    }
+
+    // shards of threads that have already exited are let go cleanly
+    thread l_thread([&l_concurrent, &l_record]()
+    {
+        l_concurrent->Add(&l_record, 1);
+    });
+    l_thread.join();
+    EXPECT_EQ(3, l_concurrent->NumExamples());
+    EXPECT_EQ(2, l_concurrent->NumShards());
+
+    // loading replaces the shards without the version going backwards
+    size_t l_version = l_concurrent->Version();
+    stringstream l_stream;
+    metrics::RecordAccumulator::New()->Serialize(l_stream);
+    l_concurrent->Deserialize(l_stream);
+    EXPECT_EQ(0, l_concurrent->NumExamples());
+    EXPECT_LT(l_version, l_concurrent->Version());
+    l_concurrent.reset();
+}
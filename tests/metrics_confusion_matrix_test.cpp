@@ -0,0 +1,75 @@
+/*
+ * Confusion Matrix Test
+ *
+ */
+
+#include "neural/metrics/confusion_matrix.h"
+
+#include <gtest/gtest.h>
+
+using namespace neural;
+using namespace std;
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(StatsTest, TestMetricsConfusionMatrixCounts)
+{
+    TTensorPtr l_outputs = Tensor::New({5, 3},
+        {
+            0.75, 0.15, 0.1,  // 0 as 0
+            0.6, 0.2, 0.2,    // 1 as 0
+            0.1, 0.25, 0.65,  // 2 as 2
+            0.1, 0.44, 0.46,  // 2 as 2
+            0.34, 0.33, 0.33  // 0 as 0
+        });
+
+    TTensorPtr l_targets = Tensor::New({5, 3},
+        {
+            1, 0, 0,
+            0, 1, 0,
+            0, 0, 1,
+            0, 0, 1,
+            1, 0, 0
+        });
+
+    metrics::ConfusionMatrix l_matrix(3);
+    l_matrix.AddResults(l_outputs, l_targets);
+
+    EXPECT_EQ(5, l_matrix.NumExamples());
+    EXPECT_EQ(2, l_matrix.Count(0, 0));
+    EXPECT_EQ(1, l_matrix.Count(1, 0));
+    EXPECT_EQ(0, l_matrix.Count(1, 1));
+    EXPECT_EQ(2, l_matrix.Count(2, 2));
+    EXPECT_NEAR(0.545, l_matrix.MeanConfidence(0, 0), 0.0001);
+    EXPECT_NEAR(0.6, l_matrix.MeanConfidence(1, 0), 0.0001);
+
+    // class 0: 2 of 3 predicted 0 are right, both real 0s were found
+    EXPECT_NEAR(2.0 / 3.0, l_matrix.Precision(0), 0.0001);
+    EXPECT_NEAR(1.0, l_matrix.Recall(0), 0.0001);
+    EXPECT_NEAR(0.8, l_matrix.F1(0), 0.0001);
+
+    // class 1 was never predicted
+    EXPECT_NEAR(0.0, l_matrix.Precision(1), 0.0001);
+    EXPECT_NEAR(0.0, l_matrix.Recall(1), 0.0001);
+    EXPECT_NEAR(0.0, l_matrix.F1(1), 0.0001);
+
+    EXPECT_NEAR(1.0, l_matrix.F1(2), 0.0001);
+
+    EXPECT_NEAR((2.0 / 3.0 + 0.0 + 1.0) / 3.0, l_matrix.MacroPrecision(), 0.0001);
+    EXPECT_NEAR((1.0 + 0.0 + 1.0) / 3.0, l_matrix.MacroRecall(), 0.0001);
+    EXPECT_NEAR((0.8 + 0.0 + 1.0) / 3.0, l_matrix.MacroF1(), 0.0001);
+
+    // 4 of 5 right
+    EXPECT_NEAR(0.8, l_matrix.MicroPrecision(), 0.0001);
+    EXPECT_NEAR(0.8, l_matrix.MicroRecall(), 0.0001);
+    EXPECT_NEAR(0.8, l_matrix.MicroF1(), 0.0001);
+
+    // merging doubles the counts but not the ratios
+    metrics::ConfusionMatrix l_merged(3);
+    l_merged.Merge(l_matrix);
+    l_merged.Merge(l_matrix);
+    EXPECT_EQ(4, l_merged.Count(0, 0));
+    EXPECT_NEAR(l_matrix.MacroF1(), l_merged.MacroF1(), 0.0001);
+
+    EXPECT_THROW(l_matrix.Count(3, 0), runtime_error);
+    EXPECT_THROW(l_matrix.AddResults(Tensor::New({1, 2}), Tensor::New({1, 2})), runtime_error);
+}
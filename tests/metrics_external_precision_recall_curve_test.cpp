@@ -0,0 +1,103 @@
+/*
+ * External Precision Recall Curve Test
+ *
+ */
+
+#include "neural/metrics/external_precision_recall_curve.h"
+#include "neural/metrics/precision_recall_curve.h"
+#include "neural/metrics/area_under_curve.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace neural;
+using namespace std;
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(StatsTest, TestMetricsExternalCurveMatchesInMemory)
+{
+    mt19937 l_random(23);
+    uniform_int_distribution<int> l_level(0, 200);
+    uniform_real_distribution<float> l_unit(0.0f, 1.0f);
+
+    // few distinct confidences so groups straddle runs
+    vector<metrics::PredictionRecord> l_records(5000);
+    for (metrics::PredictionRecord& l_record : l_records)
+    {
+        l_record.prediction = 0;
+        l_record.confidence = l_level(l_random) / 200.0f;
+        l_record.target = (l_unit(l_random) < l_record.confidence) ? 0 : 1;
+    }
+
+    // 256 bytes buffers 16 results, so hundreds of runs get merged in passes
+    metrics::ExternalPrecisionRecallCurve l_external(256);
+    metrics::TRecordAccumulatorPtr l_accumulator = metrics::RecordAccumulator::New();
+    for (size_t i = 0; i < l_records.size(); i += 100)
+    {
+        l_external.Add(&l_records[i], 100);
+        l_accumulator->Add(&l_records[i], 100);
+    }
+    EXPECT_EQ(5000, l_external.NumExamples());
+    EXPECT_LT(100, l_external.NumRuns());
+
+    metrics::PrecisionRecallCurve l_curve(l_accumulator);
+    vector<metrics::CurvePoint> l_expected = l_curve.Points();
+
+    // streamed most confident first
+    vector<metrics::CurvePoint> l_points;
+    l_external.ForEachPoint([&l_points](const metrics::CurvePoint& a_point)
+    {
+        l_points.push_back(a_point);
+    });
+    ASSERT_EQ(l_expected.size(), l_points.size());
+    for (size_t i = 0; i < l_points.size(); ++i)
+    {
+        const metrics::CurvePoint& l_point = l_points.at(l_points.size() - 1 - i);
+        EXPECT_EQ(l_expected.at(i).threshold, l_point.threshold);
+        EXPECT_NEAR(l_expected.at(i).precision, l_point.precision, 0.0001);
+        EXPECT_NEAR(l_expected.at(i).recall, l_point.recall, 0.0001);
+    }
+
+    // cutoffs on, between, above and below the confidences
+    vector<float> l_cutoffs = {0.5, -1.0, 0.2525, 0.25, 2.0, 0.9};
+    vector<metrics::CurvePoint> l_expectedAt = l_curve.Points(l_cutoffs);
+    vector<metrics::CurvePoint> l_pointsAt = l_external.Points(l_cutoffs);
+    ASSERT_EQ(l_cutoffs.size(), l_pointsAt.size());
+    for (size_t i = 0; i < l_cutoffs.size(); ++i)
+    {
+        EXPECT_EQ(l_cutoffs.at(i), l_pointsAt.at(i).threshold);
+        EXPECT_NEAR(l_expectedAt.at(i).precision, l_pointsAt.at(i).precision, 0.0001);
+        EXPECT_NEAR(l_expectedAt.at(i).recall, l_pointsAt.at(i).recall, 0.0001);
+    }
+
+    metrics::AreaUnderCurve l_auc(l_accumulator);
+    EXPECT_NEAR(l_auc.AveragePrecision(), l_external.AveragePrecision(), 0.0001);
+    EXPECT_NEAR(l_auc.RocAuc(), l_external.RocAuc(), 0.0001);
+
+    // more results after a query keep merging with the old runs
+    l_external.Add(l_records.data(), 1000);
+    l_accumulator->Add(l_records.data(), 1000);
+    EXPECT_NEAR(l_auc.AveragePrecision(), l_external.AveragePrecision(), 0.0001);
+
+    // what is still buffered is merged from memory, queries never spill
+    size_t l_numRuns = l_external.NumRuns();
+    l_external.Points(l_cutoffs);
+    l_external.Points(l_cutoffs);
+    EXPECT_EQ(l_numRuns, l_external.NumRuns());
+}
+
+TEST(StatsTest, TestMetricsExternalCurveEmpty)
+{
+    metrics::ExternalPrecisionRecallCurve l_external;
+    size_t l_numPoints = 0;
+    l_external.ForEachPoint([&l_numPoints](const metrics::CurvePoint&) { ++l_numPoints; });
+    EXPECT_EQ(0, l_numPoints);
+    EXPECT_EQ(0.0f, l_external.AveragePrecision());
+    EXPECT_EQ(0.0f, l_external.RocAuc());
+    EXPECT_EQ(0.0f, l_external.Points({0.5}).at(0).precision);
+
+    metrics::ExternalPrecisionRecallCurve l_badDir(256, "/nonexistent/dir");
+    vector<metrics::PredictionRecord> l_records(100);
+    EXPECT_THROW(l_badDir.Add(l_records.data(), l_records.size()), std::runtime_error);
+}
@@ -0,0 +1,101 @@
+/*
+ * Top K and Multi Label Metrics Test
+ *
+ */
+
+#include "neural/metrics/precision.h"
+#include "neural/metrics/recall.h"
+#include "neural/metrics/accuracy.h"
+#include "neural/metrics/binned_precision_recall.h"
+
+#include <gtest/gtest.h>
+
+using namespace neural;
+using namespace std;
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(StatsTest, TestMetricsTopKAccuracy)
+{
+    TTensorPtr l_outputs = Tensor::New({4, 4},
+        {
+            0.7, 0.1, 0.1, 0.1,   // target is the argmax
+            0.5, 0.3, 0.1, 0.1,   // target is second
+            0.4, 0.3, 0.2, 0.1,   // target is third
+            0.25, 0.25, 0.25, 0.25 // target ties for first
+        });
+
+    TTensorPtr l_targets = Tensor::New({4, 4},
+        {
+            1, 0, 0, 0,
+            0, 1, 0, 0,
+            0, 0, 1, 0,
+            0, 0, 0, 1
+        });
+
+    metrics::Accuracy l_top1;
+    metrics::Accuracy l_top2;
+    metrics::Accuracy l_top3;
+    l_top2.SetTopK(2);
+    l_top3.SetTopK(3);
+    l_top1.AddResults(l_outputs, l_targets);
+    l_top2.AddResults(l_outputs, l_targets);
+    l_top3.AddResults(l_outputs, l_targets);
+
+    // top 1 is the plain argmax, so the tie goes to the first column
+    EXPECT_NEAR(0.25, l_top1.Calculate(), 0.0001);
+    EXPECT_NEAR(0.75, l_top2.Calculate(), 0.0001);
+    EXPECT_NEAR(1.0, l_top3.Calculate(), 0.0001);
+
+    // the confidence is still the largest output
+    metrics::Precision l_precision;
+    l_precision.SetTopK(2);
+    l_precision.AddResults(l_outputs, l_targets);
+    EXPECT_NEAR(1.0, l_precision.Calculate(0.45), 0.0001);
+    EXPECT_NEAR(0.6667, l_precision.Calculate(0.3), 0.0001);
+
+    // results have already been counted the other way
+    EXPECT_THROW(l_top1.SetTopK(2), std::runtime_error);
+    metrics::Accuracy l_zero;
+    EXPECT_THROW(l_zero.SetTopK(0), std::runtime_error);
+}
+
+TEST(StatsTest, TestMetricsMultiLabel)
+{
+    TTensorPtr l_outputs = Tensor::New({3, 3},
+        {
+            0.9, 0.8, 0.1,
+            0.2, 0.7, 0.6,
+            0.4, 0.3, 0.95
+        });
+
+    TTensorPtr l_targets = Tensor::New({3, 3},
+        {
+            1, 1, 0,
+            0, 0, 1,
+            1, 0, 1
+        });
+
+    metrics::TBinnedPrecisionRecallPtr l_binned = metrics::BinnedPrecisionRecall::New(100);
+    metrics::Precision l_precision;
+    metrics::Recall l_recall(l_binned);
+    metrics::Accuracy l_accuracy;
+    l_precision.SetMultiLabel(true);
+    l_recall.SetMultiLabel(true);
+    l_accuracy.SetMultiLabel(true);
+    l_precision.AddResults(l_outputs, l_targets);
+    l_recall.AddResults(l_outputs, l_targets);
+    l_accuracy.AddResults(l_outputs, l_targets);
+    EXPECT_EQ(9, l_precision.NumExamples());
+
+    // @0.5: tp = 0.9, 0.8, 0.6, 0.95  fp = 0.7  fn = 0.4  tn = 0.1, 0.2, 0.3
+    EXPECT_NEAR(0.8, l_precision.Calculate(0.5), 0.0001);
+    EXPECT_NEAR(0.8, l_recall.Calculate(0.5), 0.0001);
+    EXPECT_NEAR(0.7778, l_accuracy.Calculate(0.5), 0.0001);
+
+    // label 2 on its own: 0.6 and 0.95 are positive, 0.1 is not
+    metrics::ConfusionCounts l_label2 = l_binned->CalcConfusionCounts(0.5, 2);
+    EXPECT_EQ(2, l_label2.truePositives);
+    EXPECT_EQ(0, l_label2.falsePositives);
+    EXPECT_EQ(1, l_label2.trueNegatives);
+    EXPECT_EQ(0, l_label2.falseNegatives);
+}
@@ -0,0 +1,173 @@
+/*
+ * Precision Recall Curve Test
+ *
+ */
+
+#include "neural/metrics/precision_recall_curve.h"
+#include "neural/metrics/precision.h"
+#include "neural/metrics/recall.h"
+
+#include <gtest/gtest.h>
+
+using namespace neural;
+using namespace std;
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(StatsTest, TestMetricsPrecisionRecallCurveMatchesMetrics)
+{
+    TTensorPtr l_outputs = Tensor::New({5, 3},
+        {
+            0.75, 0.15, 0.1,
+            0.6, 0.2, 0.2,
+            0.1, 0.25, 0.65,
+            0.1, 0.44, 0.46,
+            0.34, 0.33, 0.33
+        });
+
+    TTensorPtr l_targets = Tensor::New({5, 3},
+        {
+            1, 0, 0,
+            0, 1, 0,
+            0, 0, 1,
+            0, 0, 1,
+            1, 0, 0
+        });
+
+    metrics::PrecisionRecallCurve l_curve;
+    metrics::Precision l_precision;
+    metrics::Recall l_recall;
+    l_curve.AddResults(l_outputs, l_targets);
+    l_precision.AddResults(l_outputs, l_targets);
+    l_recall.AddResults(l_outputs, l_targets);
+
+    // include cutoffs that land exactly on a confidence
+    vector<float> l_cutoffs = {0.0, 0.1, 0.34, 0.5, 0.6, 0.7, 0.75, 0.9};
+    vector<metrics::CurvePoint> l_points = l_curve.Points(l_cutoffs);
+    ASSERT_EQ(l_cutoffs.size(), l_points.size());
+    for (size_t i = 0; i < l_cutoffs.size(); ++i)
+    {
+        EXPECT_EQ(l_cutoffs.at(i), l_points.at(i).threshold);
+        EXPECT_NEAR(l_precision.Calculate(l_cutoffs.at(i)), l_points.at(i).precision, 0.0001);
+        EXPECT_NEAR(l_recall.Calculate(l_cutoffs.at(i)), l_points.at(i).recall, 0.0001);
+    }
+}
+
+TEST(StatsTest, TestMetricsPrecisionRecallCurveDistinctThresholds)
+{
+    TTensorPtr l_outputs = Tensor::New({4, 2},
+        {
+            0.9, 0.1, // correct
+            0.6, 0.4, // correct
+            0.4, 0.6, // incorrect
+            0.6, 0.4  // incorrect
+        });
+
+    TTensorPtr l_targets = Tensor::New({4, 2},
+        {
+            1, 0,
+            1, 0,
+            1, 0,
+            0, 1
+        });
+
+    metrics::PrecisionRecallCurve l_curve;
+    l_curve.AddResults(l_outputs, l_targets);
+
+    // 0.6 shows up three times, so there are only 2 distinct thresholds
+    vector<metrics::CurvePoint> l_points = l_curve.Points();
+    ASSERT_EQ(2, l_points.size());
+
+    // @0.6 only the 0.9 example is over the cutoff, the rest are equal
+    EXPECT_NEAR(0.6, l_points.at(0).threshold, 0.0001);
+    EXPECT_NEAR(1.0, l_points.at(0).precision, 0.0001);
+    EXPECT_NEAR(1.0, l_points.at(0).recall, 0.0001);
+
+    // @0.9 nothing is over the cutoff, both correct ones are under it
+    EXPECT_NEAR(0.9, l_points.at(1).threshold, 0.0001);
+    EXPECT_NEAR(0.0, l_points.at(1).precision, 0.0001);
+    EXPECT_NEAR(0.0, l_points.at(1).recall, 0.0001);
+
+    // new results invalidate the sorted index
+    TTensorPtr l_moreOutputs = Tensor::New({1, 2}, {0.95, 0.05});
+    TTensorPtr l_moreTargets = Tensor::New({1, 2}, {0, 1});
+    l_curve.AddResults(l_moreOutputs, l_moreTargets);
+
+    l_points = l_curve.Points({0.5});
+    // 2 correct and 3 incorrect over 0.5
+    EXPECT_NEAR(0.4, l_points.at(0).precision, 0.0001);
+    EXPECT_NEAR(1.0, l_points.at(0).recall, 0.0001);
+    EXPECT_NEAR(0.571, l_curve.Calculate(0.5), 0.001);
+}
+
+TEST(StatsTest, TestMetricsPrecisionRecallCurveThresholdSearch)
+{
+    TTensorPtr l_outputs = Tensor::New({5, 3},
+        {
+            0.9, 0.05, 0.05, // correct
+            0.8, 0.1, 0.1,   // incorrect
+            0.7, 0.15, 0.15, // correct
+            0.6, 0.2, 0.2,   // correct
+            0.5, 0.25, 0.25  // incorrect
+        });
+
+    TTensorPtr l_targets = Tensor::New({5, 3},
+        {
+            1, 0, 0,
+            0, 1, 0,
+            1, 0, 0,
+            1, 0, 0,
+            0, 0, 1
+        });
+
+    metrics::PrecisionRecallCurve l_curve;
+    l_curve.AddResults(l_outputs, l_targets);
+
+    // just under 0.6 has 3/4 precision with all the recall
+    metrics::CurvePoint l_point;
+    ASSERT_TRUE(l_curve.ThresholdAtPrecision(0.7, l_point));
+    EXPECT_LT(l_point.threshold, 0.6);
+    EXPECT_GT(l_point.threshold, 0.5);
+    EXPECT_NEAR(0.75, l_point.precision, 0.0001);
+    EXPECT_NEAR(1.0, l_point.recall, 0.0001);
+
+    // precision dips under 0.8, only the 0.9 example is perfect
+    ASSERT_TRUE(l_curve.ThresholdAtPrecision(0.9, l_point));
+    EXPECT_LT(l_point.threshold, 0.9);
+    EXPECT_GT(l_point.threshold, 0.8);
+    EXPECT_NEAR(1.0, l_point.precision, 0.0001);
+    EXPECT_NEAR(0.3333, l_point.recall, 0.0001);
+    EXPECT_FALSE(l_curve.ThresholdAtPrecision(1.01, l_point));
+
+    ASSERT_TRUE(l_curve.ThresholdAtRecall(0.6, l_point));
+    EXPECT_LT(l_point.threshold, 0.7);
+    EXPECT_GT(l_point.threshold, 0.6);
+    EXPECT_NEAR(0.6667, l_point.precision, 0.0001);
+    EXPECT_NEAR(0.6667, l_point.recall, 0.0001);
+
+    ASSERT_TRUE(l_curve.ThresholdAtRecall(1.0, l_point));
+    EXPECT_NEAR(0.75, l_point.precision, 0.0001);
+
+    // f1 peaks with all the recall, a small beta wants the precision
+    ASSERT_TRUE(l_curve.MaxFBetaThreshold(1.0, l_point));
+    EXPECT_NEAR(0.75, l_point.precision, 0.0001);
+    EXPECT_NEAR(1.0, l_point.recall, 0.0001);
+    ASSERT_TRUE(l_curve.MaxFBetaThreshold(0.1, l_point));
+    EXPECT_NEAR(1.0, l_point.precision, 0.0001);
+    EXPECT_NEAR(0.3333, l_point.recall, 0.0001);
+
+    // new results invalidate the remembered answers, a confident mistake
+    // means the 0.9 example alone is no longer worth it
+    l_curve.AddResults(
+        Tensor::New({1, 3}, {0.95, 0.03, 0.02}),
+        Tensor::New({1, 3}, {0, 1, 0}));
+    ASSERT_TRUE(l_curve.MaxFBetaThreshold(0.1, l_point));
+    EXPECT_NEAR(0.6, l_point.precision, 0.0001);
+    EXPECT_NEAR(1.0, l_point.recall, 0.0001);
+    EXPECT_LT(l_point.threshold, 0.6);
+    EXPECT_GT(l_point.threshold, 0.5);
+
+    metrics::PrecisionRecallCurve l_empty;
+    EXPECT_FALSE(l_empty.ThresholdAtPrecision(0.5, l_point));
+    EXPECT_FALSE(l_empty.ThresholdAtRecall(0.5, l_point));
+    EXPECT_FALSE(l_empty.MaxFBetaThreshold(1.0, l_point));
+}
@@ -4,6 +4,7 @@
  */
 
 #include "neural/metrics/precision.h"
+#include "neural/metrics/record_accumulator.h"
 
 #include <gtest/gtest.h>
 
@@ -93,3 +94,58 @@ TEST(StatsTest, TestMetricsPrecisionLowCutoff)
 
     EXPECT_NEAR(0.8, l_precision.Calculate(0.1), 0.001);
 }
+
+TEST(StatsTest, TestMetricsPrecisionTrackedCutoffWindow)
+{
+    TTensorPtr l_outputs = Tensor::New({5, 3},
+        {
+            0.75, 0.15, 0.1,
+            0.6, 0.2, 0.2,
+            0.1, 0.25, 0.65,
+            0.1, 0.44, 0.46,
+            0.34, 0.33, 0.33
+        });
+
+    TTensorPtr l_targets = Tensor::New({5, 3},
+        {
+            1, 0, 0,
+            0, 1, 0,
+            0, 0, 1,
+            0, 0, 1,
+            1, 0, 0
+        });
+
+    // keep 7 examples so the window wraps part way through the second batch
+    metrics::TRecordAccumulatorPtr l_window = metrics::RecordAccumulator::New(7);
+    metrics::Precision l_tracked(l_window);
+    l_tracked.TrackCutoff(0.1);
+    l_tracked.TrackCutoff(0.6);
+    l_tracked.AddResults(l_outputs, l_targets);
+
+    // tracking after results are in starts from the current window
+    l_tracked.TrackCutoff(0.4);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        l_tracked.AddResults(l_outputs, l_targets);
+
+        // an untracked metric over the same window scans every time
+        metrics::Precision l_scanned;
+        vector<metrics::PredictionRecord> l_records = l_window->Records();
+        ASSERT_EQ(7, l_records.size());
+
+        TMutableTensorPtr l_windowOutputs = Tensor::Zeros({7, 3});
+        TMutableTensorPtr l_windowTargets = Tensor::Zeros({7, 3});
+        for (size_t j = 0; j < l_records.size(); ++j)
+        {
+            l_windowOutputs->SetAt({j, l_records.at(j).prediction}, l_records.at(j).confidence);
+            l_windowTargets->SetAt({j, l_records.at(j).target}, 1.0);
+        }
+        l_scanned.AddResults(l_windowOutputs, l_windowTargets);
+
+        for (float l_cutoff : {0.1f, 0.4f, 0.5f, 0.6f})
+        {
+            EXPECT_NEAR(l_scanned.Calculate(l_cutoff), l_tracked.Calculate(l_cutoff), 0.0001);
+        }
+    }
+}
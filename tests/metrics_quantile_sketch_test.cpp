@@ -0,0 +1,175 @@
+/*
+ * Quantile Sketch Accumulator Test
+ *
+ */
+
+#include "neural/metrics/quantile_sketch_accumulator.h"
+#include "neural/metrics/record_accumulator.h"
+#include "neural/metrics/precision.h"
+#include "neural/metrics/recall.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <sstream>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+// Confidence leans higher for correct predictions
+vector<metrics::PredictionRecord> SketchTestRecords(size_t a_numRecords, unsigned a_seed)
+{
+    mt19937 l_random(a_seed);
+    uniform_real_distribution<float> l_unit(0.0f, 1.0f);
+
+    vector<metrics::PredictionRecord> l_records(a_numRecords);
+    for (metrics::PredictionRecord& l_record : l_records)
+    {
+        l_record.prediction = 1;
+        l_record.confidence = l_unit(l_random);
+        l_record.target = (l_unit(l_random) < l_record.confidence) ? 1 : 0;
+    }
+    return l_records;
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(StatsTest, TestMetricsQuantileSketchExactWhenSmall)
+{
+    TTensorPtr l_outputs = Tensor::New({5, 3},
+        {
+            0.75, 0.15, 0.1,
+            0.6, 0.2, 0.2,
+            0.1, 0.25, 0.65,
+            0.1, 0.44, 0.46,
+            0.34, 0.33, 0.33
+        });
+
+    TTensorPtr l_targets = Tensor::New({5, 3},
+        {
+            1, 0, 0,
+            0, 1, 0,
+            0, 0, 1,
+            0, 0, 1,
+            1, 0, 0
+        });
+
+    metrics::TQuantileSketchAccumulatorPtr l_sketch = metrics::QuantileSketchAccumulator::New();
+    metrics::Precision l_sketchPrecision(l_sketch);
+    metrics::Recall l_sketchRecall(l_sketch);
+    metrics::Precision l_precision;
+    metrics::Recall l_recall;
+    l_sketchPrecision.AddResults(l_outputs, l_targets);
+    l_precision.AddResults(l_outputs, l_targets);
+    l_recall.AddResults(l_outputs, l_targets);
+    EXPECT_EQ(5, l_sketch->NumExamples());
+
+    // nothing has been compacted yet so every count is exact
+    for (float l_cutoff : {0.0f, 0.34f, 0.5f, 0.6f, 0.65f, 0.75f, 1.0f})
+    {
+        EXPECT_NEAR(l_precision.Calculate(l_cutoff), l_sketchPrecision.Calculate(l_cutoff), 0.0001);
+        EXPECT_NEAR(l_recall.Calculate(l_cutoff), l_sketchRecall.Calculate(l_cutoff), 0.0001);
+    }
+
+    // correct confidences are 0.34, 0.46, 0.65, 0.75
+    float l_threshold = l_sketch->ThresholdForRecall(0.5);
+    EXPECT_LT(l_threshold, 0.65);
+    EXPECT_GT(l_threshold, 0.6);
+    EXPECT_NEAR(0.5, l_sketchRecall.Calculate(l_threshold), 0.0001);
+}
+
+TEST(StatsTest, TestMetricsQuantileSketchBoundedError)
+{
+    vector<metrics::PredictionRecord> l_records = SketchTestRecords(200000, 3);
+
+    metrics::TQuantileSketchAccumulatorPtr l_sketch = metrics::QuantileSketchAccumulator::New();
+    metrics::TRecordAccumulatorPtr l_exact = metrics::RecordAccumulator::New();
+    l_sketch->Add(l_records.data(), l_records.size());
+    l_exact->Add(l_records.data(), l_records.size());
+
+    // a few hundred values per sketch stand in for 200k examples
+    EXPECT_EQ(200000, l_sketch->NumExamples());
+    EXPECT_LT(l_sketch->NumRetained(), 2000);
+
+    metrics::Precision l_sketchPrecision(l_sketch);
+    metrics::Recall l_sketchRecall(l_sketch);
+    metrics::Precision l_precision(l_exact);
+    metrics::Recall l_recall(l_exact);
+    for (float l_cutoff : {0.1f, 0.25f, 0.5f, 0.75f, 0.9f})
+    {
+        EXPECT_NEAR(l_precision.Calculate(l_cutoff), l_sketchPrecision.Calculate(l_cutoff), 0.02);
+        EXPECT_NEAR(l_recall.Calculate(l_cutoff), l_sketchRecall.Calculate(l_cutoff), 0.02);
+    }
+
+    for (float l_target : {0.25f, 0.5f, 0.9f, 1.0f})
+    {
+        float l_threshold = l_sketch->ThresholdForRecall(l_target);
+        EXPECT_NEAR(l_target, l_recall.Calculate(l_threshold), 0.02);
+    }
+}
+
+TEST(StatsTest, TestMetricsQuantileSketchMergeAndSerialize)
+{
+    vector<metrics::PredictionRecord> l_records = SketchTestRecords(60000, 5);
+
+    // every worker sketches its own slice of the stream
+    metrics::TQuantileSketchAccumulatorPtr l_merged = metrics::QuantileSketchAccumulator::New();
+    metrics::TRecordAccumulatorPtr l_exact = metrics::RecordAccumulator::New();
+    for (size_t i = 0; i < 4; ++i)
+    {
+        size_t l_begin = (l_records.size() * i) / 4;
+        size_t l_end = (l_records.size() * (i + 1)) / 4;
+
+        metrics::QuantileSketchAccumulator l_worker;
+        l_worker.Add(&l_records[l_begin], l_end - l_begin);
+        stringstream l_stream;
+        l_worker.Serialize(l_stream);
+        l_merged->Merge(*metrics::Accumulator::Load(l_stream));
+    }
+    l_exact->Add(l_records.data(), l_records.size());
+    EXPECT_EQ(60000, l_merged->NumExamples());
+
+    metrics::Precision l_mergedPrecision(l_merged);
+    metrics::Recall l_mergedRecall(l_merged);
+    metrics::Precision l_precision(l_exact);
+    metrics::Recall l_recall(l_exact);
+    for (float l_cutoff : {0.1f, 0.5f, 0.9f})
+    {
+        EXPECT_NEAR(l_precision.Calculate(l_cutoff), l_mergedPrecision.Calculate(l_cutoff), 0.02);
+        EXPECT_NEAR(l_recall.Calculate(l_cutoff), l_mergedRecall.Calculate(l_cutoff), 0.02);
+    }
+
+    // sketches of different sizes do not line up
+    metrics::QuantileSketchAccumulator l_small(50);
+    EXPECT_THROW(l_merged->Merge(l_small), std::runtime_error);
+}
+
+TEST(StatsTest, TestMetricsQuantileSketchCorruptStream)
+{
+    metrics::QuantileSketchAccumulator l_sketch;
+    vector<metrics::PredictionRecord> l_records = SketchTestRecords(3, 6);
+    l_sketch.Add(l_records.data(), l_records.size());
+    stringstream l_stream;
+    l_sketch.Serialize(l_stream);
+    string l_state = l_stream.str();
+
+    // after the header and k the first sketch is its count, its number
+    // of levels and the size of level 0, each 8 bytes
+    size_t l_numLevelsAt = 40;
+    size_t l_levelSizeAt = 48;
+    for (size_t l_at : {l_numLevelsAt, l_levelSizeAt})
+    {
+        string l_corrupt = l_state;
+        l_corrupt.replace(l_at, 8, 8, '\xff');
+        stringstream l_corruptStream(l_corrupt);
+        EXPECT_THROW(metrics::Accumulator::Load(l_corruptStream), std::runtime_error);
+    }
+
+    // and a sane stream still loads
+    stringstream l_goodStream(l_state);
+    EXPECT_EQ(3, metrics::Accumulator::Load(l_goodStream)->NumExamples());
+}
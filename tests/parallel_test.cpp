@@ -0,0 +1,49 @@
+/*
+ * Parallel Helpers Test
+ *
+ */
+
+#include "neural/util/parallel.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace neural;
+using namespace std;
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(ParallelTest, TestChunkBounds)
+{
+    vector<size_t> l_bounds = Parallel::ChunkBounds(10, 3);
+    ASSERT_EQ(4, l_bounds.size());
+    EXPECT_EQ(0, l_bounds.at(0));
+    EXPECT_EQ(4, l_bounds.at(1));
+    EXPECT_EQ(7, l_bounds.at(2));
+    EXPECT_EQ(10, l_bounds.at(3));
+
+    // more chunks than items leaves some empty
+    l_bounds = Parallel::ChunkBounds(2, 4);
+    ASSERT_EQ(5, l_bounds.size());
+    EXPECT_EQ(2, l_bounds.at(4));
+}
+
+TEST(ParallelTest, TestSortMatchesStdSort)
+{
+    mt19937 l_random(11);
+    uniform_int_distribution<int> l_value(0, 1000);
+
+    for (size_t l_size : {0, 1, 17, 4096, 50001})
+    {
+        vector<int> l_data(l_size);
+        for (int& l_item : l_data)
+        {
+            l_item = l_value(l_random);
+        }
+
+        vector<int> l_expected(l_data);
+        std::sort(l_expected.begin(), l_expected.end(), std::greater<int>());
+        Parallel::Sort(l_data, std::greater<int>());
+        EXPECT_EQ(l_expected, l_data);
+    }
+}
@@ -0,0 +1,125 @@
+/*
+ * Prediction Log Test
+ *
+ */
+
+#include "neural/data/prediction_log.h"
+#include "neural/metrics/metric.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+string TempLogPath()
+{
+    char l_path[] = "/tmp/neural_prediction_log_XXXXXX";
+    int l_fd = mkstemp(l_path);
+    close(l_fd);
+    return l_path;
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(PredictionLogTest, TestRoundTrip)
+{
+    TTensorPtr l_outputs = Tensor::New({3, 3},
+        {
+            0.75, 0.15, 0.1,
+            0.1, 0.25, 0.65,
+            // NaN is skipped, as it is by the metrics
+            numeric_limits<float>::quiet_NaN(), 0.33, 0.34
+        });
+
+    TTensorPtr l_targets = Tensor::New({3, 3},
+        {
+            1, 0, 0,
+            0, 1, 0,
+            0, 0, 1
+        });
+
+    string l_path = TempLogPath();
+    {
+        PredictionLogWriter l_writer(l_path, 3);
+        l_writer.Append(l_outputs, l_targets);
+        float l_row[3] = {0.2, 0.5, 0.3};
+        l_writer.Append(l_row, 2);
+        EXPECT_EQ(4, l_writer.NumRows());
+    }
+
+    PredictionLog l_log(l_path);
+    EXPECT_EQ(3, l_log.NumCols());
+    EXPECT_EQ(4, l_log.NumRows());
+    EXPECT_EQ(1, l_log.Label(1));
+    EXPECT_EQ(2, l_log.Label(3));
+    EXPECT_EQ(0.65f, l_log.Outputs(1)[2]);
+    EXPECT_EQ(0.5f, l_log.Outputs(3)[1]);
+
+    // same records the metrics would have made from the tensors
+    vector<metrics::PredictionRecord> l_expected;
+    metrics::Metric::ReduceRows(l_outputs, l_targets, l_expected);
+    vector<metrics::PredictionRecord> l_records;
+    l_log.ReduceRows(0, 3, l_records);
+    ASSERT_EQ(3, l_records.size());
+    for (size_t i = 0; i < l_records.size(); ++i)
+    {
+        EXPECT_EQ(l_expected.at(i).target, l_records.at(i).target);
+        EXPECT_EQ(l_expected.at(i).prediction, l_records.at(i).prediction);
+        EXPECT_EQ(l_expected.at(i).confidence, l_records.at(i).confidence);
+    }
+    EXPECT_EQ(2, l_records.at(2).prediction);
+
+    l_log.ReduceRows(3, 4, l_records);
+    ASSERT_EQ(1, l_records.size());
+    EXPECT_EQ(1, l_records.at(0).prediction);
+    EXPECT_THROW(l_log.ReduceRows(2, 5, l_records), std::runtime_error);
+
+    unlink(l_path.c_str());
+}
+
+TEST(PredictionLogTest, TestMalformedLogs)
+{
+    EXPECT_THROW(PredictionLog("/tmp/neural_prediction_log_missing"), std::runtime_error);
+
+    // a log cut off part way through a row
+    string l_path = TempLogPath();
+    {
+        PredictionLogWriter l_writer(l_path, 2);
+        float l_row[2] = {0.4, 0.6};
+        l_writer.Append(l_row, 1);
+    }
+    {
+        ofstream l_stream(l_path.c_str(), ios::binary | ios::app);
+        l_stream.write("xx", 2);
+    }
+    EXPECT_THROW(PredictionLog l_log(l_path), std::runtime_error);
+
+    // not a log at all
+    {
+        ofstream l_stream(l_path.c_str(), ios::binary | ios::trunc);
+        l_stream << "definitely not a prediction log";
+    }
+    EXPECT_THROW(PredictionLog l_log(l_path), std::runtime_error);
+
+    // labels have to be one of the columns
+    {
+        PredictionLogWriter l_writer(l_path, 2);
+        float l_row[2] = {0.4, 0.6};
+        l_writer.Append(l_row, 7);
+    }
+    PredictionLog l_log(l_path);
+    vector<metrics::PredictionRecord> l_records;
+    EXPECT_THROW(l_log.ReduceRows(0, 1, l_records), std::runtime_error);
+
+    EXPECT_THROW(PredictionLogWriter(l_path, 0), std::runtime_error);
+    unlink(l_path.c_str());
+}
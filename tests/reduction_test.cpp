@@ -0,0 +1,172 @@
+/*
+ * Reduction Test
+ *
+ */
+
+#include "neural/math/reduction.h"
+#include "neural/math/elementwise.h"
+#include "neural/math/tensor_math.h"
+#include "isa_test_util.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+vector<float> RandomValues(size_t a_size, unsigned a_seed)
+{
+    mt19937 l_random(a_seed);
+    uniform_real_distribution<float> l_value(-20.0, 5.0);
+    vector<float> l_values(a_size);
+    for (float& l_item : l_values)
+    {
+        l_item = l_value(l_random);
+    }
+    return l_values;
+}
+
+double ExpectedLogSumExp(const float* a_in, size_t a_size)
+{
+    double l_sum = 0.0;
+    for (size_t i = 0; i < a_size; ++i)
+    {
+        l_sum += std::exp((double)a_in[i]);
+    }
+    return std::log(l_sum);
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(ReductionTest, TestRunsMatchReferenceOnEveryIsa)
+{
+    for (Elementwise::Isa l_isa : SupportedIsas())
+    {
+        ScopedIsa l_scopedIsa(l_isa);
+
+        // sizes on and off the 8, 16, 32 and 64 wide loops
+        for (size_t l_size : {1, 7, 8, 15, 16, 17, 33, 65, 100, 1000})
+        {
+            vector<float> l_values = RandomValues(l_size, (unsigned)l_size);
+            // the max shows up twice, argmax wants the first
+            size_t l_expectedIdx = l_size / 2;
+            l_values[l_expectedIdx] = 7.0;
+            if (l_size > 3)
+            {
+                l_values[l_size - 2] = 7.0;
+            }
+
+            double l_sum = 0.0;
+            for (float l_value : l_values)
+            {
+                l_sum += l_value;
+            }
+
+            EXPECT_EQ(7.0, Reduction::Max(l_values.data(), l_size)) << Elementwise::IsaName(l_isa);
+            EXPECT_EQ(l_expectedIdx, Reduction::ArgMax(l_values.data(), l_size)) << Elementwise::IsaName(l_isa);
+            EXPECT_NEAR(l_sum, Reduction::Sum(l_values.data(), l_size), std::fabs(l_sum) * 1e-6 + 1e-4) << Elementwise::IsaName(l_isa);
+            EXPECT_NEAR(l_sum / l_size, Reduction::Mean(l_values.data(), l_size), 1e-5) << Elementwise::IsaName(l_isa);
+            EXPECT_NEAR(ExpectedLogSumExp(l_values.data(), l_size),
+                        Reduction::LogSumExp(l_values.data(), l_size), 1e-5) << Elementwise::IsaName(l_isa);
+        }
+    }
+}
+
+TEST(ReductionTest, TestNegativeAndNaN)
+{
+    const float l_nan = numeric_limits<float>::quiet_NaN();
+    const float l_inf = numeric_limits<float>::infinity();
+
+    for (Elementwise::Isa l_isa : SupportedIsas())
+    {
+        ScopedIsa l_scopedIsa(l_isa);
+
+        // all negative, the max is not 0
+        vector<float> l_negative = {-3.0, -2.0, -5.0, -2.5, -9.0, -8.0, -7.0, -6.0, -4.0};
+        EXPECT_EQ(-2.0, Reduction::Max(l_negative.data(), l_negative.size()));
+        EXPECT_EQ(1u, Reduction::ArgMax(l_negative.data(), l_negative.size()));
+
+        // NaN is skipped by max and argmax, carried by sum and log-sum-exp
+        vector<float> l_withNaN = {l_nan, 1.0, 2.0, l_nan, 0.5, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        EXPECT_EQ(2.0, Reduction::Max(l_withNaN.data(), l_withNaN.size()));
+        EXPECT_EQ(2u, Reduction::ArgMax(l_withNaN.data(), l_withNaN.size()));
+        EXPECT_TRUE(std::isnan(Reduction::Sum(l_withNaN.data(), l_withNaN.size())));
+        EXPECT_TRUE(std::isnan(Reduction::LogSumExp(l_withNaN.data(), l_withNaN.size())));
+
+        // nothing to pick from
+        vector<float> l_allNaN(10, l_nan);
+        EXPECT_EQ(-l_inf, Reduction::Max(l_allNaN.data(), l_allNaN.size()));
+        EXPECT_EQ(0u, Reduction::ArgMax(l_allNaN.data(), l_allNaN.size()));
+        EXPECT_EQ(-l_inf, Reduction::Max(nullptr, 0));
+        EXPECT_EQ(0.0, Reduction::Sum(nullptr, 0));
+
+        // large values do not overflow
+        vector<float> l_large = {1000.0, 1000.0};
+        EXPECT_NEAR(1000.0 + std::log(2.0), Reduction::LogSumExp(l_large.data(), 2), 1e-3);
+        vector<float> l_negInf = {-l_inf, -l_inf};
+        EXPECT_EQ(-l_inf, Reduction::LogSumExp(l_negInf.data(), 2));
+    }
+}
+
+TEST(ReductionTest, TestRowsAndCols)
+{
+    size_t l_rows = 5;
+    size_t l_cols = 37;
+    vector<float> l_values = RandomValues(l_rows * l_cols, 11);
+    TTensorPtr l_mat = Tensor::New({l_rows, l_cols}, l_values);
+
+    TMutableTensorPtr l_rowOut = Tensor::New({l_rows, 1});
+    TMutableTensorPtr l_colOut = Tensor::New({1, l_cols});
+    vector<size_t> l_rowIdxs;
+    vector<size_t> l_colIdxs;
+
+    for (ReduceOp l_op : {ReduceOp::MAX, ReduceOp::SUM, ReduceOp::MEAN, ReduceOp::LOG_SUM_EXP})
+    {
+        TensorMath::Reduce(l_op, 1, l_mat, l_rowOut);
+        for (size_t i = 0; i < l_rows; ++i)
+        {
+            EXPECT_NEAR(Reduction::Reduce(l_op, &l_values[i * l_cols], l_cols), l_rowOut->At({i, 0}), 1e-4);
+        }
+
+        TensorMath::Reduce(l_op, 0, l_mat, l_colOut);
+        for (size_t j = 0; j < l_cols; ++j)
+        {
+            vector<float> l_col;
+            for (size_t i = 0; i < l_rows; ++i)
+            {
+                l_col.push_back(l_values[(i * l_cols) + j]);
+            }
+            EXPECT_NEAR(Reduction::Reduce(l_op, l_col.data(), l_rows), l_colOut->At({0, j}), 1e-4);
+        }
+    }
+
+    TensorMath::ArgMax(1, l_mat, l_rowIdxs);
+    ASSERT_EQ(l_rows, l_rowIdxs.size());
+    for (size_t i = 0; i < l_rows; ++i)
+    {
+        EXPECT_EQ(Reduction::ArgMax(&l_values[i * l_cols], l_cols), l_rowIdxs[i]);
+    }
+
+    TensorMath::ArgMax(0, l_mat, l_colIdxs);
+    ASSERT_EQ(l_cols, l_colIdxs.size());
+    for (size_t j = 0; j < l_cols; ++j)
+    {
+        for (size_t i = 0; i < l_rows; ++i)
+        {
+            EXPECT_LE(l_values[(i * l_cols) + j], l_values[(l_colIdxs[j] * l_cols) + j]);
+        }
+    }
+
+    EXPECT_THROW(TensorMath::Reduce(ReduceOp::SUM, 1, l_mat, l_colOut), std::runtime_error);
+    EXPECT_THROW(TensorMath::Reduce(ReduceOp::SUM, 2, l_mat, l_rowOut), std::runtime_error);
+    EXPECT_THROW(TensorMath::ArgMax(0, Tensor::New({2, 2, 2}), l_colIdxs), std::runtime_error);
+}
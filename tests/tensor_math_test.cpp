@@ -191,3 +191,49 @@ TEST(TensorMathTest, TestRemoveRow)
     EXPECT_EQ( 5.0, newMat->At({1,4}));
 }
 
+
+TEST(TensorMathTest, TestMatMulViews)
+{
+    // 3x2 matrix with an extra row we narrow away
+    TTensorPtr lhs = Tensor::New({4,2}, {
+        1.0, 2.0,
+        3.0, 4.0,
+        5.0, 6.0,
+        9.0, 9.0
+    });
+
+    TTensorPtr rhs = Tensor::New({3,2}, {
+        1.0, 0.0,
+        0.0, 1.0,
+        2.0, 1.0
+    });
+
+    // lhs[0:3]^T * rhs, both transpose and narrow are views
+    TensorView lhsT = TensorView(lhs).Narrow(0, 0, 3).Transpose();
+    TTensorPtr result = TensorMath::Multiply(lhsT, rhs);
+    EXPECT_EQ(2, result->Shape().at(0));
+    EXPECT_EQ(2, result->Shape().at(1));
+
+    /*
+    (0,0) = 1*1 + 3*0 + 5*2 = 11
+    (0,1) = 1*0 + 3*1 + 5*1 = 8
+    (1,0) = 2*1 + 4*0 + 6*2 = 14
+    (1,1) = 2*0 + 4*1 + 6*1 = 10
+    */
+    EXPECT_EQ(11.0, result->At({0,0}));
+    EXPECT_EQ(8.0,  result->At({0,1}));
+    EXPECT_EQ(14.0, result->At({1,0}));
+    EXPECT_EQ(10.0, result->At({1,1}));
+
+    // rhs * lhs[1:3]^T matches multiplying materialized copies
+    TensorView lhsRowsT = TensorView(lhs).Narrow(0, 1, 2).Transpose();
+    TTensorPtr viewResult = TensorMath::Multiply(rhs, lhsRowsT);
+    TTensorPtr copyResult = TensorMath::Multiply(rhs, lhsRowsT.ToTensor());
+    EXPECT_EQ(copyResult->Data(), viewResult->Data());
+
+    // a column has no unit stride once transposed twice over a narrow,
+    // it still multiplies correctly
+    TensorView col = TensorView(lhs).Narrow(1, 1, 1);
+    TTensorPtr colResult = TensorMath::Multiply(col.Transpose(), col);
+    EXPECT_EQ(2*2 + 4*4 + 6*6 + 9*9, colResult->At({0,0}));
+}
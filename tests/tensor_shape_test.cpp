@@ -0,0 +1,55 @@
+/*
+ * Tensor Shape test
+ *
+ */
+
+#include "neural/math/tensor_shape.h"
+
+#include <gtest/gtest.h>
+
+using namespace neural;
+using namespace std;
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(TensorShapeTest, TestConstruct)
+{
+    TensorShape l_empty;
+    EXPECT_EQ(0, l_empty.size());
+    EXPECT_TRUE(l_empty.empty());
+    EXPECT_EQ(1, l_empty.NumElements());
+
+    TensorShape l_shape = {4, 2, 3};
+    EXPECT_EQ(3, l_shape.size());
+    EXPECT_EQ(4, l_shape[0]);
+    EXPECT_EQ(2, l_shape.at(1));
+    EXPECT_EQ(24, l_shape.NumElements());
+
+    // from and back to a vector
+    vector<size_t> l_dims = {5, 6};
+    TensorShape l_fromVector(l_dims);
+    EXPECT_EQ(TensorShape({5, 6}), l_fromVector);
+    vector<size_t> l_back = l_fromVector;
+    EXPECT_EQ(l_dims, l_back);
+
+    // from a range, ie. dropping the first dimension
+    TensorShape l_tail(l_shape.begin() + 1, l_shape.end());
+    EXPECT_EQ(TensorShape({2, 3}), l_tail);
+    EXPECT_NE(l_shape, l_tail);
+}
+
+TEST(TensorShapeTest, TestBounds)
+{
+    TensorShape l_shape = {1, 2};
+    EXPECT_THROW(l_shape.at(2), std::out_of_range);
+
+    l_shape.at(1) = 7;
+    EXPECT_EQ(7, l_shape[1]);
+
+    // inline storage has a fixed capacity
+    TensorShape l_full;
+    for (size_t i = 0; i < TensorShape::MAX_RANK; ++i)
+    {
+        l_full.push_back(1);
+    }
+    EXPECT_THROW(l_full.push_back(1), std::runtime_error);
+}
@@ -0,0 +1,75 @@
+/*
+ * Fixed rank tensor test
+ *
+ */
+
+#include "neural/math/tensor_t.h"
+
+#include <gtest/gtest.h>
+
+using namespace neural;
+using namespace std;
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(TensorTTest, TestMatrixSharesTensor)
+{
+    TMutableTensorPtr t = Tensor::New({2,3}, {
+        0.0, 1.0, 2.0,
+        3.0, 4.0, 5.0
+    });
+
+    TMatrix l_mat(t);
+    EXPECT_EQ(2, l_mat.Dim(0));
+    EXPECT_EQ(3, l_mat.Dim(1));
+    EXPECT_EQ(3, l_mat.Strides()[0]);
+    EXPECT_EQ(6, l_mat.Size());
+    EXPECT_EQ(t->Data().data(), l_mat.Data());
+    EXPECT_EQ(t, l_mat.Ptr());
+
+    EXPECT_EQ(1.0, l_mat(0, 1));
+    EXPECT_EQ(5.0, l_mat(1, 2));
+    EXPECT_EQ(4.0, l_mat.Row(1)[1]);
+
+    // writes through a mutable handle land in the tensor
+    TMutableMatrix l_mutable(t);
+    l_mutable(1, 0) = -3.0;
+    l_mutable.Row(0)[0] = 9.0;
+    EXPECT_EQ(-3.0, t->At({1, 0}));
+    EXPECT_EQ(9.0, l_mat(0, 0));
+}
+
+TEST(TensorTTest, TestRankIsChecked)
+{
+    EXPECT_THROW(TMatrix(Tensor::New({2, 3, 4})), runtime_error);
+    EXPECT_THROW(TMatrix(Tensor::New({6})), runtime_error);
+
+    // any rank works with a matching handle
+    TensorT<3> l_cube(Tensor::New({2, 3, 4}));
+    EXPECT_EQ(12, l_cube.Strides()[0]);
+    EXPECT_EQ(4, l_cube.Strides()[1]);
+    EXPECT_EQ(1, l_cube.Strides()[2]);
+}
+
+TEST(TensorTTest, TestNew)
+{
+    TMutableMatrix l_mat = TMutableMatrix::New({{3, 2}});
+    EXPECT_EQ(3, l_mat.Ptr()->Shape().at(0));
+    EXPECT_EQ(2, l_mat.Ptr()->Shape().at(1));
+
+    for (size_t i = 0; i < l_mat.Dim(0); ++i)
+    {
+        for (size_t j = 0; j < l_mat.Dim(1); ++j)
+        {
+            EXPECT_EQ(0.0, l_mat(i, j));
+            l_mat(i, j) = (float)(i * 10 + j);
+        }
+    }
+
+    // hands back a regular tensor
+    TTensorPtr t = l_mat.Ptr();
+    EXPECT_EQ(21.0, t->At({2, 1}));
+
+    TensorT<1, float> l_vec = TensorT<1, float>::New({{4}});
+    l_vec(3) = 1.0;
+    EXPECT_EQ(1.0, l_vec.Ptr()->At({3}));
+}
@@ -4,6 +4,7 @@
  */
 
 #include "neural/math/tensor.h"
+#include "neural/math/tensor_view.h"
 
 #include <gtest/gtest.h>
 
@@ -44,7 +45,7 @@ TEST(TensorTest, TestConstructorData)
     EXPECT_EQ(2, l_shape.at(1));
     
     // Make sure data is valid
-    const vector<float>& l_data = t.Data();
+    const TTensorData& l_data = t.Data();
     EXPECT_EQ(4, l_data.size());
   
     EXPECT_EQ(1.0, l_data.at(0));
@@ -84,3 +85,110 @@ TEST(TensorTest, TestGetAtIdx)
     EXPECT_EQ(42.0, t.At({3, 1, 0, 0})); // image 3, row 1, col 0, channel, 0
 }
 
+
+TEST(TensorTest, TestUncheckedMatrixAccess)
+{
+    TMutableTensorPtr t = Tensor::New({2,3}, {
+        0.0, 1.0, 2.0,
+        3.0, 4.0, 5.0
+    });
+
+    EXPECT_EQ(1.0, t->At2(0, 1));
+    EXPECT_EQ(5.0, t->At2(1, 2));
+
+    t->SetAt2(1, 0, -3.0);
+    EXPECT_EQ(-3.0, t->At({1, 0}));
+
+    // rows are contiguous
+    const float* l_row = t->RowData(1);
+    EXPECT_EQ(-3.0, l_row[0]);
+    EXPECT_EQ(4.0, l_row[1]);
+    EXPECT_EQ(5.0, l_row[2]);
+
+    t->MutableRowData(0)[2] = 7.0;
+    EXPECT_EQ(7.0, t->At2(0, 2));
+
+#ifdef NEURAL_CHECK_BOUNDS
+    EXPECT_THROW(t->At2(2, 0), std::runtime_error);
+    EXPECT_THROW(t->RowData(2), std::runtime_error);
+#endif
+
+    // the checked accessors always check
+    EXPECT_THROW(t->At({2, 0}), std::runtime_error);
+    EXPECT_THROW(t->At({0, 0, 0}), std::runtime_error);
+}
+
+TEST(TensorTest, TestAdopt)
+{
+    TTensorData l_data = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+    const float* l_buffer = l_data.data();
+
+    TMutableTensorPtr t = Tensor::Adopt({2, 3}, std::move(l_data));
+    EXPECT_EQ(l_buffer, t->Data().data());
+    EXPECT_EQ(6.0, t->At({1, 2}));
+    EXPECT_EQ(3, t->Strides().at(0));
+
+    TTensorData l_short = {1.0, 2.0};
+    EXPECT_THROW(Tensor::Adopt({2, 3}, std::move(l_short)), std::runtime_error);
+}
+
+TEST(TensorTest, TestToMutableTakesOverTemporaries)
+{
+    TTensorPtr t = Tensor::Ones({2, 2});
+    const Tensor* l_object = t.get();
+
+    // another reference is still looking, so we get a copy
+    TTensorPtr l_other = t;
+    TMutableTensorPtr l_copy = Tensor::ToMutable(std::move(t));
+    EXPECT_NE(l_object, l_copy.get());
+    EXPECT_FALSE(t);
+
+    // last reference, the same tensor comes back
+    TMutableTensorPtr l_same = Tensor::ToMutable(std::move(l_other));
+    EXPECT_EQ(l_object, l_same.get());
+    EXPECT_EQ(1.0, l_same->At({1, 1}));
+}
+
+TEST(TensorTest, TestInPlaceOps)
+{
+    TMutableTensorPtr t = Tensor::New({2, 2}, {
+        -2.0, 0.0,
+        1.0, 3.0
+    });
+
+    t->Scale(2.0).Add(1.0);
+    EXPECT_EQ(vector<float>({-3.0, 1.0, 3.0, 7.0}),
+              vector<float>(t->Data().begin(), t->Data().end()));
+
+    t->Clamp(0.0, 5.0);
+    EXPECT_EQ(vector<float>({0.0, 1.0, 3.0, 5.0}),
+              vector<float>(t->Data().begin(), t->Data().end()));
+
+    // axpy with another tensor, and with a transposed view of it
+    TTensorPtr l_other = Tensor::New({2, 2}, {
+        1.0, 2.0,
+        3.0, 4.0
+    });
+    t->Add(l_other, -1.0);
+    EXPECT_EQ(vector<float>({-1.0, -1.0, 0.0, 1.0}),
+              vector<float>(t->Data().begin(), t->Data().end()));
+    t->Add(TensorView(l_other).Transpose());
+    EXPECT_EQ(vector<float>({0.0, 2.0, 2.0, 5.0}),
+              vector<float>(t->Data().begin(), t->Data().end()));
+
+    EXPECT_THROW(t->Add(Tensor::Ones({1, 4})), std::runtime_error);
+
+    t->Scale(0.0).Exp();
+    EXPECT_EQ(1.0, t->At({0, 0}));
+    EXPECT_EQ(1.0, t->At({1, 1}));
+}
+
+TEST(TensorTest, TestMaxIdxAllNegative)
+{
+    TTensorPtr t = Tensor::New({2, 3}, {-3.0, -0.5, -2.0,
+                                        -4.0, -0.5, -9.0});
+    // first of the two largest, not the 0.0 the search used to start from
+    EXPECT_EQ(1, t->MaxIdx());
+    EXPECT_EQ(-0.5, t->MaxVal());
+    EXPECT_THROW(Tensor::New({0})->MaxIdx(), std::runtime_error);
+}
@@ -0,0 +1,133 @@
+/*
+ * Tensor View test
+ *
+ */
+
+#include "neural/math/tensor_view.h"
+
+#include <gtest/gtest.h>
+
+using namespace neural;
+using namespace std;
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(TensorViewTest, TestRowSharesData)
+{
+    TMutableTensorPtr mat = Tensor::New({3,2}, {
+        1.0, 2.0,
+        3.0, 4.0,
+        5.0, 6.0
+    });
+
+    TensorView row = TensorView(mat).Row(1);
+    EXPECT_EQ(1, row.Shape().at(0));
+    EXPECT_EQ(2, row.Shape().at(1));
+    EXPECT_EQ(2, row.Offset());
+    EXPECT_TRUE(row.IsContiguous());
+
+    // no copy was made, so it points into the parent's buffer
+    EXPECT_EQ(mat->Data().data() + 2, row.Data());
+    EXPECT_EQ(3.0, row.At({0,0}));
+    EXPECT_EQ(4.0, row.At({0,1}));
+
+    mat->SetAt({1,1}, 7.0);
+    EXPECT_EQ(7.0, row.At({0,1}));
+
+    EXPECT_THROW(row.At({1,0}), runtime_error);
+    EXPECT_THROW(TensorView(mat).Row(3), runtime_error);
+}
+
+TEST(TensorViewTest, TestViewKeepsParentAlive)
+{
+    TensorView row = TensorView(Tensor::New({2,2}, {1.0, 2.0, 3.0, 4.0})).Row(1);
+    EXPECT_EQ(3.0, row.At({0,0}));
+    EXPECT_EQ(4.0, row.At({0,1}));
+}
+
+TEST(TensorViewTest, TestTranspose)
+{
+    TTensorPtr mat = Tensor::New({2,3}, {
+        5.0, 4.0, 3.0,
+        2.0, 1.0, 0.0
+    });
+
+    TensorView transpose = TensorView(mat).Transpose();
+    EXPECT_EQ(3, transpose.Shape().at(0));
+    EXPECT_EQ(2, transpose.Shape().at(1));
+    EXPECT_EQ(1, transpose.Strides().at(0));
+    EXPECT_EQ(3, transpose.Strides().at(1));
+    EXPECT_FALSE(transpose.IsContiguous());
+
+    EXPECT_EQ(5.0, transpose.At({0,0}));
+    EXPECT_EQ(2.0, transpose.At({0,1}));
+    EXPECT_EQ(4.0, transpose.At({1,0}));
+    EXPECT_EQ(0.0, transpose.At({2,1}));
+
+    // materializing matches the copying transpose
+    TTensorPtr copy = transpose.ToTensor();
+    EXPECT_EQ(TTensorData({5.0, 2.0, 4.0, 1.0, 3.0, 0.0}), copy->Data());
+
+    // row of a transpose is a column of the parent
+    TensorView col = transpose.Row(2);
+    EXPECT_EQ(3.0, col.At({0,0}));
+    EXPECT_EQ(0.0, col.At({0,1}));
+
+    EXPECT_THROW(TensorView(Tensor::New({2,2,2})).Transpose(), runtime_error);
+}
+
+TEST(TensorViewTest, TestSliceAndNarrow)
+{
+    // 2 images of 2x3
+    Tensor t({2,2,3}, {
+        0.0, 1.0, 2.0,
+        3.0, 4.0, 5.0,
+
+        6.0, 7.0, 8.0,
+        9.0, 10.0, 11.0
+    });
+
+    TensorView img = TensorView(t).Slice(1);
+    EXPECT_EQ(2, img.Shape().size());
+    EXPECT_EQ(6, img.Offset());
+    EXPECT_TRUE(img.IsContiguous());
+    EXPECT_EQ(10.0, img.At({1,1}));
+
+    // last two columns of the second image
+    TensorView cols = img.Narrow(1, 1, 2);
+    EXPECT_EQ(2, cols.Shape().at(0));
+    EXPECT_EQ(2, cols.Shape().at(1));
+    EXPECT_FALSE(cols.IsContiguous());
+    EXPECT_EQ(TTensorData({7.0, 8.0, 10.0, 11.0}), cols.ToTensor()->Data());
+
+    EXPECT_THROW(img.Narrow(1, 2, 2), runtime_error);
+    EXPECT_THROW(TensorView(t).Slice(2), runtime_error);
+}
+
+TEST(TensorViewTest, TestMaxIdx)
+{
+    // all negative, max is not 0.0
+    TTensorPtr mat = Tensor::New({2,3}, {
+        -3.0, -1.0, -2.0,
+        -5.0, -6.0, -4.0
+    });
+
+    EXPECT_EQ(1, TensorView(mat).Row(0).MaxIdx());
+    EXPECT_EQ(2, TensorView(mat).Row(1).MaxIdx());
+    EXPECT_EQ(-4.0, TensorView(mat).Row(1).MaxVal());
+
+    // row major order of the transpose
+    EXPECT_EQ(2, TensorView(mat).Transpose().MaxIdx());
+}
+
+TEST(TensorViewTest, TestSetRowFromView)
+{
+    TTensorPtr src = Tensor::New({2,2}, {
+        1.0, 2.0,
+        3.0, 4.0
+    });
+    TMutableTensorPtr dst = Tensor::Zeros({2,2});
+
+    dst->SetRow(0, TensorView(src).Row(1));
+    dst->SetRow(1, TensorView(src).Transpose().Row(0));
+    EXPECT_EQ(TTensorData({3.0, 4.0, 1.0, 3.0}), dst->Data());
+}
@@ -0,0 +1,154 @@
+/*
+ * Transposition Test
+ *
+ */
+
+#include "neural/math/transposition.h"
+#include "neural/math/elementwise.h"
+#include "neural/math/tensor_math.h"
+#include "isa_test_util.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace neural;
+using namespace std;
+
+namespace
+{
+
+// every value distinct, so a misplaced one always shows
+vector<float> Iota(size_t a_size)
+{
+    vector<float> l_values(a_size);
+    for (size_t i = 0; i < a_size; ++i)
+    {
+        l_values[i] = (float)i;
+    }
+    return l_values;
+}
+
+} // namespace
+
+// TEST(TestCaseName, IndividualTestName)
+TEST(TranspositionTest, TestMatrixOnEveryIsa)
+{
+    // partial blocks, partial tiles, and the 785x300 weights that go
+    // across threads
+    vector<pair<size_t, size_t> > l_shapes = {
+        {1, 1}, {1, 9}, {8, 8}, {7, 13}, {16, 24}, {65, 130}, {785, 300}, {100, 785}};
+
+    for (Elementwise::Isa l_isa : SupportedIsas())
+    {
+        ScopedIsa l_scopedIsa(l_isa);
+        for (const pair<size_t, size_t>& l_shape : l_shapes)
+        {
+            size_t l_rows = l_shape.first;
+            size_t l_cols = l_shape.second;
+            vector<float> l_in = Iota(l_rows * l_cols);
+            vector<float> l_out(l_rows * l_cols, -1.0);
+
+            Transposition::Matrix(l_in.data(), l_rows, l_cols, l_out.data());
+            for (size_t i = 0; i < l_rows; ++i)
+            {
+                for (size_t j = 0; j < l_cols; ++j)
+                {
+                    ASSERT_EQ(l_in[(i * l_cols) + j], l_out[(j * l_rows) + i])
+                        << Elementwise::IsaName(l_isa) << " " << l_rows << "x" << l_cols;
+                }
+            }
+        }
+
+        // the top left 9x10 of a 12x20, into the middle of a wider output
+        vector<float> l_in = Iota(12 * 20);
+        vector<float> l_out(10 * 16, -1.0);
+        Transposition::Matrix(l_in.data(), 9, 10, 20, l_out.data() + 2, 16);
+        for (size_t i = 0; i < 10; ++i)
+        {
+            for (size_t j = 0; j < 16; ++j)
+            {
+                float l_expected = (j >= 2 && j < 11) ? l_in[((j - 2) * 20) + i] : -1.0;
+                EXPECT_EQ(l_expected, l_out[(i * 16) + j]) << Elementwise::IsaName(l_isa);
+            }
+        }
+    }
+}
+
+TEST(TranspositionTest, TestInPlaceOnEveryIsa)
+{
+    for (Elementwise::Isa l_isa : SupportedIsas())
+    {
+        ScopedIsa l_scopedIsa(l_isa);
+        for (size_t l_size : {1, 3, 8, 9, 64, 71, 300})
+        {
+            vector<float> l_mat = Iota(l_size * l_size);
+            Transposition::InPlace(l_mat.data(), l_size, l_size);
+            for (size_t i = 0; i < l_size; ++i)
+            {
+                for (size_t j = 0; j < l_size; ++j)
+                {
+                    ASSERT_EQ((float)((j * l_size) + i), l_mat[(i * l_size) + j])
+                        << Elementwise::IsaName(l_isa) << " " << l_size;
+                }
+            }
+        }
+    }
+
+    TMutableTensorPtr l_mat = Tensor::New({2, 2}, {1.0, 2.0, 3.0, 4.0});
+    TensorMath::TransposeInPlace(l_mat);
+    EXPECT_EQ(vector<float>({1.0, 3.0, 2.0, 4.0}),
+              vector<float>(l_mat->Data().begin(), l_mat->Data().end()));
+    EXPECT_THROW(TensorMath::TransposeInPlace(Tensor::New({2, 3})), std::runtime_error);
+}
+
+TEST(TranspositionTest, TestPermute)
+{
+    // NCHW to NHWC, a batch of matrix transposes once H and W merge
+    size_t n = 2, c = 3, h = 5, w = 7;
+    TTensorPtr l_nchw = Tensor::New({n, c, h, w}, Iota(n * c * h * w));
+    TTensorPtr l_nhwc = TensorMath::Permute(l_nchw, {0, 2, 3, 1});
+    EXPECT_EQ(TensorShape({n, h, w, c}), l_nhwc->Shape());
+
+    // reversed, neither of the last two dimensions has a unit stride
+    TTensorPtr l_whcn = TensorMath::Permute(l_nchw, {3, 2, 1, 0});
+    EXPECT_EQ(TensorShape({w, h, c, n}), l_whcn->Shape());
+
+    for (size_t a = 0; a < n; ++a)
+    {
+        for (size_t b = 0; b < c; ++b)
+        {
+            for (size_t y = 0; y < h; ++y)
+            {
+                for (size_t x = 0; x < w; ++x)
+                {
+                    float l_expected = l_nchw->At({a, b, y, x});
+                    EXPECT_EQ(l_expected, l_nhwc->At({a, y, x, b}));
+                    EXPECT_EQ(l_expected, l_whcn->At({x, y, b, a}));
+                }
+            }
+        }
+    }
+
+    // the identity is a plain copy
+    TTensorPtr l_same = TensorMath::Permute(l_nchw, {0, 1, 2, 3});
+    EXPECT_EQ(l_nchw->Data(), l_same->Data());
+
+    // a narrowed then transposed view copies out the same as At reads it
+    TTensorPtr l_mat = Tensor::New({20, 30}, Iota(600));
+    TensorView l_view = TensorView(l_mat).Narrow(1, 3, 17).Transpose();
+    TTensorPtr l_copy = l_view.ToTensor();
+    for (size_t i = 0; i < 17; ++i)
+    {
+        for (size_t j = 0; j < 20; ++j)
+        {
+            EXPECT_EQ(l_view.At({i, j}), l_copy->At({i, j}));
+        }
+    }
+
+    EXPECT_THROW(TensorMath::Permute(l_nchw, {0, 1, 2}), std::runtime_error);
+    EXPECT_THROW(TensorMath::Permute(l_nchw, {0, 1, 1, 2}), std::runtime_error);
+    EXPECT_THROW(TensorMath::Permute(l_nchw, {0, 1, 2, 4}), std::runtime_error);
+}
@@ -0,0 +1,180 @@
+/*
+ * Tool calculating precision recall curves, confusion matrices and
+ * area under curve from a prediction log, without running the model
+ *
+ * usage: evaluate_prediction_log <prediction log>
+ */
+
+
+#include "neural/data/prediction_log.h"
+#include "neural/metrics/precision_recall_curve.h"
+#include "neural/metrics/area_under_curve.h"
+#include "neural/metrics/confusion_matrix.h"
+#include "neural/metrics/record_accumulator.h"
+
+#include <glog/logging.h>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+using namespace neural;
+using namespace std;
+
+// rows per unit of parallel work, small enough to balance threads and
+// big enough to keep the reduced records in cache
+const size_t CHUNK_ROWS = 65536;
+
+// Exceptions cannot leave a parallel region, the first one thrown in
+// it is kept here and rethrown once it is over
+void KeepFirstError(exception_ptr& a_error)
+{
+    #pragma omp critical(neural_first_error)
+    if (!a_error)
+    {
+        a_error = current_exception();
+    }
+}
+
+// Logs every metric of the log at `a_path`, throws if it cannot be read
+void Evaluate(const char* a_path)
+{
+    PredictionLog l_log(a_path);
+    LOG(INFO) << "Scanning " << l_log.NumRows() << " predictions of "
+              << l_log.NumCols() << " classes from " << a_path << endl;
+
+    metrics::TRecordAccumulatorPtr l_records = metrics::RecordAccumulator::New();
+    metrics::ConfusionMatrix l_confusionMatrix(l_log.NumCols());
+
+    chrono::steady_clock::time_point l_start = chrono::steady_clock::now();
+
+    // every thread reduces chunks into its own accumulators, then they
+    // are merged once at the end
+    exception_ptr l_error;
+    int l_numChunks = static_cast<int>((l_log.NumRows() + CHUNK_ROWS - 1) / CHUNK_ROWS);
+    #pragma omp parallel
+    {
+        metrics::TRecordAccumulatorPtr l_threadRecords;
+        shared_ptr<metrics::ConfusionMatrix> l_threadConfusionMatrix;
+        vector<metrics::PredictionRecord> l_chunkRecords;
+        try
+        {
+            l_threadRecords = metrics::RecordAccumulator::New();
+            l_threadConfusionMatrix = make_shared<metrics::ConfusionMatrix>(l_log.NumCols());
+        }
+        catch (...)
+        {
+            KeepFirstError(l_error);
+        }
+
+        // every thread has to reach the loop, even one that failed above
+        #pragma omp for schedule(dynamic)
+        for (int i = 0; i < l_numChunks; ++i)
+        {
+            if (!l_threadConfusionMatrix)
+            {
+                continue;
+            }
+
+            try
+            {
+                size_t l_begin = i * CHUNK_ROWS;
+                size_t l_end = min(l_begin + CHUNK_ROWS, l_log.NumRows());
+                l_log.ReduceRows(l_begin, l_end, l_chunkRecords);
+                l_threadRecords->Add(l_chunkRecords.data(), l_chunkRecords.size());
+                l_threadConfusionMatrix->Add(l_chunkRecords.data(), l_chunkRecords.size());
+            }
+            catch (...)
+            {
+                KeepFirstError(l_error);
+            }
+        }
+
+        if (l_threadConfusionMatrix)
+        {
+            #pragma omp critical
+            {
+                try
+                {
+                    l_records->Merge(*l_threadRecords);
+                    l_confusionMatrix.Merge(*l_threadConfusionMatrix);
+                }
+                catch (...)
+                {
+                    KeepFirstError(l_error);
+                }
+            }
+        }
+    }
+
+    if (l_error)
+    {
+        rethrow_exception(l_error);
+    }
+
+    double l_seconds = chrono::duration<double>(chrono::steady_clock::now() - l_start).count();
+    LOG(INFO) << "Scanned " << l_log.NumBytes() / 1e6 << "MB in " << l_seconds << "s ("
+              << (l_log.NumBytes() / 1e9) / l_seconds << "GB/s)" << endl;
+
+    // Full precision recall curve, one point per distinct confidence
+    metrics::PrecisionRecallCurve l_curve(l_records);
+    vector<metrics::CurvePoint> l_points = l_curve.Points();
+    for (const auto& point : l_points)
+    {
+        LOG(INFO) << "precision @" << point.threshold << " = " << point.precision * 100.0
+                  << "% recall = " << point.recall * 100.0 << "%" << endl;
+    }
+
+    metrics::CurvePoint l_bestF1;
+    if (l_curve.MaxFBetaThreshold(1.0, l_bestF1))
+    {
+        LOG(INFO) << "best f1 @" << l_bestF1.threshold
+                  << " precision = " << l_bestF1.precision * 100.0 << "%"
+                  << " recall = " << l_bestF1.recall * 100.0 << "%" << endl;
+    }
+
+    metrics::AreaUnderCurve l_areaUnderCurve(l_records);
+    LOG(INFO) << "roc auc = " << l_areaUnderCurve.RocAuc() << endl;
+    LOG(INFO) << "average precision = " << l_areaUnderCurve.AveragePrecision() * 100.0 << "%" << endl;
+
+    // Rows are targets, columns are predictions
+    for (size_t i = 0; i < l_confusionMatrix.NumClasses(); ++i)
+    {
+        stringstream l_row;
+        for (size_t j = 0; j < l_confusionMatrix.NumClasses(); ++j)
+        {
+            l_row << setw(8) << l_confusionMatrix.Count(i, j);
+        }
+        LOG(INFO) << "class " << i << l_row.str()
+                  << "  precision = " << l_confusionMatrix.Precision(i) * 100.0 << "%"
+                  << " recall = " << l_confusionMatrix.Recall(i) * 100.0 << "%" << endl;
+    }
+    LOG(INFO) << "macro f1 = " << l_confusionMatrix.MacroF1() * 100.0 << "%" << endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc != 2)
+    {
+        LOG(ERROR) << "usage: " << argv[0] << " <prediction log>" << endl;
+        return 1;
+    }
+
+    try
+    {
+        Evaluate(argv[1]);
+    }
+    catch (const exception& l_e)
+    {
+        LOG(ERROR) << "Could not evaluate " << argv[1] << ": " << l_e.what() << endl;
+        return 1;
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "Could not evaluate " << argv[1] << endl;
+        return 1;
+    }
+
+    return 0;
+}
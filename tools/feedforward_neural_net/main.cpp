@@ -5,14 +5,18 @@
 
 
 #include "neural/data/mnist_dataloader.h"
+#include "neural/data/prediction_log.h"
+#include "neural/math/tensor_view.h"
+#include "neural/util/arena.h"
 #include "neural/layers/linear_layer.h"
 #include "neural/layers/relu_layer.h"
 #include "neural/layers/softmax_layer.h"
 #include "neural/loss/cross_entropy_loss.h"
 #include "neural/loss/mean_squared_error_loss.h"
-#include "neural/metrics/precision.h"
-#include "neural/metrics/recall.h"
+#include "neural/metrics/precision_recall_curve.h"
+#include "neural/metrics/area_under_curve.h"
 #include "neural/metrics/accuracy.h"
+#include "neural/metrics/confusion_matrix.h"
 
 #include <glog/logging.h>
 #include <map>
@@ -41,15 +45,22 @@ void RunOnTestSet(
     vector<float> a_confidenceCutoffs)
 {
     LOG(INFO) << "Processing Test Set..." << endl;
-    // instantiate the metrics we want to see
-    vector<shared_ptr<metrics::Metric>> l_metrics = {
-        shared_ptr<metrics::Metric>(new metrics::Precision()),
-        shared_ptr<metrics::Metric>(new metrics::Recall())
-    };
+    // one curve gives us precision and recall at every cutoff, and the
+    // area under it reads from the same records
+    metrics::TRecordAccumulatorPtr l_records = metrics::RecordAccumulator::New();
+    metrics::PrecisionRecallCurve l_curve(l_records);
+    metrics::AreaUnderCurve l_areaUnderCurve(l_records);
+    // and the confusion matrix tells us which digits are failing
+    metrics::ConfusionMatrix l_confusionMatrix(10);
+    // keep the raw predictions so evaluate_prediction_log can look again
+    PredictionLogWriter l_predictionLog("test_predictions.log", 10);
 
     size_t totalIters = a_testDataloader.GetNumBatches(a_batchSize);
     for (size_t i = 0; i < totalIters; ++i)
     {
+        // every tensor below is freed at once at the end of the batch
+        ArenaScope l_scope;
+
         TMutableTensorPtr l_inputs, l_targets;
         a_testDataloader.GetNextBatch(l_inputs, l_targets, a_batchSize);
 
@@ -60,21 +71,40 @@ void RunOnTestSet(
         TTensorPtr l_probs = a_sofmaxLayer.Forward(l_output2);
 
         // Accumulate metrics
-        for (auto& metric : l_metrics) {
-            metric->AddResults(l_probs, l_targets);
-        }
+        l_curve.AddResults(l_probs, l_targets);
+        l_confusionMatrix.AddResults(l_probs, l_targets);
+        l_predictionLog.Append(l_probs, l_targets);
     }
 
     // Print precision recall curve for test set
-    for (int i = 0; i < a_confidenceCutoffs.size(); ++i)
+    vector<metrics::CurvePoint> l_points = l_curve.Points(a_confidenceCutoffs);
+    for (const auto& point : l_points)
     {
-        for (const auto& metric : l_metrics) {
-            float val = metric->Calculate(a_confidenceCutoffs.at(i)) * 100.0;
-            LOG(INFO) << "Test " << metric->GetName() << " @" 
-                      << a_confidenceCutoffs.at(i) << " = "
-                      << val << "%" << endl;
-        }
+        LOG(INFO) << "Test precision @" << point.threshold << " = "
+                  << point.precision * 100.0 << "%" << endl;
+        LOG(INFO) << "Test recall @" << point.threshold << " = "
+                  << point.recall * 100.0 << "%" << endl;
+    }
+
+    // operating point for serving, most recall at high precision
+    metrics::CurvePoint l_servingPoint;
+    if (l_curve.ThresholdAtPrecision(0.99, l_servingPoint))
+    {
+        LOG(INFO) << "Test recall @" << l_servingPoint.threshold << " = "
+                  << l_servingPoint.recall * 100.0 << "% at >= 99% precision" << endl;
     }
+
+    LOG(INFO) << "Test roc auc = " << l_areaUnderCurve.RocAuc() << endl;
+    LOG(INFO) << "Test average precision = "
+              << l_areaUnderCurve.AveragePrecision() * 100.0 << "%" << endl;
+
+    for (size_t i = 0; i < l_confusionMatrix.NumClasses(); ++i)
+    {
+        LOG(INFO) << "Test class " << i
+                  << " precision = " << l_confusionMatrix.Precision(i) * 100.0 << "%"
+                  << " recall = " << l_confusionMatrix.Recall(i) * 100.0 << "%" << endl;
+    }
+    LOG(INFO) << "Test macro f1 = " << l_confusionMatrix.MacroF1() * 100.0 << "%" << endl;
 }
 
 int main(int argc, char const *argv[])
@@ -113,9 +143,15 @@ int main(int argc, char const *argv[])
     {
         LOG(INFO) << "====== BEGIN EPOCH " << i << " ======" << endl;
         metrics::Accuracy l_accuracyMetric;
+        // accuracy over the last 100 batches, cheap to read every iteration
+        metrics::Accuracy l_liveAccuracyMetric(100 * batchSize);
         vector<float> errorAcc;
         for (size_t j = 0; j < totalIters; ++j)
         {
+            // Inputs, activations and gradients only live this iteration,
+            // weights were allocated outside and are updated in place
+            ArenaScope l_scope;
+
             // Get training example
             TMutableTensorPtr input, target;
             l_trainDataloader.GetNextBatch(input, target, batchSize);
@@ -128,6 +164,7 @@ int main(int argc, char const *argv[])
 
             // Accumulate accuracy
             l_accuracyMetric.AddResults(probs, target);
+            l_liveAccuracyMetric.AddResults(probs, target);
 
             // Calc Error
             float error = loss.Forward(probs, target);
@@ -149,7 +186,7 @@ int main(int argc, char const *argv[])
             if (j % 100 == 0)
             {
                 float avgError = CalcAverage(errorAcc);
-                float accuracy = l_accuracyMetric.Calculate() * 100;
+                float accuracy = l_liveAccuracyMetric.Calculate() * 100;
                 LOG(INFO) << "--ITER (" << i << "," << j << "/" << totalIters 
                           << ")-- avgError = " << avgError 
                           << " avgAcc = " << accuracy 
@@ -159,8 +196,8 @@ int main(int argc, char const *argv[])
                     LOG(INFO) << "Output [" << k << "] " << probs->At({0, k}) << " Target " << target->At({0, k}) << endl;
                 }
 
-                size_t targetVal = target->GetRow(0)->MaxIdx();
-                size_t predVal = probs->GetRow(0)->MaxIdx();
+                size_t targetVal = TensorView(target).Row(0).MaxIdx();
+                size_t predVal = TensorView(probs).Row(0).MaxIdx();
 
                 LOG(INFO) << "Got prediction: " << predVal << " for target " << targetVal << endl;
             }